@@ -4,13 +4,16 @@ uniform mat4 ModelViewMatrix;
 uniform mat4 ProjectionMatrix;
 //uniform mat3 NormalMatrix;
 
-in  vec3 in_Position;  // Position coming in
+in  vec3 in_Position;  // Position coming in, shorts in the bounds of the tube or floats
 in  vec3 in_Color;     // colour coming in
 out vec3 ex_Color;     // colour leaving the vertex, this will be sent to the fragment shader
 
+uniform vec3 PositionScale;		// turn in_Position into the position in the tube
+uniform vec3 PositionOffset;
+
 void main(void)
 {
-	gl_Position = ProjectionMatrix * ModelViewMatrix * vec4(in_Position, 1.0);
+	gl_Position = ProjectionMatrix * ModelViewMatrix * vec4(in_Position * PositionScale + PositionOffset, 1.0);
 	
 	ex_Color = in_Color;
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#version 150
+
+// basicTransformations.vert for models drawn many times in one call, each copy moved by its own world offset
+
+uniform mat4 ModelViewMatrix;	// the viewing matrix, the offsets are in world space
+uniform mat4 ProjectionMatrix;
+uniform mat3 NormalMatrix;
+uniform mat4 ViewMatrix;
+
+in  vec3 in_Position;  // Position coming in, shorts in the bounds of the model or floats
+in  vec2 in_TexCoord;  // texture coordinate coming in
+in  vec2 in_Normal;    // vertex normal used for lighting, octahedral
+in  vec3 in_Offset;    // world position of the instance
+
+uniform vec3 PositionScale;		// turn in_Position into the position in the model
+uniform vec3 PositionOffset;
+
+uniform vec4 LightPos;  // light position
+
+out vec2 ex_TexCoord;  // exiting texture coord
+out vec3 ex_Normal;    // exiting normal transformed by the normal matrix
+out vec3 ex_PositionEye; 
+out vec3 ex_LightDir; 
+
+// the normal packed by VertexPacking::packOctahedral, two shorts of the octahedral map
+vec3 octahedralDecode(vec2 packed)
+{
+	vec2 e = max(packed / 32767.0, -1.0);
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+void main(void)
+{
+	vec3 modelPosition = in_Position * PositionScale + PositionOffset;
+	vec3 modelNormal = octahedralDecode(in_Normal);
+
+	vec4 position = ModelViewMatrix * vec4(modelPosition + in_Offset, 1.0);
+
+	gl_Position = ProjectionMatrix * position;
+	
+	ex_TexCoord = in_TexCoord;
+		
+	ex_Normal = NormalMatrix*modelNormal; 
+
+	ex_PositionEye = vec3(position);
+
+	ex_LightDir = vec3(ViewMatrix * LightPos);
+}
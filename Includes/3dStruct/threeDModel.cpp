@@ -2,13 +2,20 @@
 #include "threeDModel.h"
 //#include <gl/glext.h>
 #include <math.h>
+#include <algorithm>
 #include "../texturehandler/texturehandler.h"
-#include "../Octree/Octree.h"
+#include "../Octree/LinearOctree.h"
 #include "../Utilities/IntersectionTests.h"
+#include "../Utilities/ParallelFor.h"
+#include "../Utilities/MeshOptimizer.h"
 #include "../shaders/Shader.h"
 
 //extern PFNGLDRAWRANGEELEMENTSPROC glDrawRangeElements;
 
+const float ThreeDModel::MAX_POSITION_ERROR = 0.001f;
+// above 1% the clusters get small enough that the vertices they share are read from the buffer again and again
+const float ThreeDModel::OVERDRAW_THRESHOLD = 1.01f;
+
 ThreeDModel::ThreeDModel()
 {
 	fileName = "";
@@ -25,6 +32,7 @@ ThreeDModel::ThreeDModel()
 	numberOfTexCoords =  0;
 	numberOfMatrials = 0;
 	numberOfVertNormals = 0;
+	numberOfDrawVertices = 0;
 
 	octree = NULL;
 
@@ -73,134 +81,61 @@ ThreeDModel::~ThreeDModel()
 
 	startPoints.clear();
 	length.clear();	
-}
+	baseVertices.clear();
+	indexTypes.clear();
 
+	delete octree;
+	octree = NULL;
+}
 
-ThreeDModel::ThreeDModel(const ThreeDModel& p)
+void ThreeDModel::constructOctree()
 {
-	*this = p;
-} 
+	delete octree;
 
-//Make an assignment opperator
-void ThreeDModel::operator=(const ThreeDModel &p)
-{	
-	fileName = p.fileName;
-	numberOfVertices = p.numberOfVertices; 
-	numberOfFaceNormals = p.numberOfFaceNormals;   
-	numberOfTriangles = p.numberOfTriangles;
-	numberOfTexCoords = p.numberOfTexCoords;
-	numberOfMatrials = p.numberOfMatrials;
-	numberOfVertNormals = p.numberOfVertNormals;
-
-	theBBox = p.theBBox;
-
-	if(p.theVerts != NULL)
-	{
-		theVerts = new Vector3d[numberOfVertices];
-		theFaceNormals = new Vector3d[numberOfFaceNormals];
-		theTexCoords = new Vector2d[numberOfTexCoords];
-		theFaces = new aFace[numberOfTriangles];
-		theMaterials = new aMaterial[numberOfMatrials];
-		theVertNormals = new Vector3d[numberOfVertNormals];
-
-		//Copy over Data
-		memcpy(theVerts, p.theVerts, sizeof(Vector3d) * numberOfVertices);
-		memcpy(theFaceNormals, p.theFaceNormals, sizeof(Vector3d) * numberOfFaceNormals);
-		memcpy(theTexCoords, p.theTexCoords, sizeof(Vector2d) * numberOfTexCoords);
-		memcpy(theFaces,p.theFaces, sizeof(aFace) * numberOfTriangles);
-		memcpy(theMaterials, p.theMaterials, sizeof(aMaterial) * numberOfMatrials);
-		memcpy(theVertNormals, p.theVertNormals, sizeof(Vector3d) * numberOfVertNormals);
-	}
-	else
-	{
-		theVerts = NULL;
-		theFaceNormals = NULL;
-		theTexCoords = NULL;
-		theFaces = NULL;
-		theMaterials = NULL;
-		theVertNormals = NULL;
-	}
+	octree = new LinearOctree();
+	octree->build(*this);
+	octree->printStatistics();
+}
 
-	indexArray = NULL;
-	length.clear();
-	for(unsigned int i=0;i<p.length.size();i++)
+bool ThreeDModel::loadBakedOctree(const char* path)
+{
+	LinearOctree* baked = new LinearOctree();
+	if (!baked->load(path, *this))
 	{
-		length.push_back(p.length[i]);
+		delete baked;
+		return false;
 	}
 
-	if(p.vertexPositionList != NULL)
-	{
-		vertexPositionList = new GLfloat[numberOfTriangles*3*3];
-		vertexNormalList = new GLfloat[numberOfTriangles*3*3];
-		vertexTexCoordList = new GLfloat[numberOfTriangles*3*2];
-		faceIDsList=new GLuint[numberOfTriangles*3];
+	delete octree;
+	octree = baked;
 
-		memcpy(vertexPositionList,p.vertexPositionList,sizeof(GLfloat)*numberOfTriangles*3*3);
-		memcpy(vertexNormalList,p.vertexNormalList,sizeof(GLfloat)*numberOfTriangles*3*3);
-		memcpy(vertexTexCoordList,p.vertexTexCoordList,sizeof(GLfloat)*numberOfTriangles*3*2);
-		memcpy(faceIDsList,p.faceIDsList,sizeof(GLuint)*numberOfTriangles*3);
-	}
-	else
-	{
-		vertexPositionList = NULL;
-		vertexNormalList = NULL;
-		vertexTexCoordList = NULL;
-		faceIDsList = NULL;
-	}
+	delete [] theVertNormals;
+	theVertNormals = new Vector3d[numberOfVertices];
+	numberOfVertNormals = numberOfVertices;
 
-	if(p.vertexColorList != NULL)
-	{
-		std::cout << " set up color " << std::endl;
-		vertexColorList = new GLfloat[numberOfTriangles*3*3];
-		memcpy(vertexColorList,p.vertexColorList,sizeof(GLfloat)*numberOfTriangles*3*3);
-	}
-	else
+	const float* normals = octree->getMeshNormals();
+	for (int v = 0; v < numberOfVertices; v++)
 	{
-		vertexColorList = NULL;
+		theVertNormals[v] = Vector3d(normals[3 * v], normals[3 * v + 1], normals[3 * v + 2]);
 	}
 
-	glBuffer = NULL;
+	return true;
 }
 
-void ThreeDModel::constructOctree()
+bool ThreeDModel::bakeOctree(const char* path)
 {
-	double minX,minY,minZ,maxX,maxY,maxZ;
-	calcBoundingBox(minX, minY, minZ, maxX, maxY, maxZ);
-	//cout << minX << " " << minY << " " << minZ << endl;
-	//cout << maxX << " " << maxY << " " << maxZ << endl;
-
-	octree = new Octree();
-	octree->start(0, minX, minY, minZ, maxX, maxY, maxZ, this);
-
-	vector<Octree*> stackOctree;
-	stackOctree.push_back(octree);
-
-	while(stackOctree.size() > 0)
-	{
-		Octree* oct = stackOctree[0];
-		oct->CreateChildren(stackOctree, this);
-
-		stackOctree.erase(stackOctree.begin());
-	}
+	return octree != NULL && octree->save(path, *this);
 }
 
 void ThreeDModel::calcVertNormalsUsingOctree()
 {
-	if(theVertNormals != NULL) //delete any previously created vertex normals
-	{
-		delete [] theVertNormals;
-	}
-	
 	if(octree == NULL) // construct the octree if it hasn't been created.
 	{
 		constructOctree();
 	}
 
-	theVertNormals = new Vector3d[numberOfVertices];
-	numberOfVertNormals = numberOfVertices;
-
-	//calculate the vertex normals using the octree
-	octree->processVerticesByLeaf(this);
+	//the faces of a vertex are in the leaves that hold it, so the normals are those of every face, taken in one pass
+	calcVertNormals();
 }
 
 void ThreeDModel::drawBoundingBox(Shader* myShader)
@@ -233,7 +168,7 @@ void ThreeDModel::calcCentrePoint()
 
 		//for all the verticies (can ignore everthing else)
 
-		for (int count = 0; count < numberOfTriangles*3*3; count+=3)
+		for (int count = 0; count < numberOfDrawVertices*3; count+=3)
 		{
 			//if ((theVerts[count].x > -1000) && (theVerts[count].y > -1000) && (theVerts[count].z > -1000))
 			{
@@ -385,7 +320,11 @@ void ThreeDModel::calcFaceNormals()
 
 bool ThreeDModel::collisionBetweenPoint(Vector3d* v, float threshold)
 {
-	if (theVerts == NULL)
+	if (octree != NULL)
+	{
+		return octree->pointCollision(glm::vec3(v->x, v->y, v->z), threshold);
+	}
+	else if (theVerts == NULL)
 	{
 		cout << "NO VERTS" << endl;
 		return false;
@@ -448,53 +387,91 @@ void ThreeDModel::calcFakeVertNormals()
 		theVertNormals = new Vector3d[numberOfVertices];
 		numberOfVertNormals = numberOfVertices;
 
+		std::vector<int> cornerStart, corners;
+		vertexCorners(cornerStart, corners);
+
+		//the normal of the first face of each vertex
 		for (int count = 0; count < numberOfVertNormals; count ++)
 		{
-			for (int count2 = 0; count2 < numberOfTriangles; count2++)
+			if (cornerStart[count] < cornerStart[count + 1])
 			{
-				if (count == theFaces[count2].thePoints[0] ||
-					count == theFaces[count2].thePoints[1] ||
-					count == theFaces[count2].thePoints[2])
-				{
-					theVertNormals[count] = theFaceNormals[theFaces[count2].theFaceNormal];
-					break;
-				}
+				theVertNormals[count] = theFaceNormals[theFaces[corners[cornerStart[count]] / 3].theFaceNormal];
 			}
 		}
 	}
 }
 
-void ThreeDModel::calcVertNormals()
+void ThreeDModel::vertexCorners(std::vector<int>& cornerStart, std::vector<int>& corners) const
+{
+	cornerStart.assign(numberOfVertices + 1, 0);
+	for (int face = 0; face < numberOfTriangles; face++)
+	{
+		for (int k = 0; k < 3; k++)
+			cornerStart[theFaces[face].thePoints[k] + 1]++;
+	}
+
+	for (int v = 0; v < numberOfVertices; v++)
+		cornerStart[v + 1] += cornerStart[v];
+
+	//filled in face order, so each vertex adds its faces in the order the quadratic loops did
+	std::vector<int> fill(cornerStart.begin(), cornerStart.end() - 1);
+	corners.resize(3 * numberOfTriangles);
+	for (int face = 0; face < numberOfTriangles; face++)
+	{
+		for (int k = 0; k < 3; k++)
+			corners[fill[theFaces[face].thePoints[k]]++] = 3 * face + k;
+	}
+}
+
+Vector3d ThreeDModel::cornerNormal(int corner, NormalWeighting weighting) const
+{
+	const aFace& face = theFaces[corner / 3];
+	Vector3d faceNormal = theFaceNormals[face.theFaceNormal];
+
+	if (weighting == WEIGHT_UNIFORM)
+		return faceNormal;
+
+	if (weighting == WEIGHT_AREA)
+	{
+		//twice the area in the direction of calcFaceNormals
+		Vector3d v0 = theVerts[face.thePoints[0]];
+		return (v0 - theVerts[face.thePoints[1]]) * (v0 - theVerts[face.thePoints[2]]);
+	}
+
+	//the angle of the face at the vertex
+	Vector3d a = theVerts[face.thePoints[corner % 3]];
+	Vector3d b = theVerts[face.thePoints[(corner + 1) % 3]];
+	Vector3d c = theVerts[face.thePoints[(corner + 2) % 3]];
+	Vector3d toB = Vector3d::normalize(b - a);
+	Vector3d toC = Vector3d::normalize(c - a);
+	float cosine = Vector3d::dotProduct(toB, toC);
+	cosine = cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine);
+
+	return faceNormal * acos(cosine);
+}
+
+void ThreeDModel::calcVertNormals(NormalWeighting weighting)
 {
 	if(theVerts != NULL)
 	{
-		Vector3d * newNormals = new Vector3d[numberOfVertices];
+		std::vector<int> cornerStart, corners;
+		vertexCorners(cornerStart, corners);
+
+		if (theVertNormals) delete [] theVertNormals;
+		theVertNormals = new Vector3d[numberOfVertices];
+		numberOfVertNormals = numberOfVertices;
 
-		for (int i = 0; i < numberOfVertices; i++) //For all the verts
+		//each vertex gathers its own faces, so the threads never write to the same normal
+		ParallelFor::run(0, numberOfVertices, [&](int i)
 		{
 			Vector3d theNormal(0,0,0);
-			for (int j = 0; j < numberOfTriangles; j++)		 //GO through all the faces
+			for (int c = cornerStart[i]; c < cornerStart[i + 1]; c++)
 			{
-				for (int k = 0; k < 3; k++)
-				{
-					if (theFaces[j].thePoints[k] == i) //if index equals current index
-					{	
-						theNormal = theNormal + theFaceNormals[theFaces[j].theFaceNormal];
-					}
-				}
+				theNormal = theNormal + cornerNormal(corners[c], weighting);
 			}
 			theNormal.normalize();
-			newNormals[i] = theNormal;
-		}
-
-		theVertNormals = new Vector3d[numberOfVertices];
-		numberOfVertNormals = numberOfVertices;
-
-
-		for (int count = 0; count < numberOfVertNormals; count ++)
-		{
-			theVertNormals[count] = newNormals[count];
-		}
+			theVertNormals[i] = theNormal;
+		}, 1024);
 	}
 }
 
@@ -502,22 +479,31 @@ void ThreeDModel::calcVertNormals(int* VertList, int VertListSize, int* TriList,
 {
 	if(theVerts != NULL)
 	{
-		for (int i = 0; i < VertListSize; i++) //For all the verts
+		//the verts of the list sorted with their place in it, so each corner of a face finds its vert by a binary search
+		std::vector<std::pair<int, int> > sorted(VertListSize);
+		for (int i = 0; i < VertListSize; i++)
 		{
-			Vector3d theNormal(0,0,0);
-			for (int j = 0; j < TriListSize; j++)		 //GO through all the faces
+			sorted[i] = std::make_pair(VertList[i], i);
+		}
+		std::sort(sorted.begin(), sorted.end());
+
+		std::vector<Vector3d> sums(VertListSize);
+		for (int j = 0; j < TriListSize; j++)		 //GO through all the faces once
+		{
+			for (int k = 0; k < 3; k++)
 			{
-				for (int k = 0; k < 3; k++)
+				std::vector<std::pair<int, int> >::iterator found = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair((int)theFaces[TriList[j]].thePoints[k], -1));
+				if (found != sorted.end() && found->first == theFaces[TriList[j]].thePoints[k])
 				{
-					if (theFaces[TriList[j]].thePoints[k] == VertList[i]) //if index equals current index
-					{	
-						theNormal = theNormal + theFaceNormals[theFaces[TriList[j]].theFaceNormal];
-					}
+					sums[found->second] = sums[found->second] + theFaceNormals[theFaces[TriList[j]].theFaceNormal];
 				}
 			}
-			theNormal.normalize();
+		}
 
-			theVertNormals[VertList[i]] = theNormal;
+		for (int i = 0; i < VertListSize; i++) //For all the verts
+		{
+			sums[i].normalize();
+			theVertNormals[VertList[i]] = sums[i];
 		}
 	}
 }
@@ -532,7 +518,7 @@ void ThreeDModel::centreOnZero()
 	//Subtract centre point from each point
 	if(theVerts == NULL)
 	{
-		for (int count = 0; count < numberOfTriangles*3*3; count+=3)
+		for (int count = 0; count < numberOfDrawVertices*3; count+=3)
 		{
 			vertexPositionList[count] = vertexPositionList[count] - theBBox.centrePoint.x;
 			vertexPositionList[count+1] = vertexPositionList[count+1] - theBBox.centrePoint.y;
@@ -553,7 +539,7 @@ void ThreeDModel::scale(float scaleAmount)
 {
 	if(theVerts == NULL)
 	{
-		for (int count = 0; count < numberOfTriangles*3*3; count++)
+		for (int count = 0; count < numberOfDrawVertices*3; count++)
 		{
 			vertexPositionList[count] = vertexPositionList[count] * scaleAmount;
 		}
@@ -571,7 +557,7 @@ void ThreeDModel::translate(Vector3d transVec)
 {
 	if(theVerts == NULL)
 	{
-		for (int count = 0; count < numberOfTriangles*3*3; count+=3)
+		for (int count = 0; count < numberOfDrawVertices*3; count+=3)
 		{
 			//	Vector3d bob = theVerts[count];
 			vertexPositionList[count] = vertexPositionList[count] + transVec.x;
@@ -595,7 +581,7 @@ void ThreeDModel::adjustBoundingBox()
 	float maxdisplace = 0;
 	if(theVerts == NULL)
 	{
-		for (int count = 0; count < numberOfTriangles*3*3; count+=3)
+		for (int count = 0; count < numberOfDrawVertices*3; count+=3)
 		{
 			if ((vertexPositionList[count] > -1000) && (vertexPositionList[count+1] > -1000) && (vertexPositionList[count+2] > -1000))
 			{
@@ -639,47 +625,54 @@ void ThreeDModel::initVBO(Shader* myShader)
 	int numOfMaterials = length.size()/3;
 	std::cout << " initVBO " << numOfMaterials << std::endl;
 
-	int sizeOfGLBuffer = 4+numOfMaterials;
+	int sizeOfGLBuffer = 2+numOfMaterials;
 	glBuffer = new GLuint[sizeOfGLBuffer];
 	glGenBuffers(sizeOfGLBuffer, glBuffer);
 
-	std::cout << " make vertexPositionList, numOfTriangles " << numberOfTriangles << std::endl;
+	//---the position, normal and texture coordinate of each vertex interleaved and packed, the shader decodes them---
+	vertexLayout = VertexPacking::chooseLayout(vertexPositionList, vertexTexCoordList, numberOfDrawVertices, true, MAX_POSITION_ERROR);
+	std::vector<unsigned char> vertices;
+	VertexPacking::pack(vertexLayout, vertexPositionList, vertexNormalList, vertexTexCoordList, numberOfDrawVertices, vertices);
+	std::cout << " make packed vertices, " << vertexLayout.stride << " bytes per vertex instead of " << 8*sizeof(GLfloat) << std::endl;
+
 	glBindBuffer(GL_ARRAY_BUFFER, glBuffer[0]);
-	glBufferData(GL_ARRAY_BUFFER, numberOfTriangles*3*3*sizeof(GLfloat), vertexPositionList, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.empty() ? NULL : &vertices[0], GL_STATIC_DRAW);
 	GLint vertexLocation= glGetAttribLocation(myShader->handle(), "in_Position");
-	glVertexAttribPointer(vertexLocation, 3, GL_FLOAT, GL_FALSE, 0, 0); 
+	glVertexAttribPointer(vertexLocation, 3, vertexLayout.quantizedPositions ? GL_SHORT : GL_FLOAT, GL_FALSE, vertexLayout.stride, 0); 
 	glEnableVertexAttribArray(vertexLocation);
 
-
-	std::cout << " make vertexNormalList " << std::endl;
-	glBindBuffer(GL_ARRAY_BUFFER, glBuffer[1]);
-	glBufferData(GL_ARRAY_BUFFER, numberOfTriangles*3*3*sizeof(GLfloat), vertexNormalList, GL_STATIC_DRAW);
-		GLint normalLocation = glGetAttribLocation(myShader->handle(), "in_Normal");
-	glVertexAttribPointer(normalLocation, 3, GL_FLOAT, GL_FALSE, 0,0);
+	GLint normalLocation = glGetAttribLocation(myShader->handle(), "in_Normal");
+	glVertexAttribPointer(normalLocation, 2, GL_SHORT, GL_FALSE, vertexLayout.stride, (void*)(size_t)vertexLayout.normalOffset);
 	glEnableVertexAttribArray(normalLocation);
 
-
-	std::cout << " make vertexTexCoordList " << std::endl;
-	glBindBuffer(GL_ARRAY_BUFFER, glBuffer[2]);
-	glBufferData(GL_ARRAY_BUFFER, numberOfTriangles*3*2*sizeof(GLfloat), vertexTexCoordList, GL_STATIC_DRAW);
 	GLint texCoordLocation = glGetAttribLocation(myShader->handle(), "in_TexCoord");
-	glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, 0,0);
+	glVertexAttribPointer(texCoordLocation, 2, vertexLayout.halfTexCoords ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, vertexLayout.stride, (void*)(size_t)vertexLayout.texCoordOffset);
 	glEnableVertexAttribArray(texCoordLocation);
 
 
 	if(vertexColorList != NULL)
 	{
 		std::cout << " make vertexColorList " << std::endl;
-		glBindBuffer(GL_ARRAY_BUFFER, glBuffer[3]);
-		glBufferData(GL_ARRAY_BUFFER, numberOfTriangles*3*3*sizeof(GLfloat), vertexColorList, GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, glBuffer[1]);
+		glBufferData(GL_ARRAY_BUFFER, numberOfDrawVertices*3*sizeof(GLfloat), vertexColorList, GL_STATIC_DRAW);
 	}
 
 	
-	std::cout << " make faceIDsList " << std::endl;
+	std::cout << " make faceIDsList, numberOfDrawVertices " << numberOfDrawVertices << std::endl;
+	std::vector<GLushort> shortIndices;
 	for(unsigned int i=0;i<length.size();i+=3)
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glBuffer[4+(i/3)]);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, (length[i+1]-length[i]+3)*sizeof(GLuint), faceIDsList+(length[i]), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glBuffer[2+(i/3)]);
+		int count = length[i+1]-length[i]+3;
+		if (indexTypes[i/3] == GL_UNSIGNED_SHORT)
+		{
+			shortIndices.assign(faceIDsList+length[i], faceIDsList+length[i]+count);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, count*sizeof(GLushort), &shortIndices[0], GL_STATIC_DRAW);
+		}
+		else
+		{
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, count*sizeof(GLuint), faceIDsList+(length[i]), GL_STATIC_DRAW);
+		}
 	}
 
 	glEnableVertexAttribArray(0);
@@ -687,22 +680,73 @@ void ThreeDModel::initVBO(Shader* myShader)
 	glBindVertexArray(0);
 }
 
-void ThreeDModel::initDrawElements()
+// the position, normal and texture coordinate corner k of face f is drawn with
+static void drawnCorner(const ThreeDModel& model, int f, int k, GLfloat corner[8])
 {
-	if(vertexPositionList == NULL)
+	const aFace& face = model.theFaces[f];
+
+	const Vector3d& position = model.theVerts[face.thePoints[k]];
+	corner[0] = position.x;
+	corner[1] = position.y;
+	corner[2] = position.z;
+
+	if (model.numberOfVertNormals > 0)
 	{
-	vertexPositionList = new GLfloat[numberOfTriangles*3*3];
-	vertexNormalList = new GLfloat[numberOfTriangles*3*3];
-	vertexTexCoordList = new GLfloat[numberOfTriangles*3*2];
+		const Vector3d& normal = model.theVertNormals[face.thePoints[k]];
+		corner[3] = normal.x;
+		corner[4] = normal.y;
+		corner[5] = normal.z;
+	}
+	else if (model.numberOfFaceNormals > 0)
+	{
+		const Vector3d& normal = model.theFaceNormals[face.theFaceNormal];
+		corner[3] = normal.x;
+		corner[4] = normal.y;
+		corner[5] = normal.z;
+	}
+	else
+	{
+		corner[3] = corner[4] = corner[5] = 0;
+	}
 
-	faceIDsList=new GLuint[numberOfTriangles*3];
-	for(int i=0; i<numberOfTriangles*3; i+=3)
+	if (model.numberOfTexCoords > 0)
 	{
-		faceIDsList[i]=i;
-		faceIDsList[i+1]=(i+1);
-		faceIDsList[i+2]=(i+2);
+		corner[6] = model.theTexCoords[face.theTexCoord[k]].x;
+		corner[7] = model.theTexCoords[face.theTexCoord[k]].y;
+	}
+	else
+	{
+		corner[6] = corner[7] = 0;
+	}
+
+	// -0 and 0 are the same vertex, the welding compares the bits
+	for (int i = 0; i < 8; i++)
+	{
+		if (corner[i] == 0.0f)
+			corner[i] = 0.0f;
+	}
+}
+
+static unsigned int hashCorner(const GLfloat corner[8])
+{
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < 8; i++)
+	{
+		unsigned int bits;
+		memcpy(&bits, &corner[i], sizeof(bits));
+		hash = (hash ^ bits) * 16777619u;
 	}
-	
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	return hash ^ (hash >> 13);
+}
+
+void ThreeDModel::initDrawElements()
+{
+	if(vertexPositionList == NULL)
+	{
+	faceIDsList=new GLuint[numberOfTriangles*3];
 
 	length.clear();
 	unsigned int polyCount = 0;
@@ -736,107 +780,129 @@ void ThreeDModel::initDrawElements()
 	//length.push_back(0);
 	//length.push_back(numberOfTriangles*3);
 
-	for(int triIndex=0,i=0,j=0; triIndex<numberOfTriangles; triIndex++,i+=3, j+=2)
+	//---weld the corners of each material, the vertices of a material follow each other so its indices count from its
+	//first vertex and fit in 16 bits below 65536 vertices---
+	std::vector<GLfloat> welded;		// 8 floats per vertex, position, normal and texture coordinate
+	std::vector<int> slots;			// open addressing table of the vertices of the material
+	baseVertices.clear();
+	indexTypes.clear();
+	for(unsigned int i=0;i<length.size();i+=3)
 	{
-		aFace temp = theFaces[triIndex];		
-	
-		unsigned int vert1 = temp.thePoints[0];
-		unsigned int vert2 = temp.thePoints[1];
-		unsigned int vert3 = temp.thePoints[2];
-		
-		unsigned int norm1 = temp.theFaceNormal;
+		int first = length[i];
+		int count = length[i+1]-length[i]+3;
+		int base = welded.size()/8;
 
-		unsigned int tex1 = temp.theTexCoord[0];
-		unsigned int tex2 = temp.theTexCoord[1];
-		unsigned int tex3 = temp.theTexCoord[2];
+		int tableSize = 16;
+		while (tableSize < 2*count)
+			tableSize *= 2;
+		slots.assign(tableSize, -1);
 
-		vertexPositionList[i]=theVerts[vert1].x;
-		vertexPositionList[i+1]=theVerts[vert1].y;
-		vertexPositionList[i+2]=theVerts[vert1].z;
-		
-		if(numberOfVertNormals > 0)
-		{
-			vertexNormalList[i]=theVertNormals[vert1].x;
-			vertexNormalList[i+1]=theVertNormals[vert1].y;
-			vertexNormalList[i+2]=theVertNormals[vert1].z;
-		}
-		else if(numberOfFaceNormals > 0)
-		{
-			vertexNormalList[i]=theFaceNormals[norm1].x;
-			vertexNormalList[i+1]=theFaceNormals[norm1].y;
-			vertexNormalList[i+2]=theFaceNormals[norm1].z;
-		}
-		else
+		for (int c = first; c < first+count; c++)
 		{
-			vertexNormalList[i]=0;
-			vertexNormalList[i+1]=0;
-			vertexNormalList[i+2]=0;
-		}
-				
-		vertexTexCoordList[j]=theTexCoords[tex1].x;;
-		vertexTexCoordList[j+1]=theTexCoords[tex1].y;
+			GLfloat corner[8];
+			drawnCorner(*this, c/3, c%3, corner);
 
-		i+=3;
-		j+=2;
+			unsigned int slot = hashCorner(corner) & (tableSize-1);
+			while (slots[slot] >= 0 && memcmp(&welded[slots[slot]*8], corner, sizeof(corner)) != 0)
+				slot = (slot+1) & (tableSize-1);
 
-		vertexPositionList[i]=theVerts[vert2].x;
-		vertexPositionList[i+1]=theVerts[vert2].y;
-		vertexPositionList[i+2]=theVerts[vert2].z;
-		
-		if(numberOfVertNormals > 0)
-		{
-			vertexNormalList[i]=theVertNormals[vert2].x;
-			vertexNormalList[i+1]=theVertNormals[vert2].y;
-			vertexNormalList[i+2]=theVertNormals[vert2].z;
-		}
-		else if(numberOfFaceNormals > 0)
-		{
-			vertexNormalList[i]=theFaceNormals[norm1].x;
-			vertexNormalList[i+1]=theFaceNormals[norm1].y;
-			vertexNormalList[i+2]=theFaceNormals[norm1].z;
-		}
-		else
-		{
-			vertexNormalList[i]=0;
-			vertexNormalList[i+1]=0;
-			vertexNormalList[i+2]=0;
+			if (slots[slot] < 0)
+			{
+				slots[slot] = welded.size()/8;
+				welded.insert(welded.end(), corner, corner+8);
+			}
+			faceIDsList[c] = slots[slot]-base;
 		}
-				
-		vertexTexCoordList[j]=theTexCoords[tex2].x;;
-		vertexTexCoordList[j+1]=theTexCoords[tex2].y;
 
-		i+=3;
-		j+=2;
+		baseVertices.push_back(base);
+		indexTypes.push_back(welded.size()/8-base <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+	}
 
-		vertexPositionList[i]=theVerts[vert3].x;
-		vertexPositionList[i+1]=theVerts[vert3].y;
-		vertexPositionList[i+2]=theVerts[vert3].z;
-		
-		if(numberOfVertNormals > 0)
-		{
-			vertexNormalList[i]=theVertNormals[vert3].x;
-			vertexNormalList[i+1]=theVertNormals[vert3].y;
-			vertexNormalList[i+2]=theVertNormals[vert3].z;
-		}
-		else if(numberOfFaceNormals > 0)
+	numberOfDrawVertices = welded.size()/8;
+	std::cout << " welded " << numberOfTriangles*3 << " corners into " << numberOfDrawVertices << " vertices" << std::endl;
+
+	vertexPositionList = new GLfloat[numberOfDrawVertices*3];
+	vertexNormalList = new GLfloat[numberOfDrawVertices*3];
+	vertexTexCoordList = new GLfloat[numberOfDrawVertices*2];
+	for (int v = 0; v < numberOfDrawVertices; v++)
+	{
+		memcpy(vertexPositionList+v*3, &welded[v*8], 3*sizeof(GLfloat));
+		memcpy(vertexNormalList+v*3, &welded[v*8+3], 3*sizeof(GLfloat));
+		memcpy(vertexTexCoordList+v*2, &welded[v*8+6], 2*sizeof(GLfloat));
+	}
+	}
+}
+
+// moves the vertices of a list from base to their remapped places, size floats each
+static void remapVertices(GLfloat* list, int base, int count, int size, const std::vector<unsigned int>& remap)
+{
+	if (list == NULL)
+		return;
+
+	std::vector<GLfloat> moved(count*size);
+	for (int v = 0; v < count; v++)
+		memcpy(&moved[remap[v]*size], list+(base+v)*size, size*sizeof(GLfloat));
+	memcpy(list+base*size, &moved[0], count*size*sizeof(GLfloat));
+}
+
+// true when the indices after miss no more than before in a FIFO cache of 16 and of 32 vertices and read no more of the
+// vertex buffer
+static bool noWorseOrder(const GLuint* before, const GLuint* after, int count, int vertexCount, int vertexSize)
+{
+	for (int cacheSize = 16; cacheSize <= 32; cacheSize *= 2)
+	{
+		if (MeshOptimizer::analyzeVertexCache(after, count, vertexCount, cacheSize).transformed > MeshOptimizer::analyzeVertexCache(before, count, vertexCount, cacheSize).transformed)
+			return false;
+	}
+
+	return MeshOptimizer::analyzeVertexFetch(after, count, vertexCount, vertexSize) <= MeshOptimizer::analyzeVertexFetch(before, count, vertexCount, vertexSize);
+}
+
+int ThreeDModel::optimizeDrawElements()
+{
+	int vertexSize = VertexPacking::chooseLayout(vertexPositionList, vertexTexCoordList, numberOfDrawVertices, true, MAX_POSITION_ERROR).stride;
+	int reordered = 0;
+
+	std::vector<unsigned int> order, remap;
+	for(unsigned int i=0;i<length.size();i+=3)
+	{
+		int first = length[i];
+		int count = length[i+1]-length[i]+3;
+		int base = baseVertices[i/3];
+		int end = i+3 < length.size() ? baseVertices[i/3+1] : numberOfDrawVertices;
+
+		// the whole pass, then without the overdraw order, which may cost misses and fetches
+		bool taken = false;
+		for (int attempt = 0; attempt < 2 && !taken; attempt++)
 		{
-			vertexNormalList[i]=theFaceNormals[norm1].x;
-			vertexNormalList[i+1]=theFaceNormals[norm1].y;
-			vertexNormalList[i+2]=theFaceNormals[norm1].z;
+			order.assign(faceIDsList+first, faceIDsList+first+count);
+			MeshOptimizer::optimizeVertexCache(&order[0], count, end-base);
+			if (attempt == 0)
+				MeshOptimizer::optimizeOverdraw(&order[0], count, vertexPositionList+base*3, 3, end-base, OVERDRAW_THRESHOLD);
+			MeshOptimizer::optimizeVertexFetch(&order[0], count, end-base, remap);
+
+			taken = noWorseOrder(faceIDsList+first, &order[0], count, end-base, vertexSize);
 		}
-		else
+
+		if (!taken)
 		{
-			vertexNormalList[i]=0;
-			vertexNormalList[i+1]=0;
-			vertexNormalList[i+2]=0;
+			std::cout << " texture " << length[i+2] << " keeps its welded order" << std::endl;
+			continue;
 		}
-				
-		vertexTexCoordList[j]=theTexCoords[tex3].x;;
-		vertexTexCoordList[j+1]=theTexCoords[tex3].y;
-	}	
 
-	
+		VertexCacheStatistics before = MeshOptimizer::analyzeVertexCache(faceIDsList+first, count, end-base, 16);
+		std::copy(order.begin(), order.end(), faceIDsList+first);
+		remapVertices(vertexPositionList, base, end-base, 3, remap);
+		remapVertices(vertexNormalList, base, end-base, 3, remap);
+		remapVertices(vertexTexCoordList, base, end-base, 2, remap);
+		remapVertices(vertexColorList, base, end-base, 3, remap);
+		reordered++;
+
+		VertexCacheStatistics after = MeshOptimizer::analyzeVertexCache(faceIDsList+first, count, end-base, 16);
+		std::cout << " texture " << length[i+2] << " ACMR " << before.acmr << " -> " << after.acmr << std::endl;
 	}
+
+	return reordered;
 }
 
 void ThreeDModel::drawElementsUsingVBO(Shader* myShader)
@@ -844,6 +910,8 @@ void ThreeDModel::drawElementsUsingVBO(Shader* myShader)
 	glBindVertexArray(m_vaoID);	
 		
 	glUniform1i(glGetUniformLocation(myShader->handle(), "DiffuseMap"), 0);
+	glUniform3fv(glGetUniformLocation(myShader->handle(), "PositionScale"), 1, vertexLayout.positionScale);
+	glUniform3fv(glGetUniformLocation(myShader->handle(), "PositionOffset"), 1, vertexLayout.positionOffset);
 
 	for(unsigned int i=0;i<length.size();i+=3)
 	{
@@ -853,10 +921,10 @@ void ThreeDModel::drawElementsUsingVBO(Shader* myShader)
 		glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
 		
 		//std::cout << " length " << length[i] << " " << length[i+1] << " " << length[i+2] << std::endl;
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glBuffer[4+(i/3)]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glBuffer[2+(i/3)]);
 		
 		//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		glDrawElements(GL_TRIANGLES, (length[i+1]-length[i]+3), GL_UNSIGNED_INT, 0);
+		glDrawElementsBaseVertex(GL_TRIANGLES, (length[i+1]-length[i]+3), indexTypes[i/3], 0, baseVertices[i/3]);
 	}
 	
 	glBindBuffer(GL_ARRAY_BUFFER, 0);	
@@ -865,6 +933,59 @@ void ThreeDModel::drawElementsUsingVBO(Shader* myShader)
 	glBindVertexArray(0);	
 }
 
+void ThreeDModel::drawElementsInstancedUsingVBO(Shader* myShader, int instanceCount)
+{
+	glBindVertexArray(m_vaoID);
+
+	glUniform1i(glGetUniformLocation(myShader->handle(), "DiffuseMap"), 0);
+	glUniform3fv(glGetUniformLocation(myShader->handle(), "PositionScale"), 1, vertexLayout.positionScale);
+	glUniform3fv(glGetUniformLocation(myShader->handle(), "PositionOffset"), 1, vertexLayout.positionOffset);
+
+	for(unsigned int i=0;i<length.size();i+=3)
+	{
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, length[i+2]);
+		glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glBuffer[2+(i/3)]);
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (length[i+1]-length[i]+3), indexTypes[i/3], 0, instanceCount, baseVertices[i/3]);
+	}
+
+	glBindVertexArray(0);
+}
+
+void ThreeDModel::addInstanceAttribute(Shader* myShader, const char* name, GLuint buffer, int components)
+{
+	glBindVertexArray(m_vaoID);
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	GLint location = glGetAttribLocation(myShader->handle(), name);
+	glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, 0, 0);
+	glEnableVertexAttribArray(location);
+	glVertexAttribDivisorARB(location, 1);	// core only from 3.3, the game asks for a 3.2 context
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void ThreeDModel::addInstanceMatrix(Shader* myShader, const char* name, GLuint buffer)
+{
+	glBindVertexArray(m_vaoID);
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	GLint location = glGetAttribLocation(myShader->handle(), name);
+	for (int column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(GLfloat), (void*)(column * 4 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(location + column);
+		glVertexAttribDivisorARB(location + column, 1);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
 static int   sortByMat( const void *tpi, const void *tpj )
 {
 	aFace* pi, *pj;
@@ -5,6 +5,7 @@
 #include "..//3DStruct//BoundingBox.h"
 #include "..//Structures//Vector3d.h"
 #include "..//Structures//Vector2d.h"
+#include "..//Utilities//VertexPacking.h"
 #include <windows.h>
 #include <set>
 #include <vector>
@@ -69,7 +70,15 @@ class aFace
 };
 
 
-class Octree;
+class LinearOctree;
+
+// how the faces round a vertex add up to its normal
+enum NormalWeighting
+{
+	WEIGHT_UNIFORM,		// every face the same
+	WEIGHT_AREA,		// by the area of the face
+	WEIGHT_ANGLE		// by the angle of the face at the vertex
+};
 
 
 class ThreeDModel
@@ -93,8 +102,11 @@ public:
 
 	unsigned int* indexArray;
 	std::vector<unsigned int> startPoints;
-	std::vector<unsigned int> length;	
+	std::vector<unsigned int> length;
+	std::vector<GLint> baseVertices;	// per material, the first vertex its indices in faceIDsList count from
+	std::vector<GLenum> indexTypes;		// per material, GL_UNSIGNED_SHORT when its vertices fit in 16 bits
 
+	int numberOfDrawVertices;	// the welded vertices of the lists below, shared by the faces through faceIDsList
 	GLfloat *vertexPositionList;
 	GLfloat *vertexNormalList;
 	GLfloat *vertexTexCoordList;
@@ -102,13 +114,18 @@ public:
 	GLuint *faceIDsList;
 	GLuint *glBuffer;
 	GLuint m_vaoID;
+	PackedVertexLayout vertexLayout;	// of the vertices in glBuffer[0]
+	static const float MAX_POSITION_ERROR;	// the most a drawn position may move when it is quantized
+	static const float OVERDRAW_THRESHOLD;	// how much worse the vertex cache may get to draw the outward triangles first
+
+	// uploads the vertex lists packed into glBuffer[0] and the indices of each material from glBuffer[2]
 	void initVBO(Shader* myShader);
 	void deleteVertexFaceData();
 
 	aFace * theFaces;
 	aMaterial * theMaterials;
 
-	Octree* octree;
+	LinearOctree* octree;	// keeps its own copy of the triangles, used by collisionBetweenPoint
 
 	// *************** Methods *****************
 
@@ -116,21 +133,29 @@ public:
 	
 	~ThreeDModel();
 
-	ThreeDModel(const ThreeDModel& p);	//Make an assignment opperator
-
-	void operator=(const ThreeDModel &p);//for Vector	
 	void calcSidePointPlane(Vector3d &thePoint, float w, aFace &thePlane);	
 
 	bool collisionBetweenPoint(Vector3d* v, float threshold);
 	bool BarycentricCalculation(Vector3d* v, float dist, int i);
 
 	void calcFaceNormals();
-	void calcVertNormals();
+	// in one pass over the faces, from the faces of each vertex
+	void calcVertNormals(NormalWeighting weighting = WEIGHT_UNIFORM);
+	// the normals of the verts in VertList from the faces in TriList, a leaf of the octree
 	void calcVertNormals(int* VertList, int VertListSize, int* TriList, int TriListSize);
+	// the corners of the faces round each vertex, 3 * face + corner, for vertex v from cornerStart[v] to cornerStart[v + 1]
+	void vertexCorners(std::vector<int>& cornerStart, std::vector<int>& corners) const;
+	// the weighted normal a face adds to the vertex at corner
+	Vector3d cornerNormal(int corner, NormalWeighting weighting) const;
 	void calcVertNormalsUsingOctree();
 	void calcFakeVertNormals();
 	void calcCentrePoint();
 	void constructOctree();
+	// maps the octree and the vertex normals baked at path in place of building them, false when the file is missing or
+	// was baked from another mesh
+	bool loadBakedOctree(const char* path);
+	// writes the octree and the vertex normals for loadBakedOctree, after calcVertNormalsUsingOctree
+	bool bakeOctree(const char* path);
 	
 	void centreOnZero();
 	void adjustBoundingBox();
@@ -140,8 +165,21 @@ public:
 
 	//Draw Methods 
 	virtual void drawElementsUsingVBO(Shader* myShader);
-	
+	// draws instanceCount copies in one call per material, the per instance data comes from addInstanceAttribute
+	void drawElementsInstancedUsingVBO(Shader* myShader, int instanceCount);
+	// reads the attribute name of the shader from buffer once per instance instead of once per vertex
+	void addInstanceAttribute(Shader* myShader, const char* name, GLuint buffer, int components);
+	// the same for a mat4 attribute, which takes four locations, from a buffer of column major matrices
+	void addInstanceMatrix(Shader* myShader, const char* name, GLuint buffer);
+
+	// welds the corners of the faces of each material with the same position, normal and texture coordinate into one
+	// vertex of the lists, and indexes the faces into them
 	void initDrawElements();
+	// reorders the triangles of each material for the vertex cache and then the overdraw, and its vertices in the order
+	// the triangles use them, after initDrawElements and before initVBO. A material keeps its order unless the new one
+	// misses no more in a FIFO cache of 16 and of 32 vertices and reads no more of the vertex buffer. Returns the
+	// materials reordered.
+	int optimizeDrawElements();
 	void sortFacesOnMaterial();
 
 	//Methods useful for octree
@@ -154,6 +192,11 @@ public:
 	void drawOctreeLeaves(Shader* myShader);
 	//end octree methods
 
+private:
+
+	// the model owns its octree, which may map a file, so it is neither copied nor assigned
+	ThreeDModel(const ThreeDModel&);
+	void operator=(const ThreeDModel&);
 };
 
 
@@ -0,0 +1,24 @@
+#include "Benchmarks.h"
+#include "../tube.h"
+
+#include <iostream>
+
+using namespace std;
+
+void Benchmarks::runAll(Tube& tube)
+{
+	runHeadless(tube);
+
+	cout << " Running the benchmarks of the game build : " << endl;
+
+	modelBvhRays(100000);
+	octreeBuild();
+	octreeQueries(1000);
+	octreeBake(1000);
+	vertexNormals();
+	vertexWelding();
+	modelVertexPacking();
+	modelMeshOptimization();
+
+	cout << " Benchmarks finished " << endl;
+}
@@ -0,0 +1,128 @@
+/*---CPU benchmarks of the game systems. They print their results to the console. The ones runHeadless calls only need
+the simulation and are built into the headless runner of CMakeLists.txt, "headless -bench" runs them on machines without a
+GPU. runAll adds the ones on the models, the OBJ loader makes the textures of the models, so the game runs them with
+-bench once its window is up.---*/
+
+#ifndef _BENCHMARKS_H
+#define _BENCHMARKS_H
+
+#include <glm/glm.hpp>
+
+#include <random>
+#include <vector>
+
+class Tube;
+class ThreeDModel;
+class BVH;
+
+class Benchmarks
+{
+private:
+	// the most an octahedral normal may be off after its round trip, in radians
+	static const float OCTAHEDRAL_NORMAL_ERROR;
+
+	// a shot along the path from a random point with a small random deviation, like a missile fired by the player
+	static void randomShot(Tube& tube, std::mt19937& rng, glm::vec3& origin, glm::vec3& direction);
+	static glm::vec3 randomDirection(std::mt19937& rng);
+
+	// prints the rays per second of bvh on the rays, with its size and build time
+	static void rayThroughput(const char* name, const BVH& bvh, double buildTime, const std::vector<glm::vec3>& origins,
+		const std::vector<glm::vec3>& directions, float maxDistance);
+	// the BVH of the faces of a model against testing every face, on rays aimed into its bounding box
+	static void modelRays(const char* path, int rayCount);
+
+	// packs count vertices of float lists and checks every one comes back within the bounds of its layout
+	static void meshPacking(const char* name, const float* positions, const float* normals, const float* texCoords, int count,
+		float maxPositionError, float maxNormalError, int bytesBefore);
+	static void modelPacking(const char* name, ThreeDModel& model, float maxNormalError);
+
+	// prints the vertex cache, the vertex fetch and the overdraw of drawing indices in order
+	static void drawStatistics(const char* order, const std::vector<unsigned int>& indices, int triangleCount, const std::vector<unsigned int>& triangleList,
+		const float* positions, int vertexCount, int vertexSize);
+	// the triangles of indices over positions, sorted, to check two orders draw the same triangles
+	static void sortedTriangles(const std::vector<unsigned int>& indices, const float* positions, std::vector<std::vector<float> >& triangles);
+	static void modelOptimization(const char* name, ThreeDModel& model);
+
+public:
+	// loads a model of Models for the model benchmarks, or makes a stand-in of about its size when the file is not there
+	static bool loadModel(const char* path, ThreeDModel& model);
+
+	// runs every benchmark that only needs the tube and the simulation
+	static void runHeadless(Tube& tube);
+	// runs those and the ones built only into the game, on the models and the collision structures
+	static void runAll(Tube& tube);
+
+	// per frame cost of the projectile pool, split into the batched ray casts, the integration and the gather for the
+	// instanced draw, against testing every projectile point against the tube each frame
+	static void projectilePool(Tube& tube, int projectileCount, int frames);
+
+	// build time, bound check and query cost of the Koch hierarchy against the linear searches of the tube
+	static void kochHierarchy(Tube& tube, int queryCount);
+
+	// build time and single thread ray throughput of the BVH on a dimension 5 tube, against the Koch hierarchy
+	static void bvhRays(int rayCount);
+	// the same on the ss6 and ball models
+	static void modelBvhRays(int rayCount);
+
+	// coarse-to-fine point tests against single level and exhaustive testing, on points along projectile flights
+	static void multiResolution(Tube& tube, int pointCount);
+
+	// projectiles against spinning obstacles placed along the path, testing every pair against the spatial hash broad phase
+	static void obstacleCollider(Tube& tube, int projectileCount, int obstacleCount, int frames);
+
+	// player update from the path frame table and arc length path against computing the orientations every frame and
+	// moving along the segment direction, at the game speed and at speeds above the segment length
+	static void playerPath(Tube& tube, int frames);
+
+	// arc length lookups of entities moving along the path: binary search, hinted lookup and bulk evaluation
+	static void pathLookup(Tube& tube, int entityCount, int frames);
+
+	// model matrices of every obstacle with the glm chain used for the single draws, against the SSE build of all of them
+	// and of the ones left after frustum culling
+	static void obstacleTransforms(int obstacleCount, int frames);
+
+	// obstacles near a point moving along the path, found by a linear scan of the distances against the range query of the index
+	static void obstacleIndex(int obstacleCount, int queries);
+
+	// incremental update of a loose octree of moving objects against building it again every frame, and its sphere, box
+	// and ray queries against testing every object
+	static void looseOctree(int objectCount, int frames, int queryCount);
+
+	// build time, memory and leaves of the linear octree against the octree on the shipped models
+	static void octreeBuild();
+
+	// point, sphere and ray queries of the model octree against testing every face, on the shipped models
+	static void octreeQueries(int queryCount);
+
+	// building the model octree and vertex normals against mapping them from a baked file, and the queries of the mapped
+	// octree after the model deletes its mesh
+	static void octreeBake(int queryCount);
+
+	// the spatial octree over the tube triangles against the point test and ray cast of the tube, and over the path points
+	static void tubeOctree(Tube& tube, int queryCount);
+
+	// vertex normals from the quadratic loops against one pass over the faces of each vertex, on ss6 and a dimension 4
+	// tube, with the model load time of the octree path before and after
+	static void vertexNormals();
+
+	// the vertex and index memory of the model lists with a vertex for every corner of every face against the corners
+	// welded into shared vertices, on ss6 and a dimension 4 tube, checking every corner still draws the same vertex
+	static void vertexWelding();
+
+	// round trips of the packed vertex formats against their error bounds, and the bytes per vertex of the game tube in
+	// float lists against the packed layout it chooses
+	static void vertexPacking(Tube& tube);
+	// the same for ss6 and a dimension 4 tube as models
+	static void modelVertexPacking();
+
+	// the ACMR and ATVR of FIFO caches, the vertex fetch and the overdraw of the game tube strip against the vertex cache
+	// order, and of its triangles shuffled against the whole pass of MeshOptimizer
+	static void meshOptimization(Tube& tube);
+	// the same for ss6, a dimension 4 tube and the same with its faces shuffled as models, and which orders they keep
+	static void modelMeshOptimization();
+
+	// cost of the fixed timestep clock, and the ticks it gives for jittering frame times with stalls
+	static void simulationClock(int frames);
+};
+
+#endif
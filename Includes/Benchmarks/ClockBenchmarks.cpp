@@ -0,0 +1,53 @@
+#include "Benchmarks.h"
+#include "../Time/SimulationClock.h"
+#include "../Time/Stopwatch.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+void Benchmarks::simulationClock(int frames)
+{
+	const double tick = 1.0 / 120.0;
+
+	cout << " Simulation clock benchmark: " << frames << " frames" << endl;
+
+	//---cost of reading the clock---
+	SimulationClock realClock(tick);
+	int realTicks = 0;
+
+	Stopwatch callTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		realTicks += realClock.advance();
+	}
+	double callTime = callTimer.value();
+
+	//---frames of 60 Hz +-50 %, with a 0.5 s stall every 1000 frames---
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> jitter(0.5, 1.5);
+
+	SimulationClock clock(tick);
+	double simulated = 0.0;
+	int maxTicks = 0;
+	float minAlpha = 1.0f, maxAlpha = 0.0f;
+
+	for (int f = 0; f < frames; f++)
+	{
+		double frameSeconds = (f % 1000 == 999) ? 0.5 : jitter(rng) / 60.0;
+		simulated += std::min(frameSeconds, 0.25);
+
+		maxTicks = std::max(maxTicks, clock.advance(frameSeconds));
+		minAlpha = std::min(minAlpha, clock.alpha());
+		maxAlpha = std::max(maxAlpha, clock.alpha());
+	}
+
+	// the accumulator only holds the fraction of a tick, so the ticks cover the simulated time to within one tick
+	double lost = simulated - clock.getTickCount() * tick;
+
+	cout << "  advance : " << callTime * 1000000.0 / frames << " ns per frame" << endl;
+	cout << "  " << clock.getTickCount() << " ticks for " << simulated << " s of frames, " << lost * 1000.0 << " ms not simulated yet" << endl;
+	cout << "  at most " << maxTicks << " ticks in a frame, alpha between " << minAlpha << " and " << maxAlpha << endl;
+}
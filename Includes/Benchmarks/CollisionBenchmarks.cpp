@@ -0,0 +1,517 @@
+#include "Benchmarks.h"
+#include "../tube.h"
+#include "../Collision/KochHierarchy.h"
+#include "../Collision/BVH.h"
+#include "../Collision/MultiResolutionCollision.h"
+#include "../Collision/ObstacleCollider.h"
+#include "../Utilities/IntersectionTests.h"
+#include "../Time/Stopwatch.h"
+
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// a point inside or just outside the tube near a random point of the path
+static glm::vec3 randomPointInTube(Tube& tube, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> offset(-1.2f * tube.getRadius(), 1.2f * tube.getRadius());
+
+	return tube.flake.verts[rng() % tube.flake.verts.size()] + glm::vec3(offset(rng), offset(rng), offset(rng));
+}
+
+glm::vec3 Benchmarks::randomDirection(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+
+	glm::vec3 direction;
+	do
+	{
+		direction = glm::vec3(component(rng), component(rng), component(rng));
+	} while (glm::dot(direction, direction) < 0.01f);
+
+	return glm::normalize(direction);
+}
+
+// slab test of the line from start to end against a segment bounding box
+static bool segmentBoxOverlap(Tube& tube, const glm::vec3& start, const glm::vec3& end, int box)
+{
+	glm::vec3 direction = end - start;
+	float tNear = 0.0f;
+	float tFar = 1.0f;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float minB = tube.boundingBoxes[box][0][axis];
+		float maxB = tube.boundingBoxes[box][1][axis];
+
+		if (abs(direction[axis]) < 0.000001f)
+		{
+			if (start[axis] < minB || start[axis] > maxB)
+				return false;
+		}
+		else
+		{
+			float invD = 1.0f / direction[axis];
+			float t1 = (minB - start[axis]) * invD;
+			float t2 = (maxB - start[axis]) * invD;
+
+			if (t1 > t2) std::swap(t1, t2);
+			if (t1 > tNear) tNear = t1;
+			if (t2 < tFar) tFar = t2;
+
+			if (tNear > tFar)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// the sweep the tube did before the hierarchy: slab test of every segment box, then the triangles of the boxes crossed
+static bool linearSegmentCollision(Tube& tube, const glm::vec3& start, const glm::vec3& end, float& timeOfImpact)
+{
+	bool hit = false;
+	timeOfImpact = 1.0f;
+
+	for (int i = 0; i < tube.boundingBoxes.size(); i++)
+	{
+		if (!segmentBoxOverlap(tube, start, end, i))
+			continue;
+
+		std::vector<unsigned int>& trianglesInSegment = tube.trianglesInBoxe[i];
+
+		for (int j = 0; j < trianglesInSegment.size(); j++)
+		{
+			float t;
+
+			if (tube.RayTriangleCalculation(start, end - start, trianglesInSegment[j], t) && t >= 0.0f && t <= timeOfImpact)
+			{
+				timeOfImpact = t;
+				hit = true;
+			}
+		}
+	}
+
+	return hit;
+}
+
+static bool linearPointCollision(Tube& tube, const glm::vec3& point, float threshold)
+{
+	for (int i = 0; i < tube.triangles.size(); i++)
+	{
+		float dist = glm::dot(point - tube.verts[tube.triangles[i].x], tube.norms[i]);
+
+		if (abs(dist) < threshold && tube.BarycentricCalculation(point, dist, i))
+			return true;
+	}
+
+	return false;
+}
+
+static bool linearSphereCollision(Tube& tube, const glm::vec3& center, float radius)
+{
+	for (int i = 0; i < tube.triangles.size(); i++)
+	{
+		const glm::vec3& triangle = tube.triangles[i];
+
+		if (IntersectionTests::sphereTriangleIntersect(&center[0], radius, &tube.verts[triangle.x][0], &tube.verts[triangle.y][0], &tube.verts[triangle.z][0]))
+			return true;
+	}
+
+	return false;
+}
+
+// counts the tube vertices of a node's segments that are outside its inflated cap
+static int capViolations(Tube& tube, const KochNode& node, float inflation)
+{
+	int violations = 0;
+
+	for (unsigned int s = node.firstSegment; s < node.lastSegment; s++)
+	{
+		for (int j = 0; j < tube.trianglesInBoxe[s].size(); j++)
+		{
+			const glm::vec3& triangle = tube.triangles[tube.trianglesInBoxe[s][j]];
+			glm::vec3 corners[3] = { tube.verts[triangle.x], tube.verts[triangle.y], tube.verts[triangle.z] };
+
+			for (int c = 0; c < 3; c++)
+			{
+				glm::vec3 closest;
+
+				if (node.firstChild >= 0)
+				{
+					IntersectionTests::closestPointOnTriangle(&corners[c][0], &node.start[0], &node.end[0], &node.peak[0], &closest[0]);
+				}
+				else
+				{
+					// the cap of a leaf is its edge
+					glm::vec3 edge = node.end - node.start;
+					float t = glm::clamp(glm::dot(corners[c] - node.start, edge) / glm::dot(edge, edge), 0.0f, 1.0f);
+					closest = node.start + edge * t;
+				}
+
+				if (glm::length(corners[c] - closest) > inflation * 1.001f)
+					violations++;
+			}
+		}
+	}
+
+	return violations;
+}
+
+void Benchmarks::kochHierarchy(Tube& tube, int queryCount)
+{
+	cout << " Koch hierarchy benchmark: " << queryCount << " queries of each kind" << endl;
+
+	KochHierarchy hierarchy;
+
+	Stopwatch buildTimer;
+	hierarchy.build(tube, tube.getRadius());
+	double buildTime = buildTimer.value();
+
+	const std::vector<KochNode>& nodes = hierarchy.getNodes();
+	int violations = 0;
+	for (int i = 0; i < nodes.size(); i++)
+	{
+		violations += capViolations(tube, nodes[i], 2.0f * tube.getRadius());
+	}
+
+	cout << "  build: " << buildTime << " ms, " << hierarchy.getNodeCount() << " nodes, depth " << hierarchy.getDepth()
+		<< ", " << tube.triangles.size() << " triangles" << endl;
+	cout << "  tube vertices outside the caps of their nodes: " << violations << endl;
+
+	//---queries---
+	std::mt19937 rng(7);
+	std::vector<glm::vec3> points(queryCount);
+	std::vector<glm::vec3> ends(queryCount);
+	for (int i = 0; i < queryCount; i++)
+	{
+		points[i] = randomPointInTube(tube, rng);
+		ends[i] = points[i] + randomDirection(rng) * (4.0f * tube.getRadius());
+	}
+
+	float threshold = tube.getRadius() * 0.1f;
+	float sphereRadius = tube.getRadius() * 0.3f;
+
+	int segmentHits = 0, pointHits = 0, sphereHits = 0;
+	int linearSegmentHits = 0, linearPointHits = 0, linearSphereHits = 0;
+	int mismatches = 0;
+
+	Stopwatch timer;
+	for (int i = 0; i < queryCount; i++)
+	{
+		float t;
+		segmentHits += hierarchy.segmentCollision(points[i], ends[i], t);
+	}
+	double segmentTime = timer.value();
+
+	timer.reset();
+	for (int i = 0; i < queryCount; i++)
+	{
+		float t;
+		linearSegmentHits += linearSegmentCollision(tube, points[i], ends[i], t);
+	}
+	double linearSegmentTime = timer.value();
+
+	timer.reset();
+	for (int i = 0; i < queryCount; i++)
+	{
+		pointHits += hierarchy.pointCollision(points[i], threshold);
+	}
+	double pointTime = timer.value();
+
+	timer.reset();
+	for (int i = 0; i < queryCount; i++)
+	{
+		sphereHits += hierarchy.sphereCollision(points[i], sphereRadius);
+	}
+	double sphereTime = timer.value();
+
+	// the brute force versions test every triangle, so they are only run on a part of the queries
+	int bruteCount = queryCount / 10;
+	timer.reset();
+	for (int i = 0; i < bruteCount; i++)
+	{
+		linearPointHits += linearPointCollision(tube, points[i], threshold);
+		linearSphereHits += linearSphereCollision(tube, points[i], sphereRadius);
+	}
+	double bruteTime = timer.value();
+
+	//---the same answers as the linear searches---
+	for (int i = 0; i < queryCount; i++)
+	{
+		float t1, t2;
+		bool hit1 = hierarchy.segmentCollision(points[i], ends[i], t1);
+		bool hit2 = linearSegmentCollision(tube, points[i], ends[i], t2);
+
+		if (hit1 != hit2 || (hit1 && abs(t1 - t2) > 0.0001f))
+			mismatches++;
+	}
+	for (int i = 0; i < bruteCount; i++)
+	{
+		if (hierarchy.pointCollision(points[i], threshold) != linearPointCollision(tube, points[i], threshold))
+			mismatches++;
+		if (hierarchy.sphereCollision(points[i], sphereRadius) != linearSphereCollision(tube, points[i], sphereRadius))
+			mismatches++;
+	}
+
+	cout << "  segment: " << segmentTime / queryCount * 1000.0 << " us per query (" << segmentHits << " hits), box scan "
+		<< linearSegmentTime / queryCount * 1000.0 << " us (" << linearSegmentHits << " hits)" << endl;
+	cout << "  point: " << pointTime / queryCount * 1000.0 << " us per query (" << pointHits << " hits)" << endl;
+	cout << "  sphere: " << sphereTime / queryCount * 1000.0 << " us per query (" << sphereHits << " hits)" << endl;
+	cout << "  point + sphere against every triangle: " << bruteTime / bruteCount * 1000.0 << " us per query pair (" << linearPointHits
+		<< " + " << linearSphereHits << " hits in " << bruteCount << " queries)" << endl;
+	cout << "  answers different from the linear searches: " << mismatches << endl;
+}
+
+void Benchmarks::rayThroughput(const char* name, const BVH& bvh, double buildTime, const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, float maxDistance)
+{
+	int hits = 0;
+
+	Stopwatch timer;
+	for (int i = 0; i < origins.size(); i++)
+	{
+		float distance;
+		hits += bvh.rayCast(origins[i], directions[i], maxDistance, distance);
+	}
+	double rayTime = timer.value();
+
+	cout << "  " << name << ": " << bvh.getTriangleCount() << " triangles, build " << buildTime << " ms, " << bvh.getNodeCount()
+		<< " nodes, depth " << bvh.getDepth() << ", " << origins.size() / (rayTime * 1000.0) << " million rays per second ("
+		<< hits << " hits)" << endl;
+}
+
+void Benchmarks::bvhRays(int rayCount)
+{
+	cout << " BVH benchmark: " << rayCount << " rays, one thread" << endl;
+
+	//---a dimension 5 tube with the sizes of the game---
+	Tube tube;
+	tube.constructGeometry(120.0f, 30000, 5, 16);
+
+	BVH bvh;
+	Stopwatch buildTimer;
+	bvh.buildFromTube(tube);
+	double buildTime = buildTimer.value();
+
+	// rays from inside the tube, the way projectiles are cast
+	std::mt19937 rng(5);
+	std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+	for (int i = 0; i < rayCount; i++)
+	{
+		origins[i] = tube.flake.verts[rng() % tube.flake.verts.size()];
+		directions[i] = randomDirection(rng);
+	}
+
+	rayThroughput("dimension 5 tube", bvh, buildTime, origins, directions, 1e30f);
+
+	int hits = 0, mismatches = 0;
+	Stopwatch timer;
+	for (int i = 0; i < rayCount; i++)
+	{
+		float distance;
+		hits += tube.hierarchy.rayCast(origins[i], directions[i], 100000.0f, distance);
+	}
+	double kochTime = timer.value();
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		float bvhDistance, kochDistance;
+		bool bvhHit = bvh.rayCast(origins[i], directions[i], 100000.0f, bvhDistance);
+		bool kochHit = tube.hierarchy.rayCast(origins[i], directions[i], 100000.0f, kochDistance);
+
+		if (bvhHit != kochHit || (bvhHit && abs(bvhDistance - kochDistance) > 0.01f))
+			mismatches++;
+	}
+
+	cout << "   Koch hierarchy on the same rays: " << rayCount / (kochTime * 1000.0) << " million rays per second (" << hits
+		<< " hits), " << mismatches << " different answers" << endl;
+}
+
+// the single level test: every segment box grown by the threshold, then the triangles of the boxes that hold the point
+static bool singleLevelPointCollision(Tube& tube, const glm::vec3& point, float threshold)
+{
+	for (int s = 0; s < tube.boundingBoxes.size(); s++)
+	{
+		glm::vec3 boxMin = tube.boundingBoxes[s][0] - glm::vec3(threshold);
+		glm::vec3 boxMax = tube.boundingBoxes[s][1] + glm::vec3(threshold);
+
+		if (point.x < boxMin.x || point.x > boxMax.x || point.y < boxMin.y || point.y > boxMax.y || point.z < boxMin.z || point.z > boxMax.z)
+			continue;
+
+		for (int j = 0; j < tube.trianglesInBoxe[s].size(); j++)
+		{
+			int i = tube.trianglesInBoxe[s][j];
+			float dist = glm::dot(point - tube.verts[tube.triangles[i].x], tube.norms[i]);
+
+			if (abs(dist) < threshold && tube.BarycentricCalculation(point, dist, i))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void Benchmarks::multiResolution(Tube& tube, int pointCount)
+{
+	cout << " Multi resolution collision benchmark: " << pointCount << " points along projectile flights" << endl;
+
+	MultiResolutionCollision multiResolution;
+	Stopwatch buildTimer;
+	multiResolution.build(tube);
+	double buildTime = buildTimer.value();
+
+	// projectile positions: somewhere between the firing point and the impact
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<glm::vec3> points(pointCount);
+	for (int i = 0; i < pointCount; i++)
+	{
+		glm::vec3 origin, direction;
+		float distance;
+		randomShot(tube, rng, origin, direction);
+		tube.rayCast(origin, direction, distance);
+		points[i] = origin + direction * (distance * unit(rng));
+	}
+
+	const float threshold = 9.0f;	// distance travelled by a missile in one frame
+	int hits = 0, kochHits = 0, singleHits = 0;
+	long long shellTests = 0, triangleTests = 0;
+
+	Stopwatch timer;
+	for (int i = 0; i < pointCount; i++)
+	{
+		hits += multiResolution.pointCollision(points[i], threshold, &shellTests, &triangleTests);
+	}
+	double multiTime = timer.value();
+
+	timer.reset();
+	for (int i = 0; i < pointCount; i++)
+	{
+		kochHits += tube.hierarchy.pointCollision(points[i], threshold);
+	}
+	double kochTime = timer.value();
+
+	timer.reset();
+	for (int i = 0; i < pointCount; i++)
+	{
+		singleHits += singleLevelPointCollision(tube, points[i], threshold);
+	}
+	double singleTime = timer.value();
+
+	// exhaustive triangle testing is the reference answer
+	int checked = pointCount < 2000 ? pointCount : 2000;
+	int mismatches = 0, exhaustiveHits = 0;
+	for (int i = 0; i < checked; i++)
+	{
+		bool exhaustive = linearPointCollision(tube, points[i], threshold);
+		exhaustiveHits += exhaustive;
+
+		if (multiResolution.pointCollision(points[i], threshold) != exhaustive)
+			mismatches++;
+	}
+	// the points near the wall are the ones where the shells have to be exact
+	int wallChecked = 0;
+	for (int i = 0; i < pointCount && wallChecked < 2000; i++)
+	{
+		if (singleLevelPointCollision(tube, points[i], threshold * 4.0f))
+		{
+			wallChecked++;
+			if (multiResolution.pointCollision(points[i], threshold * 4.0f) != linearPointCollision(tube, points[i], threshold * 4.0f))
+				mismatches++;
+		}
+	}
+
+	cout << "  build: " << buildTime << " ms" << endl;
+	cout << "  coarse to fine: " << multiTime / pointCount * 1000.0 << " us per point (" << hits << " hits), "
+		<< (double)shellTests / pointCount << " shells and " << (double)triangleTests / pointCount << " triangles per point" << endl;
+	cout << "  Koch hierarchy: " << kochTime / pointCount * 1000.0 << " us per point (" << kochHits << " hits)" << endl;
+	cout << "  single level boxes: " << singleTime / pointCount * 1000.0 << " us per point (" << singleHits << " hits), speedup "
+		<< singleTime / multiTime << "x" << endl;
+	cout << "  answers different from exhaustive testing: " << mismatches << " of " << checked + wallChecked
+		<< " (" << exhaustiveHits << " hits, " << wallChecked << " points near the wall)" << endl;
+}
+
+void Benchmarks::obstacleCollider(Tube& tube, int projectileCount, int obstacleCount, int frames)
+{
+	const float speed = 7.5f;		// a missile in one tick of the game
+
+	cout << " Obstacle collider benchmark: " << projectileCount << " projectiles, " << obstacleCount << " obstacles, " << frames << " frames" << endl;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> along(0.0f, tube.path.getLength());
+	std::uniform_real_distribution<float> offset(-tube.getRadius(), tube.getRadius());
+
+	// evenly along the path, spinning round it like the obstacles of the game
+	std::vector<glm::vec3> points(obstacleCount), directions(obstacleCount);
+	std::vector<float> speeds(obstacleCount);
+	for (int i = 0; i < obstacleCount; i++)
+	{
+		float s = (i + 0.5f) * tube.path.getLength() / obstacleCount;
+		points[i] = tube.path.position(s);
+		directions[i] = tube.path.tangent(s);
+		speeds[i] = (float)(rng() % 10 + 4);
+	}
+
+	ObstacleCollider collider;
+	collider.setProxy(glm::vec3(0.0f), glm::vec3(30.0f));
+
+	Stopwatch buildTimer;
+	collider.setObstacles(points, directions, speeds, tube.getRadius() * 0.7f);
+	double buildTime = buildTimer.value();
+
+	std::vector<glm::vec3> start(projectileCount), velocity(projectileCount);
+	for (int i = 0; i < projectileCount; i++)
+	{
+		start[i] = tube.path.position(along(rng)) + glm::vec3(offset(rng), offset(rng), offset(rng));
+		velocity[i] = randomDirection(rng) * speed;
+	}
+
+	//---every projectile against every obstacle---
+	int bruteHits = 0;
+	Stopwatch bruteTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < projectileCount; i++)
+		{
+			glm::vec3 p = start[i] + velocity[i] * (float)f;
+			for (int o = 0; o < obstacleCount; o++)
+			{
+				if (collider.insideProxy(o, p, f))
+				{
+					bruteHits++;
+					break;
+				}
+			}
+		}
+	}
+	double bruteTime = bruteTimer.value();
+
+	//---only the obstacles in the cell of the projectile---
+	int hashHits = 0;
+	long long candidates = 0;
+	Stopwatch hashTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < projectileCount; i++)
+		{
+			glm::vec3 p = start[i] + velocity[i] * (float)f;
+			if (collider.pointHit(p, f) >= 0)
+				hashHits++;
+		}
+	}
+	double hashTime = hashTimer.value();
+
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < projectileCount; i++)
+			candidates += collider.candidateCount(start[i] + velocity[i] * (float)f);
+	}
+
+	double pairs = (double)projectileCount * obstacleCount * frames;
+
+	cout << "  hash build: " << buildTime << " ms, " << collider.getCellCount() << " cells of " << 2.0f * collider.getRadius() << endl;
+	cout << "  every pair: " << bruteTime / frames << " ms per frame, " << bruteHits << " hits" << endl;
+	cout << "  spatial hash: " << hashTime / frames << " ms per frame, " << hashHits << " hits" << endl;
+	cout << "  pair tests: " << candidates << " of " << pairs << ", " << 100.0 * (1.0 - candidates / pairs) << "% avoided" << endl;
+}
@@ -0,0 +1,28 @@
+#include "Benchmarks.h"
+#include "../tube.h"
+
+#include <iostream>
+
+using namespace std;
+
+void Benchmarks::runHeadless(Tube& tube)
+{
+	cout << " Running benchmarks : " << endl;
+
+	projectilePool(tube, 10000, 60);
+	kochHierarchy(tube, 10000);
+	bvhRays(100000);
+	multiResolution(tube, 100000);
+	obstacleCollider(tube, 5000, 5000, 10);
+	playerPath(tube, 100000);
+	pathLookup(tube, 10000, 100);
+	simulationClock(100000);
+	obstacleTransforms(10000, 100);
+	obstacleIndex(10000, 10000);
+	looseOctree(50000, 100, 1000);
+	tubeOctree(tube, 10000);
+	vertexPacking(tube);
+	meshOptimization(tube);
+
+	cout << " Headless benchmarks finished " << endl;
+}
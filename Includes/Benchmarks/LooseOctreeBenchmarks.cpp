@@ -0,0 +1,166 @@
+#include "Benchmarks.h"
+#include "../Octree/LooseOctree.h"
+#include "../Time/Stopwatch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+void Benchmarks::looseOctree(int objectCount, int frames, int queryCount)
+{
+	const float worldHalfSize = 15000.0f;	// a 30000 edge flake
+
+	cout << " Loose octree benchmark: " << objectCount << " moving objects, " << frames << " frames, " << queryCount << " queries" << endl;
+
+	// mostly small fast objects like missiles, some the size of the player and some of the obstacles
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> coordinate(-worldHalfSize, worldHalfSize);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<glm::vec3> positions(objectCount), velocities(objectCount);
+	std::vector<float> radii(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		positions[i] = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+		velocities[i] = glm::vec3(unit(rng), unit(rng), unit(rng)) * 7.5f;
+		int kind = rng() % 10;
+		radii[i] = kind < 8 ? 2.0f : (kind < 9 ? 50.0f : 140.0f);
+	}
+
+	LooseOctree octree(glm::vec3(0.0f), worldHalfSize);
+	std::vector<int> ids(objectCount);
+
+	Stopwatch insertTimer;
+	for (int i = 0; i < objectCount; i++)
+		ids[i] = octree.insert(positions[i], radii[i]);
+	double insertTime = insertTimer.value();
+
+	//---every object moved each frame, only those leaving their cell change node---
+	long long relocated = 0;
+	Stopwatch updateTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < objectCount; i++)
+			positions[i] += velocities[i];
+
+		relocated += octree.update(ids, positions);
+	}
+	double updateTime = updateTimer.value();
+
+	//---the tree built again every frame---
+	LooseOctree rebuilt(glm::vec3(0.0f), worldHalfSize);
+	Stopwatch rebuildTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		rebuilt.clear();
+		for (int i = 0; i < objectCount; i++)
+			rebuilt.insert(positions[i], radii[i]);
+	}
+	double rebuildTime = rebuildTimer.value();
+
+	//---sphere, box and ray queries against testing every object---
+	std::vector<glm::vec3> queryPoints(queryCount), queryDirections(queryCount);
+	for (int q = 0; q < queryCount; q++)
+	{
+		queryPoints[q] = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+		queryDirections[q] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 0.01f));
+	}
+
+	const float queryRadius = 500.0f;
+	const float rayLength = 5000.0f;
+
+	std::vector<int> found;
+	long long sphereFound = 0, boxFound = 0, rayHits = 0;
+	Stopwatch queryTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		found.clear();
+		octree.querySphere(queryPoints[q], queryRadius, found);
+		sphereFound += found.size();
+
+		found.clear();
+		octree.queryBox(queryPoints[q] - glm::vec3(queryRadius), queryPoints[q] + glm::vec3(queryRadius), found);
+		boxFound += found.size();
+
+		float distance;
+		if (octree.rayCast(queryPoints[q], queryDirections[q], rayLength, distance) >= 0)
+			rayHits++;
+	}
+	double queryTime = queryTimer.value();
+
+	long long sphereBrute = 0, boxBrute = 0, rayBrute = 0;
+	Stopwatch bruteTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		glm::vec3 p = queryPoints[q];
+		float nearest = FLT_MAX;
+
+		for (int i = 0; i < objectCount; i++)
+		{
+			glm::vec3 d = positions[i] - p;
+			float reach = queryRadius + radii[i];
+			if (glm::dot(d, d) <= reach * reach)
+				sphereBrute++;
+
+			glm::vec3 outside = glm::max(glm::abs(d) - glm::vec3(queryRadius), glm::vec3(0.0f));
+			if (glm::dot(outside, outside) <= radii[i] * radii[i])
+				boxBrute++;
+
+			float b = -glm::dot(d, queryDirections[q]);
+			float c = glm::dot(d, d) - radii[i] * radii[i];
+			if ((c <= 0.0f || b <= 0.0f) && b * b - c >= 0.0f)
+			{
+				float root = sqrt(b * b - c);
+				nearest = glm::min(nearest, glm::max(-b - root, 0.0f));
+			}
+		}
+
+		if (nearest <= rayLength)
+			rayBrute++;
+	}
+	double bruteTime = bruteTimer.value();
+
+	cout << "  insert: " << insertTime << " ms, " << octree.getNodeCount() << " nodes" << endl;
+	cout << "  incremental update: " << updateTime / frames << " ms per frame, " << 100.0 * relocated / ((double)objectCount * frames) << "% of the objects changed node" << endl;
+	cout << "  rebuild: " << rebuildTime / frames << " ms per frame" << endl;
+	cout << "  octree queries: " << queryTime * 1000.0 / queryCount << " us per sphere, box and ray, found " << sphereFound << " " << boxFound << " " << rayHits << endl;
+	cout << "  every object: " << bruteTime * 1000.0 / queryCount << " us per sphere, box and ray, found " << sphereBrute << " " << boxBrute << " " << rayBrute << endl;
+
+	//---objects outside the world cube or larger than it must still be found---
+	LooseOctree small(glm::vec3(0.0f), 100.0f);
+	int outside = small.insert(glm::vec3(500.0f, 0.0f, 0.0f), 1.0f);
+	int large = small.insert(glm::vec3(0.0f), 300.0f);
+	int misses = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		found.clear();
+		small.querySphere(glm::vec3(500.0f, 0.0f, 2.0f), 2.0f, found);
+		misses += std::count(found.begin(), found.end(), outside) != 1;
+
+		found.clear();
+		small.queryBox(glm::vec3(499.0f, -1.0f, -1.0f), glm::vec3(501.0f, 1.0f, 1.0f), found);
+		misses += std::count(found.begin(), found.end(), outside) != 1;
+
+		found.clear();
+		small.querySphere(glm::vec3(0.0f, 250.0f, 0.0f), 1.0f, found);
+		misses += std::count(found.begin(), found.end(), large) != 1;
+
+		float distance;
+		misses += small.rayCast(glm::vec3(400.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1000.0f, distance) != outside;
+
+		// moved into the cube and back out again
+		small.move(outside, glm::vec3(50.0f, 0.0f, 0.0f));
+		found.clear();
+		small.querySphere(glm::vec3(50.0f, 0.0f, 2.0f), 2.0f, found);
+		misses += std::count(found.begin(), found.end(), outside) != 1;
+		small.move(outside, glm::vec3(500.0f, 0.0f, 0.0f));
+	}
+	small.remove(outside);
+	found.clear();
+	small.querySphere(glm::vec3(500.0f, 0.0f, 0.0f), 2.0f, found);
+	misses += !found.empty() || small.getObjectCount() != 1;
+	cout << "  objects outside the world cube, queries that missed them: " << misses << endl;
+}
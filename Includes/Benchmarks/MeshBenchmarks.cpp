@@ -0,0 +1,269 @@
+#include "Benchmarks.h"
+#include "../tube.h"
+#include "../Time/Stopwatch.h"
+#include "../Utilities/VertexPacking.h"
+#include "../Utilities/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// the map has steps of 1/32767 and stretches them by less than 2 on the sphere, with the nearest of the four points round
+// a normal it is at most 0.0025 degrees off
+const float Benchmarks::OCTAHEDRAL_NORMAL_ERROR = 2.0f / 32767.0f;
+
+// the angle in radians between two normals, from the cross product as the dot product is 1 in float for small angles
+static float normalAngle(const float a[3], const float b[3])
+{
+	float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	float cross[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	return atan2(sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot);
+}
+
+// the angle between a unit normal and its round trip through the octahedral map
+static float octahedralError(const float normal[3])
+{
+	short packed[2];
+	float decoded[3];
+	VertexPacking::packOctahedral(normal, packed);
+	VertexPacking::unpackOctahedral(packed, decoded);
+
+	return normalAngle(normal, decoded);
+}
+
+// the round trip of every short and half, and of random values, against the bounds of the formats
+static void packingRoundTrips(float maxNormalError)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> texCoord(-VertexPacking::MAX_HALF_TEXCOORD, VertexPacking::MAX_HALF_TEXCOORD);
+
+	//---snorm16, every short but -32768, which decodes to -1 like -32767, comes back---
+	int snormFailures = 0;
+	float snormError = 0.0f;
+	for (int i = -32767; i <= 32767; i++)
+		snormFailures += VertexPacking::packSnorm16(VertexPacking::unpackSnorm16((short)i)) != i;
+	for (int i = 0; i < 1000000; i++)
+	{
+		float value = unit(rng);
+		float error = fabs(VertexPacking::unpackSnorm16(VertexPacking::packSnorm16(value)) - value);
+		snormError = error > snormError ? error : snormError;
+	}
+	snormFailures += snormError > 0.5f / 32767.0f + 1e-7f;
+
+	//---halves, every half but the nans comes back, random values within half a step---
+	int halfFailures = 0;
+	float halfError = 0.0f;
+	for (int i = 0; i < 65536; i++)
+	{
+		bool nan = ((i >> 10) & 0x1f) == 31 && (i & 0x3ff) != 0;
+		halfFailures += !nan && VertexPacking::packHalf(VertexPacking::unpackHalf((unsigned short)i)) != i;
+	}
+	for (int i = 0; i < 1000000; i++)
+	{
+		float value = texCoord(rng);
+		float error = fabs(VertexPacking::unpackHalf(VertexPacking::packHalf(value)) - value);
+		float step = ldexp(1.0f, (int)floor(log2(fabs(value) > ldexp(1.0f, -14) ? fabs(value) : ldexp(1.0f, -14))) - 10);
+		halfError = error / step > halfError ? error / step : halfError;
+	}
+	halfFailures += halfError > 0.5f;
+	halfFailures += VertexPacking::packHalf(65504.0f) != 0x7bff || VertexPacking::packHalf(65520.0f) != 0x7c00;
+	halfFailures += VertexPacking::packHalf(ldexp(1.0f, -24)) != 1 || VertexPacking::packHalf(ldexp(1.0f, -25)) != 0;
+	halfFailures += VertexPacking::packHalf(-0.0f) != 0x8000;
+
+	//---octahedral normals, random ones, the axes and the folds of the map---
+	int normalFailures = 0;
+	float normalError = 0.0f;
+	std::vector<glm::vec3> normals;
+	for (int a = 0; a < 3; a++)
+	{
+		for (float s = -1.0f; s <= 1.0f; s += 2.0f)
+		{
+			glm::vec3 axis(0.0f);
+			axis[a] = s;
+			normals.push_back(axis);
+		}
+	}
+	for (int i = 0; i < 1000; i++)
+	{
+		float t = i / 999.0f;
+		normals.push_back(glm::normalize(glm::vec3(t, 1.0f - t, -1e-6f)));
+		normals.push_back(glm::normalize(glm::vec3(-t, t - 1.0f, -0.5f)));
+	}
+	while (normals.size() < 1000000)
+	{
+		glm::vec3 normal(unit(rng), unit(rng), unit(rng));
+		if (glm::length(normal) > 0.01f && glm::length(normal) <= 1.0f)
+			normals.push_back(glm::normalize(normal));
+	}
+	for (int i = 0; i < normals.size(); i++)
+	{
+		float error = octahedralError(&normals[i][0]);
+		normalError = error > normalError ? error : normalError;
+		normalFailures += error > maxNormalError;
+	}
+
+	cout << "  snorm16: largest error " << snormError * 32767.0f << " of a step, failures " << snormFailures << endl;
+	cout << "  half: largest error " << halfError << " of a step, failures " << halfFailures << endl;
+	cout << "  octahedral normals: largest error " << normalError * 180.0f / 3.14159265f << " degrees over " << normals.size()
+		<< " normals, failures " << normalFailures << endl;
+}
+
+// packs count vertices with the layout the model or tube chooses, decodes every one and checks it against the bounds
+
+void Benchmarks::meshPacking(const char* name, const float* positions, const float* normals, const float* texCoords, int count,
+	float maxPositionError, float maxNormalError, int bytesBefore)
+{
+	PackedVertexLayout layout = VertexPacking::chooseLayout(positions, texCoords, count, normals != NULL, maxPositionError);
+
+	Stopwatch packTimer;
+	std::vector<unsigned char> vertices;
+	VertexPacking::pack(layout, positions, normals, texCoords, count, vertices);
+	double packTime = packTimer.value();
+
+	float positionError = 0.0f, normalError = 0.0f, texCoordError = 0.0f;
+	int failures = 0;
+	for (int v = 0; v < count; v++)
+	{
+		float position[3], normal[3], texCoord[2];
+		VertexPacking::unpack(layout, &vertices[0], v, position, normal, texCoord);
+
+		for (int a = 0; a < 3; a++)
+		{
+			float error = fabs(position[a] - positions[v * 3 + a]);
+			positionError = error > positionError ? error : positionError;
+		}
+
+		if (normals != NULL)
+		{
+			float error = normalAngle(normal, &normals[v * 3]);
+			normalError = error > normalError ? error : normalError;
+		}
+
+		for (int a = 0; texCoords != NULL && a < 2; a++)
+		{
+			float error = fabs(texCoord[a] - texCoords[v * 2 + a]);
+			texCoordError = error > texCoordError ? error : texCoordError;
+		}
+	}
+
+	failures += positionError > VertexPacking::positionError(layout) + 1e-6f;
+	failures += normalError > maxNormalError;
+	failures += texCoordError > (layout.halfTexCoords ? VertexPacking::MAX_HALF_TEXCOORD / 2048.0f / 2.0f : 0.0f);
+
+	cout << "  " << name << ": " << count << " vertices, positions as " << (layout.quantizedPositions ? "shorts" : "floats")
+		<< (texCoords != NULL ? (layout.halfTexCoords ? ", texture coordinates as halves" : ", texture coordinates as floats") : "") << endl;
+	cout << "   " << bytesBefore << " bytes per vertex before, " << layout.stride << " now, " << (size_t)count * bytesBefore / 1024 << " KB before, "
+		<< vertices.size() / 1024 << " KB now, packed in " << packTime << " ms" << endl;
+	cout << "   largest error: position " << positionError << " (allowed " << maxPositionError << "), normal "
+		<< normalError * 180.0f / 3.14159265f << " degrees, texture coordinate " << texCoordError << ", failures " << failures << endl;
+}
+
+void Benchmarks::vertexPacking(Tube& tube)
+{
+	cout << " Vertex packing benchmark: float vertex lists against interleaved shorts and halves" << endl;
+
+	packingRoundTrips(OCTAHEDRAL_NORMAL_ERROR);
+
+	// the tube buffers held a position and a colour of floats, the colour is now a constant
+	if (!tube.verts.empty())
+		meshPacking("tube", &tube.verts[0][0], NULL, NULL, tube.verts.size(), tube.getMaxPositionError(), OCTAHEDRAL_NORMAL_ERROR, 6 * sizeof(float));
+}
+
+// the vertex cache, the vertex fetch and the overdraw of drawing indices in order
+void Benchmarks::drawStatistics(const char* order, const std::vector<unsigned int>& indices, int triangleCount, const std::vector<unsigned int>& triangleList,
+	const float* positions, int vertexCount, int vertexSize)
+{
+	VertexCacheStatistics fifo16 = MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), vertexCount, 16, triangleCount);
+	VertexCacheStatistics fifo32 = MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), vertexCount, 32, triangleCount);
+	float fetch = MeshOptimizer::analyzeVertexFetch(&indices[0], indices.size(), vertexCount, vertexSize);
+	OverdrawStatistics overdraw = MeshOptimizer::analyzeOverdraw(&triangleList[0], triangleList.size(), positions, 3, vertexCount);
+
+	cout << "   " << order << ": ACMR " << fifo16.acmr << " / " << fifo32.acmr << ", ATVR " << fifo16.atvr << " / " << fifo32.atvr
+		<< " (FIFO 16 / 32), vertex fetch " << fetch << "x the vertices, overdraw " << overdraw.overdraw << endl;
+}
+
+// the triangles of indices over positions, each as its three corners in sorted order so the winding does not count, in
+// a sorted list to compare orders with
+void Benchmarks::sortedTriangles(const std::vector<unsigned int>& indices, const float* positions, std::vector<std::vector<float> >& triangles)
+{
+	triangles.resize(indices.size() / 3);
+	for (int t = 0; t < triangles.size(); t++)
+	{
+		std::vector<std::vector<float> > corners(3);
+		for (int k = 0; k < 3; k++)
+			corners[k].assign(&positions[indices[t * 3 + k] * 3], &positions[indices[t * 3 + k] * 3] + 3);
+		std::sort(corners.begin(), corners.end());
+
+		triangles[t].clear();
+		for (int k = 0; k < 3; k++)
+			triangles[t].insert(triangles[t].end(), corners[k].begin(), corners[k].end());
+	}
+	std::sort(triangles.begin(), triangles.end());
+}
+
+void Benchmarks::meshOptimization(Tube& tube)
+{
+	cout << " Mesh optimization benchmark: the draw order of the tube triangles before and after the optimizer" << endl;
+
+	if (tube.verts.empty())
+		return;
+
+	// the tube was one strip, every index after the second a triangle, the degenerate ones between the segments too
+	std::vector<unsigned int> stripList(tube.triangles.size() * 3);
+	for (int i = 0; i < tube.triangles.size(); i++)
+	{
+		stripList[i * 3] = (unsigned int)tube.triangles[i].x;
+		stripList[i * 3 + 1] = (unsigned int)tube.triangles[i].y;
+		stripList[i * 3 + 2] = (unsigned int)tube.triangles[i].z;
+	}
+
+	int vertexSize = VertexPacking::chooseLayout(&tube.verts[0][0], NULL, tube.verts.size(), false, tube.getMaxPositionError()).stride;
+	cout << "  tube: " << tube.triangles.size() << " triangles, " << tube.verts.size() << " vertices of " << vertexSize << " bytes" << endl;
+	drawStatistics("strip", tube.tris, tube.triangles.size(), stripList, &tube.verts[0][0], tube.verts.size(), vertexSize);
+
+	// the strip as a list in vertex cache order, to compare with. The tube is drawn in lines, so the overdraw does not count.
+	std::vector<unsigned int> indices(stripList), remap;
+	for (int i = 1; i < tube.triangles.size(); i += 2)
+		std::swap(indices[i * 3], indices[i * 3 + 1]);
+	MeshOptimizer::optimizeVertexCache(&indices[0], indices.size(), tube.verts.size());
+	MeshOptimizer::optimizeVertexFetch(&indices[0], indices.size(), tube.verts.size(), remap);
+
+	std::vector<glm::vec3> orderedVerts(tube.verts.size());
+	for (int v = 0; v < tube.verts.size(); v++)
+		orderedVerts[remap[v]] = tube.verts[v];
+	drawStatistics("vertex cache ordered list", indices, tube.triangles.size(), indices, &orderedVerts[0][0], orderedVerts.size(), vertexSize);
+	cout << "   the strip is kept, a cache of 32 already holds the last two rings of it" << endl;
+
+	// the same triangles in no order, as some exporters write them, through the whole pass
+	std::vector<unsigned int> shuffled(stripList);
+	std::mt19937 rng(1);
+	for (int t = tube.triangles.size() - 1; t > 0; t--)
+	{
+		int other = rng() % (t + 1);
+		for (int k = 0; k < 3; k++)
+			std::swap(shuffled[t * 3 + k], shuffled[other * 3 + k]);
+	}
+	cout << "  tube triangles shuffled:" << endl;
+	drawStatistics("shuffled list", shuffled, tube.triangles.size(), shuffled, &tube.verts[0][0], tube.verts.size(), vertexSize);
+
+	std::vector<unsigned int> optimized(shuffled);
+	Stopwatch optimizeTimer;
+	MeshOptimizer::optimizeVertexCache(&optimized[0], optimized.size(), tube.verts.size());
+	MeshOptimizer::optimizeOverdraw(&optimized[0], optimized.size(), &tube.verts[0][0], 3, tube.verts.size(), 1.01f);
+	MeshOptimizer::optimizeVertexFetch(&optimized[0], optimized.size(), tube.verts.size(), remap);
+	double optimizeTime = optimizeTimer.value();
+
+	for (int v = 0; v < tube.verts.size(); v++)
+		orderedVerts[remap[v]] = tube.verts[v];
+	drawStatistics("optimized list", optimized, tube.triangles.size(), optimized, &orderedVerts[0][0], orderedVerts.size(), vertexSize);
+
+	// the same triangles must be drawn, only in another order
+	std::vector<std::vector<float> > trianglesBefore, trianglesAfter;
+	sortedTriangles(shuffled, &tube.verts[0][0], trianglesBefore);
+	sortedTriangles(optimized, &orderedVerts[0][0], trianglesAfter);
+	cout << "   the whole pass " << optimizeTime << " ms, triangles changed: " << (trianglesBefore == trianglesAfter ? 0 : 1) << endl;
+}
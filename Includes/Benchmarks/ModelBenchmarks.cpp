@@ -0,0 +1,537 @@
+#include "../gl/glew.h"
+#include "Benchmarks.h"
+#include "../tube.h"
+#include "../3DStruct/threeDModel.h"
+#include "../Octree/LinearOctree.h"
+#include "../Collision/BVH.h"
+#include "../Obj/OBJLoader.h"
+#include "../Time/Stopwatch.h"
+#include "../Utilities/IntersectionTests.h"
+#include "../Utilities/VertexPacking.h"
+#include "../Utilities/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// a ThreeDModel of the triangles of a tube of the game sizes, a mesh far larger than the shipped models
+static bool tubeModel(int dimension, ThreeDModel& model)
+{
+	Tube tube;
+	tube.constructGeometry(120.0f, 30000, dimension, 16);
+
+	model.numberOfVertices = tube.verts.size();
+	model.theVerts = new Vector3d[model.numberOfVertices];
+	for (int v = 0; v < model.numberOfVertices; v++)
+		model.theVerts[v] = Vector3d(tube.verts[v].x, tube.verts[v].y, tube.verts[v].z);
+
+	model.numberOfTriangles = tube.triangles.size();
+	model.theFaces = new aFace[model.numberOfTriangles];
+	for (int f = 0; f < model.numberOfTriangles; f++)
+	{
+		for (int k = 0; k < 3; k++)
+			model.theFaces[f].thePoints[k] = (unsigned int)tube.triangles[f][k];
+		model.theFaces[f].materialId = 0;
+	}
+
+	model.numberOfFaceNormals = model.numberOfTriangles;
+	model.theFaceNormals = new Vector3d[model.numberOfTriangles];
+	model.calcFaceNormals();
+
+	model.numberOfMatrials = 1;
+	model.theMaterials = new aMaterial[1];
+
+	return model.numberOfTriangles > 0;
+}
+
+// a stand-in for a model that is not in the tree, a sphere whose rings swell and shrink around it so the faces are not
+// all alike, of about the triangles of the shipped file. The two halves have their own textured material like ss6.
+static void standInModel(int rings, ThreeDModel& model)
+{
+	int segments = 2 * rings;
+	const float radius = 10.0f;
+
+	model.numberOfVertices = (rings + 1) * segments;
+	model.theVerts = new Vector3d[model.numberOfVertices];
+	for (int r = 0; r <= rings; r++)
+	{
+		for (int s = 0; s < segments; s++)
+		{
+			float theta = 3.14159265f * r / rings;
+			float phi = 2.0f * 3.14159265f * s / segments;
+			float swell = 1.0f + 0.3f * sin(5.0f * phi);
+			model.theVerts[r * segments + s] = Vector3d(radius * sin(theta) * cos(phi), radius * cos(theta) * swell, radius * sin(theta) * sin(phi));
+		}
+	}
+
+	// the texture coordinates have a column more, the seam gets its own
+	model.numberOfTexCoords = (rings + 1) * (segments + 1);
+	model.theTexCoords = new Vector2d[model.numberOfTexCoords];
+	for (int r = 0; r <= rings; r++)
+	{
+		for (int s = 0; s <= segments; s++)
+			model.theTexCoords[r * (segments + 1) + s] = Vector2d(float(s) / segments, float(r) / rings);
+	}
+
+	model.numberOfTriangles = 2 * rings * segments;
+	model.theFaces = new aFace[model.numberOfTriangles];
+	int f = 0;
+	for (int r = 0; r < rings; r++)
+	{
+		// the first vertex and texture coordinate of this ring and of the next, unsigned like the indices of a face
+		unsigned int row = r * segments, nextRow = (r + 1) * segments;
+		unsigned int texRow = r * (segments + 1), nextTexRow = (r + 1) * (segments + 1);
+
+		for (int s = 0; s < segments; s++)
+		{
+			unsigned int points[4] = { row + s, row + (s + 1) % segments, nextRow + s, nextRow + (s + 1) % segments };
+			unsigned int texCoords[4] = { texRow + s, texRow + s + 1, nextTexRow + s, nextTexRow + s + 1 };
+			const int corners[2][3] = { { 0, 2, 1 }, { 1, 2, 3 } };
+
+			for (int t = 0; t < 2; t++, f++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					model.theFaces[f].thePoints[k] = points[corners[t][k]];
+					model.theFaces[f].theTexCoord[k] = texCoords[corners[t][k]];
+				}
+				model.theFaces[f].theFaceNormal = f;
+				model.theFaces[f].materialId = r < rings / 2 ? 0 : 1;
+			}
+		}
+	}
+
+	model.numberOfFaceNormals = model.numberOfTriangles;
+	model.theFaceNormals = new Vector3d[model.numberOfTriangles];
+	model.calcFaceNormals();
+
+	model.numberOfMatrials = 2;
+	model.theMaterials = new aMaterial[2];
+	model.theMaterials[0].textureID = 1;
+	model.theMaterials[1].textureID = 2;
+}
+
+bool Benchmarks::loadModel(const char* path, ThreeDModel& model)
+{
+	ifstream file(path);
+	if (file)
+	{
+		file.close();
+		OBJLoader loader;
+		return loader.loadModel((char*)path, model);
+	}
+
+	// ss6 has 160000 triangles, the balls 6400
+	int rings = strstr(path, "ss6") != NULL ? 200 : 40;
+	standInModel(rings, model);
+	cout << "  " << path << " is not in the tree, a stand-in sphere of " << model.numberOfTriangles << " triangles takes its place" << endl;
+	return true;
+}
+
+// the loop calcVertNormals ran before, every face for every vertex, over the first vertexCount vertices
+static void quadraticNormals(ThreeDModel& model, int vertexCount, Vector3d* normals)
+{
+	for (int i = 0; i < vertexCount; i++)
+	{
+		Vector3d theNormal(0,0,0);
+		for (int j = 0; j < model.numberOfTriangles; j++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				if (model.theFaces[j].thePoints[k] == i)
+					theNormal = theNormal + model.theFaceNormals[model.theFaces[j].theFaceNormal];
+			}
+		}
+		theNormal.normalize();
+		normals[i] = theNormal;
+	}
+}
+
+// the loop the octree path ran for each leaf before, every face of the leaf for every vertex of the leaf
+static void quadraticLeafNormals(ThreeDModel& model, const int* VertList, int VertListSize, const int* TriList, int TriListSize, Vector3d* normals)
+{
+	for (int i = 0; i < VertListSize; i++)
+	{
+		Vector3d theNormal(0,0,0);
+		for (int j = 0; j < TriListSize; j++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				if (model.theFaces[TriList[j]].thePoints[k] == VertList[i])
+					theNormal = theNormal + model.theFaceNormals[model.theFaces[TriList[j]].theFaceNormal];
+			}
+		}
+		theNormal.normalize();
+		normals[VertList[i]] = theNormal;
+	}
+}
+
+static int differentNormals(const Vector3d* a, const Vector3d* b, int count)
+{
+	int different = 0;
+	for (int v = 0; v < count; v++)
+		different += a[v].x != b[v].x || a[v].y != b[v].y || a[v].z != b[v].z;
+
+	return different;
+}
+
+static void modelNormals(const char* name, ThreeDModel& model)
+{
+	Stopwatch buildTimer;
+	model.constructOctree();
+	double buildTime = buildTimer.value();
+
+	// the leaf lists the octree path read, which the build no longer makes
+	Stopwatch listTimer;
+	model.octree->buildVertexLists(model);
+	double listTime = listTimer.value();
+
+	//---the octree path as it was: the quadratic loop in every leaf---
+	std::vector<Vector3d> leafNormals(model.numberOfVertices);
+	Stopwatch leafTimer;
+	LinearOctree& octree = *model.octree;
+	for (int n = 0; n < octree.getNodeCount(); n++)
+	{
+		const LinearOctree::Node& node = octree.getNode(n);
+		if (octree.isLeaf(n) && octree.getVertexCount(n) > 0)
+			quadraticLeafNormals(model, octree.getVertices(n), octree.getVertexCount(n), octree.getPrimitives(n), node.primitiveCount, &leafNormals[0]);
+	}
+	double leafTime = leafTimer.value();
+
+	// the whole model loop takes minutes on these meshes, so it is timed on a part of the vertices
+	int sampleCount = model.numberOfVertices < 200 ? model.numberOfVertices : 200;
+	std::vector<Vector3d> quadratic(sampleCount > 0 ? sampleCount : 1);
+	Stopwatch quadraticTimer;
+	quadraticNormals(model, sampleCount, &quadratic[0]);
+	double quadraticTime = quadraticTimer.value() * model.numberOfVertices / (sampleCount > 0 ? sampleCount : 1);
+
+	//---the leaves with the sorted lookups, and the single pass over the faces with each weighting---
+	delete [] model.theVertNormals;
+	model.theVertNormals = new Vector3d[model.numberOfVertices];
+	model.numberOfVertNormals = model.numberOfVertices;
+
+	Stopwatch sortedLeafTimer;
+	octree.processVerticesByLeaf(&model);
+	double sortedLeafTime = sortedLeafTimer.value();
+	int sortedLeafDifferent = differentNormals(model.theVertNormals, &leafNormals[0], model.numberOfVertices);
+
+	Stopwatch uniformTimer;
+	model.calcVertNormals(WEIGHT_UNIFORM);
+	double uniformTime = uniformTimer.value();
+	int uniformDifferent = differentNormals(model.theVertNormals, &leafNormals[0], model.numberOfVertices);
+	int sampleDifferent = differentNormals(model.theVertNormals, &quadratic[0], sampleCount);
+
+	Stopwatch areaTimer;
+	model.calcVertNormals(WEIGHT_AREA);
+	double areaTime = areaTimer.value();
+
+	Stopwatch angleTimer;
+	model.calcVertNormals(WEIGHT_ANGLE);
+	double angleTime = angleTimer.value();
+
+	cout << "  " << name << ": " << model.numberOfVertices << " vertices, " << model.numberOfTriangles << " triangles, octree build " << buildTime << " ms" << endl;
+	cout << "   before: " << leafTime << " ms in the leaves of the octree, about " << quadraticTime << " ms over the whole model" << endl;
+	cout << "   leaves with sorted lookups: " << sortedLeafTime << " ms, one pass: " << uniformTime << " ms, weighted by area "
+		<< areaTime << " ms, by angle " << angleTime << " ms" << endl;
+	cout << "   load with the octree and normals: " << buildTime + listTime + leafTime << " ms before, " << buildTime + uniformTime << " ms now" << endl;
+	cout << "   normals different from before: " << sortedLeafDifferent << " in the leaves, " << uniformDifferent << " in one pass, "
+		<< sampleDifferent << " of the " << sampleCount << " of the whole model loop" << endl;
+}
+
+void Benchmarks::vertexNormals()
+{
+	cout << " Vertex normal benchmark: the quadratic loops against gathering the faces of each vertex" << endl;
+
+	ThreeDModel ship;
+	if (loadModel("Models/ss6.obj", ship))
+		modelNormals("Models/ss6.obj", ship);
+	else
+		cout << "  Models/ss6.obj could not be loaded" << endl;
+
+	ThreeDModel tube;
+	if (tubeModel(4, tube))
+		modelNormals("dimension 4 tube", tube);
+}
+
+// the lists initDrawElements wrote before the welding, 8 floats for every corner of every face
+static void deindexedCorners(const ThreeDModel& model, std::vector<float>& corners)
+{
+	corners.resize(model.numberOfTriangles * 3 * 8);
+	for (int f = 0; f < model.numberOfTriangles; f++)
+	{
+		const aFace& face = model.theFaces[f];
+		for (int k = 0; k < 3; k++)
+		{
+			float* corner = &corners[(f * 3 + k) * 8];
+			const Vector3d& position = model.theVerts[face.thePoints[k]];
+			const Vector3d& normal = model.numberOfVertNormals > 0 ? model.theVertNormals[face.thePoints[k]] : model.theFaceNormals[face.theFaceNormal];
+			corner[0] = position.x;
+			corner[1] = position.y;
+			corner[2] = position.z;
+			corner[3] = normal.x;
+			corner[4] = normal.y;
+			corner[5] = normal.z;
+			corner[6] = model.numberOfTexCoords > 0 ? model.theTexCoords[face.theTexCoord[k]].x : 0.0f;
+			corner[7] = model.numberOfTexCoords > 0 ? model.theTexCoords[face.theTexCoord[k]].y : 0.0f;
+		}
+	}
+}
+
+static void modelWelding(const char* name, ThreeDModel& model)
+{
+	model.calcVertNormals();
+
+	std::vector<float> corners;
+	Stopwatch deindexTimer;
+	deindexedCorners(model, corners);
+	double deindexTime = deindexTimer.value();
+
+	Stopwatch weldTimer;
+	model.initDrawElements();
+	double weldTime = weldTimer.value();
+
+	// every corner must draw the vertex it drew before
+	int mismatches = 0;
+	size_t indexBytes = 0;
+	int shortBatches = 0;
+	for (unsigned int i = 0; i < model.length.size(); i += 3)
+	{
+		int batch = i / 3;
+		int count = model.length[i + 1] - model.length[i] + 3;
+		for (int c = model.length[i]; c < model.length[i] + count; c++)
+		{
+			int v = model.baseVertices[batch] + model.faceIDsList[c];
+			const float* corner = &corners[c * 8];
+			for (int a = 0; a < 3; a++)
+			{
+				mismatches += model.vertexPositionList[v * 3 + a] != corner[a] || model.vertexNormalList[v * 3 + a] != corner[3 + a];
+			}
+			for (int a = 0; a < 2; a++)
+			{
+				mismatches += model.vertexTexCoordList[v * 2 + a] != corner[6 + a];
+			}
+		}
+
+		bool shortIndices = model.indexTypes[batch] == GL_UNSIGNED_SHORT;
+		indexBytes += count * (shortIndices ? 2 : 4);
+		shortBatches += shortIndices;
+	}
+
+	int cornerCount = model.numberOfTriangles * 3;
+	size_t vertexBytesBefore = (size_t)cornerCount * 8 * sizeof(float);
+	size_t vertexBytesAfter = (size_t)model.numberOfDrawVertices * 8 * sizeof(float);
+	size_t indexBytesBefore = (size_t)cornerCount * sizeof(unsigned int);
+
+	cout << "  " << name << ": " << cornerCount << " corners welded into " << model.numberOfDrawVertices << " vertices ("
+		<< model.numberOfVertices << " positions), " << shortBatches << " of " << model.length.size() / 3 << " materials with 16 bit indices" << endl;
+	cout << "   vertex memory " << vertexBytesBefore / 1024 << " KB before, " << vertexBytesAfter / 1024 << " KB now ("
+		<< (double)vertexBytesBefore / (vertexBytesAfter > 0 ? vertexBytesAfter : 1) << "x less), indices " << indexBytesBefore / 1024
+		<< " KB before, " << indexBytes / 1024 << " KB now" << endl;
+	cout << "   vertex and index memory " << (double)(vertexBytesBefore + indexBytesBefore) / (vertexBytesAfter + indexBytes)
+		<< "x less, at least " << model.numberOfDrawVertices << " vertex shader runs instead of " << cornerCount << endl;
+	cout << "   de-indexing " << deindexTime << " ms, welding " << weldTime << " ms, corners drawing another vertex: " << mismatches << endl;
+}
+
+void Benchmarks::vertexWelding()
+{
+	cout << " Vertex welding benchmark: a vertex for every corner against the corners welded into shared vertices" << endl;
+
+	ThreeDModel ship;
+	if (loadModel("Models/ss6.obj", ship))
+		modelWelding("Models/ss6.obj", ship);
+	else
+		cout << "  Models/ss6.obj could not be loaded" << endl;
+
+	ThreeDModel tube;
+	if (tubeModel(4, tube))
+		modelWelding("dimension 4 tube", tube);
+}
+
+void Benchmarks::modelPacking(const char* name, ThreeDModel& model, float maxNormalError)
+{
+	model.calcVertNormals();
+	model.initDrawElements();
+
+	// the lists initVBO uploaded before, a position, normal and texture coordinate of floats
+	meshPacking(name, model.vertexPositionList, model.vertexNormalList, model.vertexTexCoordList, model.numberOfDrawVertices,
+		ThreeDModel::MAX_POSITION_ERROR, maxNormalError, 8 * sizeof(float));
+}
+
+
+
+void Benchmarks::modelVertexPacking()
+{
+	cout << " Model vertex packing benchmark: the float vertex lists of the models against the packed layout each chooses" << endl;
+
+	ThreeDModel ship;
+	if (loadModel("Models/ss6.obj", ship))
+		modelPacking("Models/ss6.obj", ship, OCTAHEDRAL_NORMAL_ERROR);
+	else
+		cout << "  Models/ss6.obj could not be loaded" << endl;
+
+	ThreeDModel tubeMesh;
+	if (tubeModel(4, tubeMesh))
+		modelPacking("dimension 4 tube as a model", tubeMesh, OCTAHEDRAL_NORMAL_ERROR);
+}
+
+void Benchmarks::modelOptimization(const char* name, ThreeDModel& model)
+{
+	model.calcVertNormals();
+	model.initDrawElements();
+	int vertexSize = VertexPacking::chooseLayout(model.vertexPositionList, model.vertexTexCoordList, model.numberOfDrawVertices, true,
+		ThreeDModel::MAX_POSITION_ERROR).stride;
+
+	// the indices of all the materials counted from the first vertex, as the draws read them one after the other
+	std::vector<unsigned int> indices(model.numberOfTriangles * 3);
+	for (unsigned int i = 0; i < model.length.size(); i += 3)
+	{
+		int count = model.length[i + 1] - model.length[i] + 3;
+		for (int c = model.length[i]; c < model.length[i] + count; c++)
+			indices[c] = model.baseVertices[i / 3] + model.faceIDsList[c];
+	}
+
+	cout << "  " << name << ": " << model.numberOfTriangles << " triangles, " << model.numberOfDrawVertices << " vertices of "
+		<< vertexSize << " bytes, " << model.length.size() / 3 << " materials" << endl;
+	drawStatistics("welded order", indices, model.numberOfTriangles, indices, model.vertexPositionList, model.numberOfDrawVertices, vertexSize);
+
+	// the vertex cache order alone, to see what the overdraw order costs and gives
+	std::vector<unsigned int> cacheOrder = indices;
+	std::vector<unsigned int> remap;
+	Stopwatch cacheTimer;
+	for (unsigned int i = 0; i < model.length.size(); i += 3)
+	{
+		int count = model.length[i + 1] - model.length[i] + 3;
+		MeshOptimizer::optimizeVertexCache(&cacheOrder[model.length[i]], count, model.numberOfDrawVertices);
+	}
+	double cacheTime = cacheTimer.value();
+	drawStatistics("vertex cache order", cacheOrder, model.numberOfTriangles, cacheOrder, model.vertexPositionList, model.numberOfDrawVertices, vertexSize);
+
+	std::vector<std::vector<float> > trianglesBefore, trianglesAfter;
+	sortedTriangles(indices, model.vertexPositionList, trianglesBefore);
+
+	Stopwatch optimizeTimer;
+	int reordered = model.optimizeDrawElements();
+	double optimizeTime = optimizeTimer.value();
+
+	for (unsigned int i = 0; i < model.length.size(); i += 3)
+	{
+		int count = model.length[i + 1] - model.length[i] + 3;
+		for (int c = model.length[i]; c < model.length[i] + count; c++)
+			indices[c] = model.baseVertices[i / 3] + model.faceIDsList[c];
+	}
+	drawStatistics("drawn order", indices, model.numberOfTriangles, indices, model.vertexPositionList, model.numberOfDrawVertices, vertexSize);
+
+	// the same triangles must be drawn, only in another order
+	sortedTriangles(indices, model.vertexPositionList, trianglesAfter);
+	cout << "   vertex cache order " << cacheTime << " ms, the whole pass " << optimizeTime << " ms, " << reordered << " of "
+		<< model.length.size() / 3 << " materials reordered, triangles changed: " << (trianglesBefore == trianglesAfter ? 0 : 1) << endl;
+}
+
+void Benchmarks::modelMeshOptimization()
+{
+	cout << " Model mesh optimization benchmark: the draw order of the model triangles and vertices before and after the optimizer" << endl;
+
+	ThreeDModel ship;
+	if (loadModel("Models/ss6.obj", ship))
+		modelOptimization("Models/ss6.obj", ship);
+	else
+		cout << "  Models/ss6.obj could not be loaded" << endl;
+
+	ThreeDModel tubeMesh;
+	if (tubeModel(4, tubeMesh))
+		modelOptimization("dimension 4 tube as a model", tubeMesh);
+
+	// the faces in no order, as some exporters write them
+	ThreeDModel shuffledMesh;
+	if (tubeModel(4, shuffledMesh))
+	{
+		std::mt19937 rng(1);
+		std::shuffle(shuffledMesh.theFaces, shuffledMesh.theFaces + shuffledMesh.numberOfTriangles, rng);
+		shuffledMesh.calcFaceNormals();
+		modelOptimization("dimension 4 tube with its faces shuffled", shuffledMesh);
+	}
+}
+
+void Benchmarks::modelRays(const char* path, int rayCount)
+{
+	ThreeDModel model;
+	if (!loadModel(path, model))
+	{
+		cout << "  " << path << " could not be loaded" << endl;
+		return;
+	}
+
+	BVH bvh;
+	Stopwatch buildTimer;
+	std::vector<BVHTriangle> faces(model.numberOfTriangles);
+	for (int f = 0; f < model.numberOfTriangles; f++)
+	{
+		const Vector3d& a = model.theVerts[model.theFaces[f].thePoints[0]];
+		const Vector3d& b = model.theVerts[model.theFaces[f].thePoints[1]];
+		const Vector3d& c = model.theVerts[model.theFaces[f].thePoints[2]];
+
+		faces[f].v0 = glm::vec3(a.x, a.y, a.z);
+		faces[f].v1 = glm::vec3(b.x, b.y, b.z);
+		faces[f].v2 = glm::vec3(c.x, c.y, c.z);
+	}
+	bvh.buildFromTriangles(faces);
+	double buildTime = buildTimer.value();
+
+	double minX, minY, minZ, maxX, maxY, maxZ;
+	model.calcBoundingBox(minX, minY, minZ, maxX, maxY, maxZ);
+	glm::vec3 boxMin(minX, minY, minZ), boxMax(maxX, maxY, maxZ);
+
+	// rays from a sphere around the box aimed at random points inside it, so most of them reach the mesh
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	glm::vec3 centre = (boxMin + boxMax) * 0.5f;
+	float distance = glm::length(boxMax - boxMin);
+
+	std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+	for (int i = 0; i < rayCount; i++)
+	{
+		glm::vec3 target = boxMin + (boxMax - boxMin) * glm::vec3(unit(rng), unit(rng), unit(rng));
+		origins[i] = centre + randomDirection(rng) * distance;
+		directions[i] = glm::normalize(target - origins[i]);
+	}
+
+	rayThroughput(path, bvh, buildTime, origins, directions, 4.0f * glm::length(boxMax - boxMin));
+
+	// the closest hit has to be the same as the one found by testing every face
+	int mismatches = 0;
+	int checked = rayCount < 1000 ? rayCount : 1000;
+	for (int i = 0; i < checked; i++)
+	{
+		float best = 1e30f;
+		for (int f = 0; f < model.numberOfTriangles; f++)
+		{
+			float t, u, v;
+			Vector3d& a = model.theVerts[model.theFaces[f].thePoints[0]];
+			Vector3d& b = model.theVerts[model.theFaces[f].thePoints[1]];
+			Vector3d& c = model.theVerts[model.theFaces[f].thePoints[2]];
+
+			if (IntersectionTests::rayTriangleIntersect(&origins[i][0], &directions[i][0], &a.x, &b.x, &c.x, t, u, v) && t >= 0.0f && t < best)
+				best = t;
+		}
+
+		float distance;
+		bool hit = bvh.rayCast(origins[i], directions[i], 1e30f, distance);
+
+		if (hit != (best < 1e30f) || (hit && abs(distance - best) > 0.001f * best))
+			mismatches++;
+	}
+	cout << "   closest hits different from testing every face: " << mismatches << " of " << checked << endl;
+}
+
+void Benchmarks::modelBvhRays(int rayCount)
+{
+	cout << " Model BVH benchmark: " << rayCount << " rays per model, one thread" << endl;
+
+	modelRays("Models/ss6.obj", rayCount);
+	modelRays("Models/ball.obj", rayCount);
+}
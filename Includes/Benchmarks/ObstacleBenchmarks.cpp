@@ -0,0 +1,171 @@
+#include "Benchmarks.h"
+#include "../Obstacles/ObstacleTransforms.h"
+#include "../Obstacles/ObstacleIndex.h"
+#include "../Time/Stopwatch.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+void Benchmarks::obstacleTransforms(int obstacleCount, int frames)
+{
+	const float offset = 84.0f;		// 0.7 of the tube radius of the game
+
+	cout << " Obstacle transform benchmark: " << obstacleCount << " obstacles, " << frames << " frames" << endl;
+
+	// obstacles scattered through a box the size of a 30000 edge flake
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> coordinate(-15000.0f, 15000.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<glm::vec3> points(obstacleCount), directions(obstacleCount);
+	std::vector<float> speeds(obstacleCount);
+	for (int i = 0; i < obstacleCount; i++)
+	{
+		points[i] = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+		directions[i] = glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 2.0f);
+		speeds[i] = (float)(rng() % 10 + 4);
+	}
+
+	ObstacleTransforms transforms;
+	transforms.setObstacles(points, directions, speeds, offset, 50.0f);
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(60.0f, 1.0f, 1.0f, 3000.0f);
+	const float timeStep = 0.833f;
+
+	//---the matrix chain and normal matrix of every obstacle, as display() did for each draw---
+	transforms.showAll();
+	glm::mat3 normalSum(0.0f);
+	Stopwatch chainTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < obstacleCount; i++)
+		{
+			glm::mat4 m = glm::translate(view, points[i]);
+			m = glm::rotate(m, ObstacleTransforms::spinAngle(speeds[i], f * timeStep), directions[i]);
+			m = glm::translate(m, glm::vec3(0.0f, -offset, 0.0f));
+			normalSum += glm::inverseTranspose(glm::mat3(m));
+		}
+	}
+	double chainTime = chainTimer.value();
+
+	//---all of them with the SSE build---
+	Stopwatch allTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		transforms.build(f * timeStep);
+	}
+	double allTime = allTimer.value();
+
+	std::vector<glm::mat4> reference;
+	transforms.buildReference((frames - 1) * timeStep, reference);
+
+	float maxError = 0.0f;
+	for (int i = 0; i < obstacleCount; i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			for (int r = 0; r < 4; r++)
+				maxError = glm::max(maxError, glm::abs(transforms.getTransforms()[i][c][r] - reference[i][c][r]));
+		}
+	}
+
+	//---culled against a camera at the centre, then only the visible ones---
+	int visible = 0;
+	Stopwatch cullTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		visible = transforms.cull(projection * view);
+	}
+	double cullTime = cullTimer.value();
+
+	Stopwatch visibleTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		transforms.build(f * timeStep);
+	}
+	double visibleTime = visibleTimer.value();
+
+	cout << "  matrix chain and inverse transpose per obstacle: " << chainTime / frames << " ms per frame (" << normalSum[0][0] << ")" << endl;
+	cout << "  SSE build of all obstacles: " << allTime / frames << " ms per frame, max difference to glm " << maxError << endl;
+	cout << "  frustum cull: " << cullTime / frames << " ms per frame, " << visible << " visible" << endl;
+	cout << "  SSE build of the visible obstacles: " << visibleTime / frames << " ms per frame" << endl;
+}
+
+void Benchmarks::obstacleIndex(int obstacleCount, int queries)
+{
+	const float pathLength = 120000.0f;		// a 30000 edge flake
+	const float reach = 500.0f;
+
+	cout << " Obstacle index benchmark: " << obstacleCount << " obstacles, " << queries << " queries" << endl;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> along(0.0f, pathLength);
+
+	std::vector<float> distances(obstacleCount);
+	std::vector<glm::vec3> points(obstacleCount), directions(obstacleCount, glm::vec3(0.0f, 0.0f, 1.0f));
+	std::vector<float> speeds(obstacleCount, 5.0f);
+	for (int i = 0; i < obstacleCount; i++)
+	{
+		distances[i] = along(rng);
+		points[i] = glm::vec3(distances[i], 0.0f, 0.0f);
+	}
+
+	ObstacleIndex index;
+	Stopwatch buildTimer;
+	index.build(pathLength, distances, points, directions, speeds);
+	double buildTime = buildTimer.value();
+
+	// the query point goes round the path twice
+	float step = 2.0f * pathLength / queries;
+
+	//---every obstacle tested---
+	long long scanFound = 0;
+	std::vector<int> near;
+	Stopwatch scanTimer;
+	for (int q = 0; q < queries; q++)
+	{
+		float s = fmod(q * step, pathLength);
+		near.clear();
+		for (int i = 0; i < obstacleCount; i++)
+		{
+			float d = glm::abs(distances[i] - s);
+			if (glm::min(d, pathLength - d) <= reach)
+				near.push_back(i);
+		}
+		scanFound += near.size();
+	}
+	double scanTime = scanTimer.value();
+
+	//---two binary searches---
+	long long rangeFound = 0;
+	Stopwatch rangeTimer;
+	for (int q = 0; q < queries; q++)
+	{
+		float s = fmod(q * step, pathLength);
+		near.clear();
+		index.range(s - reach, s + reach, near);
+		rangeFound += near.size();
+	}
+	double rangeTime = rangeTimer.value();
+
+	//---the cursor following the point---
+	int cursor = 0;
+	long long cursorSum = 0;
+	Stopwatch cursorTimer;
+	for (int q = 0; q < queries; q++)
+	{
+		cursorSum += index.advance(cursor, fmod(q * step, pathLength));
+	}
+	double cursorTime = cursorTimer.value();
+
+	cout << "  build: " << buildTime << " ms" << endl;
+	cout << "  linear scan: " << scanTime * 1000.0 / queries << " us per query, " << scanFound << " found" << endl;
+	cout << "  range query: " << rangeTime * 1000.0 / queries << " us per query, " << rangeFound << " found" << endl;
+	cout << "  cursor: " << cursorTime * 1000.0 / queries << " us per step (" << cursorSum << ")" << endl;
+}
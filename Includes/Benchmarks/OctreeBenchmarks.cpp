@@ -0,0 +1,371 @@
+#include "../gl/glew.h"
+#include "Benchmarks.h"
+#include "../Octree/LinearOctree.h"
+#include "../Octree/SpatialOctree.h"
+#include "../Octree/Octree.h"
+#include "../3DStruct/threeDModel.h"
+#include "../Time/Stopwatch.h"
+#include "../Utilities/IntersectionTests.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+
+using namespace std;
+
+// the build ThreeDModel::constructOctree did before the linear octree
+static Octree* buildLegacyOctree(ThreeDModel& model)
+{
+	double minX, minY, minZ, maxX, maxY, maxZ;
+	model.calcBoundingBox(minX, minY, minZ, maxX, maxY, maxZ);
+
+	Octree* octree = new Octree();
+	octree->start(0, minX, minY, minZ, maxX, maxY, maxZ, &model);
+
+	vector<Octree*> stackOctree;
+	stackOctree.push_back(octree);
+
+	while (stackOctree.size() > 0)
+	{
+		Octree* oct = stackOctree[0];
+		oct->CreateChildren(stackOctree, &model);
+
+		stackOctree.erase(stackOctree.begin());
+	}
+
+	return octree;
+}
+
+// the triangles and vertices of a leaf, keyed by its lowest corner
+typedef std::map<std::vector<float>, std::pair<std::vector<int>, std::vector<int> > > LeafLists;
+
+// walks the legacy tree for its leaves, the bytes of its lists and nodes, and the largest scratch of CreateChildren
+static void legacyLeaves(Octree* node, LeafLists& leaves, size_t& bytes, size_t& scratch)
+{
+	int primitiveCount = node->getPrimitiveListSize() > 0 ? node->getPrimitiveListSize() : 0;
+	int vertexCount = node->getVertexListSize() > 0 ? node->getVertexListSize() : 0;
+	bytes += sizeof(Octree) + (primitiveCount + vertexCount) * sizeof(int);
+
+	if (node->getLevel() >= MAX_DEPTH)
+	{
+		double min[3];
+		node->getMinValues(min);
+
+		std::vector<float> corner(min, min + 3);
+		leaves[corner].first.assign(node->getPrimitiveList(), node->getPrimitiveList() + primitiveCount);
+		leaves[corner].second.assign(node->getVertexList(), node->getVertexList() + vertexCount);
+		return;
+	}
+
+	// eight lists as long as the node's own, for both the triangles and the vertices
+	scratch = std::max(scratch, 8 * (primitiveCount + vertexCount) * sizeof(int));
+
+	for (int i = 0; i < 8; i++)
+	{
+		if (node->getChild(i) != NULL)
+			legacyLeaves(node->getChild(i), leaves, bytes, scratch);
+	}
+}
+
+static void compareOctreeBuilds(const char* path)
+{
+	ThreeDModel model;
+	if (!Benchmarks::loadModel(path, model))
+	{
+		cout << "  " << path << " could not be loaded" << endl;
+		return;
+	}
+
+	Stopwatch legacyTimer;
+	Octree* legacy = buildLegacyOctree(model);
+	double legacyTime = legacyTimer.value();
+
+	LinearOctree linear;
+	Stopwatch linearTimer;
+	linear.build(model, LinearOctree::BuildParameters::uniform(MAX_DEPTH));
+	double linearTime = linearTimer.value();
+
+	LinearOctree adaptive;
+	Stopwatch adaptiveTimer;
+	adaptive.build(model);
+	double adaptiveTime = adaptiveTimer.value();
+	LinearOctree::Statistics adaptiveStatistics = adaptive.getStatistics();
+	LinearOctree::Statistics linearStatistics = linear.getStatistics();
+	size_t linearBytes = linear.getMemoryUsed(), linearPeak = linear.getPeakBuildMemory();
+
+	// the vertex lists only to compare the leaves, the game does not build them
+	linear.buildVertexLists(model);
+
+	LeafLists legacyLists;
+	size_t legacyBytes = 0, legacyScratch = 0;
+	legacyLeaves(legacy, legacyLists, legacyBytes, legacyScratch);
+
+	// the same leaves, with the same lists in the same order
+	int leafCount = 0;
+	int mismatches = 0;
+	for (int n = 0; n < linear.getNodeCount(); n++)
+	{
+		if (!linear.isLeaf(n))
+			continue;
+
+		const LinearOctree::Node& node = linear.getNode(n);
+		std::vector<float> corner(node.min, node.min + 3);
+		std::vector<int> primitives(linear.getPrimitives(n), linear.getPrimitives(n) + node.primitiveCount);
+		std::vector<int> vertices(linear.getVertices(n), linear.getVertices(n) + linear.getVertexCount(n));
+
+		LeafLists::iterator found = legacyLists.find(corner);
+		if (found == legacyLists.end() || found->second.first != primitives || found->second.second != vertices)
+			mismatches++;
+		leafCount++;
+	}
+	mismatches += abs((int)legacyLists.size() - leafCount);
+
+	legacy->Delete();
+	delete legacy;
+
+	cout << "  " << path << ": " << model.numberOfTriangles << " triangles, " << leafCount << " leaves" << endl;
+	cout << "   octree: " << legacyTime << " ms, " << legacyBytes / 1024 << " KB, at least " << (legacyBytes + legacyScratch) / 1024 << " KB during the build" << endl;
+	cout << "   linear octree: " << linearTime << " ms, " << linearBytes / 1024 << " KB, " << linearPeak / 1024
+		<< " KB during the build" << endl;
+	cout << "   leaves different from the octree: " << mismatches << ", " << linearStatistics.averageLeafPrimitives << " triangles per leaf on average and "
+		<< linearStatistics.maxLeafPrimitives << " at most" << endl;
+	cout << "   adaptive octree: " << adaptiveTime << " ms, " << adaptiveStatistics.memory / 1024 << " KB, " << adaptiveStatistics.nodeCount << " nodes, "
+		<< adaptiveStatistics.leafCount << " leaves, depth " << adaptiveStatistics.depth << ", " << adaptiveStatistics.averageLeafPrimitives
+		<< " triangles per leaf on average and " << adaptiveStatistics.maxLeafPrimitives << " at most" << endl;
+}
+
+void Benchmarks::octreeBuild()
+{
+	LinearOctree::BuildParameters parameters;
+	cout << " Octree build benchmark: depth " << MAX_DEPTH << ", adaptive up to depth " << parameters.maxDepth << " and " << parameters.maxLeafPrimitives
+		<< " triangles per leaf, " << std::thread::hardware_concurrency() << " threads" << endl;
+
+	compareOctreeBuilds("Models/ss6.obj");
+	compareOctreeBuilds("Models/ball.obj");
+	compareOctreeBuilds("Models/ball2.obj");
+}
+
+// the test of ThreeDModel::collisionBetweenPoint on face f, with the normal from the vertices
+static bool pointNearFace(ThreeDModel& model, int f, const glm::vec3& point, float threshold)
+{
+	Vector3d& a = model.theVerts[model.theFaces[f].thePoints[0]];
+	Vector3d& b = model.theVerts[model.theFaces[f].thePoints[1]];
+	Vector3d& c = model.theVerts[model.theFaces[f].thePoints[2]];
+	glm::vec3 v0(a.x, a.y, a.z), v1(b.x, b.y, b.z), v2(c.x, c.y, c.z);
+
+	glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+	if (glm::dot(normal, normal) == 0.0f)
+		return false;
+	normal = glm::normalize(normal);
+
+	float dist = glm::dot(point - v0, normal);
+	if (abs(dist) >= threshold)
+		return false;
+
+	glm::vec3 p = point - normal * dist - v0;
+	glm::vec3 edge0 = v2 - v0, edge1 = v1 - v0;
+	float dot00 = glm::dot(edge0, edge0), dot01 = glm::dot(edge0, edge1), dot02 = glm::dot(edge0, p);
+	float dot11 = glm::dot(edge1, edge1), dot12 = glm::dot(edge1, p);
+	float invDenom = 1.0f / (dot00 * dot11 - dot01 * dot01);
+	float u = (dot11 * dot02 - dot01 * dot12) * invDenom;
+	float v = (dot00 * dot12 - dot01 * dot02) * invDenom;
+
+	return u >= 0.0f && v >= 0.0f && u + v < 1.0f;
+}
+
+static void modelQueries(const char* path, int queryCount)
+{
+	ThreeDModel model;
+	if (!Benchmarks::loadModel(path, model))
+	{
+		cout << "  " << path << " could not be loaded" << endl;
+		return;
+	}
+
+	LinearOctree octree;
+	Stopwatch buildTimer;
+	octree.build(model);
+	double buildTime = buildTimer.value();
+
+	double minX, minY, minZ, maxX, maxY, maxZ;
+	model.calcBoundingBox(minX, minY, minZ, maxX, maxY, maxZ);
+	glm::vec3 boxMin(minX, minY, minZ), boxMax(maxX, maxY, maxZ);
+	float size = glm::length(boxMax - boxMin);
+	float threshold = 0.01f * size;
+	float radius = 0.02f * size;
+
+	//---half the points near the surface, half anywhere in the box, and rays from outside through the box---
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<glm::vec3> points(queryCount), origins(queryCount), directions(queryCount);
+	for (int q = 0; q < queryCount; q++)
+	{
+		glm::vec3 inBox = boxMin + (boxMax - boxMin) * glm::vec3(unit(rng), unit(rng), unit(rng));
+		if (q % 2 == 0 && model.numberOfTriangles > 0)
+		{
+			int f = rng() % model.numberOfTriangles;
+			float u = unit(rng), v = unit(rng);
+			if (u + v > 1.0f)
+			{
+				u = 1.0f - u;
+				v = 1.0f - v;
+			}
+			Vector3d& a = model.theVerts[model.theFaces[f].thePoints[0]];
+			Vector3d& b = model.theVerts[model.theFaces[f].thePoints[1]];
+			Vector3d& c = model.theVerts[model.theFaces[f].thePoints[2]];
+			glm::vec3 v0(a.x, a.y, a.z), v1(b.x, b.y, b.z), v2(c.x, c.y, c.z);
+			glm::vec3 offset = glm::vec3(unit(rng), unit(rng), unit(rng)) - glm::vec3(0.5f);
+			points[q] = v0 + (v1 - v0) * u + (v2 - v0) * v + offset * 4.0f * threshold;
+		}
+		else
+		{
+			points[q] = inBox;
+		}
+
+		glm::vec3 away = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) - glm::vec3(0.5f));
+		origins[q] = (boxMin + boxMax) * 0.5f + away * size;
+		directions[q] = glm::normalize(inBox - origins[q]);
+	}
+
+	long long pointHits = 0, sphereHits = 0, rayHits = 0;
+	Stopwatch octreeTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		pointHits += octree.pointCollision(points[q], threshold);
+		sphereHits += octree.sphereCollision(points[q], radius);
+
+		float distance;
+		rayHits += octree.rayCast(origins[q], directions[q], 2.0f * size, distance) >= 0;
+	}
+	double octreeTime = octreeTimer.value();
+
+	//---every face, counting the answers the octree got wrong---
+	long long pointBrute = 0, sphereBrute = 0, rayBrute = 0;
+	int mismatches = 0;
+	Stopwatch bruteTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		bool pointHit = false, sphereHit = false;
+		float nearest = 2.0f * size;
+		for (int f = 0; f < model.numberOfTriangles; f++)
+		{
+			Vector3d& a = model.theVerts[model.theFaces[f].thePoints[0]];
+			Vector3d& b = model.theVerts[model.theFaces[f].thePoints[1]];
+			Vector3d& c = model.theVerts[model.theFaces[f].thePoints[2]];
+
+			pointHit = pointHit || pointNearFace(model, f, points[q], threshold);
+			sphereHit = sphereHit || IntersectionTests::sphereTriangleIntersect(&points[q].x, radius, &a.x, &b.x, &c.x);
+
+			float t, u, v;
+			if (IntersectionTests::rayTriangleIntersect(&origins[q].x, &directions[q].x, &a.x, &b.x, &c.x, t, u, v) && t >= 0.0f && t < nearest)
+				nearest = t;
+		}
+		pointBrute += pointHit;
+		sphereBrute += sphereHit;
+		rayBrute += nearest < 2.0f * size;
+
+		float distance;
+		bool rayHit = octree.rayCast(origins[q], directions[q], 2.0f * size, distance) >= 0;
+		if (pointHit != octree.pointCollision(points[q], threshold) || sphereHit != octree.sphereCollision(points[q], radius)
+			|| rayHit != (nearest < 2.0f * size) || (rayHit && abs(distance - nearest) > 0.001f * size))
+			mismatches++;
+	}
+	double bruteTime = bruteTimer.value();
+
+	LinearOctree::Statistics statistics = octree.getStatistics();
+	cout << "  " << path << ": " << model.numberOfTriangles << " triangles, build " << buildTime << " ms, " << statistics.leafCount << " leaves of "
+		<< statistics.averageLeafPrimitives << " triangles on average" << endl;
+	cout << "   octree: " << octreeTime * 1000.0 / queryCount << " us per point, sphere and ray, hits " << pointHits << " " << sphereHits << " " << rayHits << endl;
+	cout << "   every face: " << bruteTime * 1000.0 / queryCount << " us per point, sphere and ray, hits " << pointBrute << " " << sphereBrute << " " << rayBrute << endl;
+	cout << "   queries answered differently: " << mismatches << " of " << queryCount << endl;
+}
+
+void Benchmarks::octreeQueries(int queryCount)
+{
+	cout << " Octree query benchmark: " << queryCount << " points, spheres and rays per model" << endl;
+
+	modelQueries("Models/ss6.obj", queryCount);
+	modelQueries("Models/ball.obj", queryCount);
+	modelQueries("Models/ball2.obj", queryCount);
+}
+
+static void bakeModel(const char* path, int queryCount)
+{
+	ThreeDModel built, baked;
+	if (!Benchmarks::loadModel(path, built) || !Benchmarks::loadModel(path, baked))
+	{
+		cout << "  " << path << " could not be loaded" << endl;
+		return;
+	}
+
+	std::string bakePath = std::string(path) + ".benchmark.octree";
+
+	Stopwatch buildTimer;
+	built.calcVertNormalsUsingOctree();
+	double buildTime = buildTimer.value();
+
+	Stopwatch saveTimer;
+	bool saved = built.bakeOctree(bakePath.c_str());
+	double saveTime = saveTimer.value();
+
+	Stopwatch loadTimer;
+	bool loaded = saved && baked.loadBakedOctree(bakePath.c_str());
+	double loadTime = loadTimer.value();
+
+	if (!loaded)
+	{
+		cout << "  " << path << ": the octree could not be " << (saved ? "loaded" : "saved") << endl;
+		remove(bakePath.c_str());
+		return;
+	}
+
+	int normalMismatches = 0;
+	for (int v = 0; v < built.numberOfVertices; v++)
+	{
+		Vector3d& a = built.theVertNormals[v];
+		Vector3d& b = baked.theVertNormals[v];
+		normalMismatches += a.x != b.x || a.y != b.y || a.z != b.z;
+	}
+
+	double minX, minY, minZ, maxX, maxY, maxZ;
+	built.calcBoundingBox(minX, minY, minZ, maxX, maxY, maxZ);
+	glm::vec3 boxMin(minX, minY, minZ), boxMax(maxX, maxY, maxZ);
+	float size = glm::length(boxMax - boxMin);
+
+	// the baked octree answers from the mapping once the model has let go of its mesh
+	baked.deleteVertexFaceData();
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	int mismatches = 0;
+	for (int q = 0; q < queryCount; q++)
+	{
+		glm::vec3 point = boxMin + (boxMax - boxMin) * glm::vec3(unit(rng), unit(rng), unit(rng));
+		glm::vec3 direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) - glm::vec3(0.5f));
+
+		float builtDistance, bakedDistance;
+		if (built.octree->pointCollision(point, 0.01f * size) != baked.octree->pointCollision(point, 0.01f * size)
+			|| built.octree->sphereCollision(point, 0.02f * size) != baked.octree->sphereCollision(point, 0.02f * size)
+			|| built.octree->rayCast(point, direction, size, builtDistance) != baked.octree->rayCast(point, direction, size, bakedDistance))
+			mismatches++;
+	}
+
+	cout << "  " << path << ": " << built.numberOfTriangles << " triangles, " << baked.octree->getMemoryUsed() / 1024 << " KB file" << endl;
+	cout << "   build and vertex normals: " << buildTime << " ms, save " << saveTime << " ms, load " << loadTime << " ms" << endl;
+	cout << "   vertex normals different: " << normalMismatches << ", queries answered differently after deleting the mesh: "
+		<< mismatches << " of " << queryCount << endl;
+
+	remove(bakePath.c_str());
+}
+
+void Benchmarks::octreeBake(int queryCount)
+{
+	cout << " Baked octree benchmark: building the octree and the vertex normals against mapping them from a file" << endl;
+
+	bakeModel("Models/ss6.obj", queryCount);
+	bakeModel("Models/ball.obj", queryCount);
+	bakeModel("Models/ball2.obj", queryCount);
+}
@@ -0,0 +1,204 @@
+#include "Benchmarks.h"
+#include "../tube.h"
+#include "../Time/Stopwatch.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// the player update as it was before the frame table: three orientations from acos and cross products every frame
+static void referencePlayerPosition(const Tube& tube, int& first, float base, glm::vec3& point, glm::vec3& camTarget, glm::mat4& directionMat, float speed)
+{
+	const std::vector<glm::vec3>& verts = tube.flake.verts;
+	int n = verts.size();
+
+	glm::vec3 Z = verts[(first + n - 1) % n];
+	glm::vec3 A = verts[first];
+	glm::vec3 B = verts[(first + 1) % n];
+	glm::vec3 C = verts[(first + 2) % n];
+
+	glm::vec3 AB = B - A;
+	glm::vec3 AP = point - A;
+	glm::vec3 PB = B - point;
+
+	glm::vec3 nowDirection = glm::normalize(AB);
+	glm::vec3 nextDirection = glm::normalize(C - B);
+	glm::vec3 previousDirection = glm::normalize(A - Z);
+	glm::vec3 forward(0.0, 0.0, -1.0);
+
+	camTarget = A + glm::dot(AP, AB) / glm::dot(AB, AB) * AB;
+
+	if (glm::length(AP) > glm::length(AB))
+	{
+		first = (first + 1) % n;
+	}
+	else
+	{
+		glm::quat q_now = glm::angleAxis(-glm::degrees(glm::acos(glm::dot(nowDirection, forward))), glm::normalize(glm::cross(nowDirection, forward)));
+		glm::quat q_previous = glm::angleAxis(-glm::degrees(glm::acos(glm::dot(previousDirection, forward))), glm::normalize(glm::cross(previousDirection, forward)));
+		glm::quat q_next = glm::angleAxis(-glm::degrees(glm::acos(glm::dot(nextDirection, forward))), glm::normalize(glm::cross(nextDirection, forward)));
+
+		float alpha1 = glm::length(AP) / base + 0.5f;
+		float alpha2 = glm::length(PB) / base + 0.5f;
+
+		if (alpha1 < 1.0f)
+			directionMat = glm::toMat4(glm::slerp(q_previous, q_now, alpha1));
+		else if (alpha2 < 1.0f)
+			directionMat = glm::toMat4(glm::slerp(q_next, q_now, alpha2));
+		else
+			directionMat = glm::toMat4(q_now);
+	}
+
+	point += speed * nowDirection;
+}
+
+// distance of a point from the closest segment of the path
+static float distanceFromPath(const Tube& tube, const glm::vec3& point)
+{
+	const std::vector<glm::vec3>& verts = tube.flake.verts;
+	int n = verts.size();
+	float closest = 1e30f;
+
+	for (int i = 0; i < n; i++)
+	{
+		glm::vec3 AB = verts[(i + 1) % n] - verts[i];
+		float t = glm::clamp(glm::dot(point - verts[i], AB) / glm::dot(AB, AB), 0.0f, 1.0f);
+
+		closest = std::min(closest, glm::length(point - (verts[i] + AB * t)));
+	}
+
+	return closest;
+}
+
+void Benchmarks::playerPath(Tube& tube, int frames)
+{
+	float radius = tube.getRadius();
+	float base = radius * glm::sqrt(2 * (1 - glm::cos(glm::radians(30.0f))));
+
+	float longestSegment = 0.0f;
+	for (int i = 0; i < tube.path.getSegmentCount(); i++)
+		longestSegment = std::max(longestSegment, tube.path.segmentLength(i));
+
+	cout << " Player path benchmark: " << frames << " frames, " << tube.path.getSegmentCount() << " segments" << endl;
+
+	ArcLengthPath rebuilt;
+	Stopwatch buildTimer;
+	rebuilt.build(tube.flake.verts);
+	double buildTime = buildTimer.value();
+
+	// flies both versions at the game speed and at a speed of two of the longest segments per frame
+	float speeds[2] = { 10.0f, 2.0f * longestSegment };
+
+	for (int k = 0; k < 2; k++)
+	{
+		int run = k == 0 ? frames : 1000;
+
+		//---per frame quaternions, moving one segment at most per frame---
+		int first = 0;
+		glm::vec3 referencePoint = tube.flake.verts[0];
+		glm::vec3 camTarget;
+		glm::mat4 directionMat(1.0f);
+
+		Stopwatch referenceTimer;
+		for (int f = 0; f < run; f++)
+		{
+			referencePlayerPosition(tube, first, base, referencePoint, camTarget, directionMat, speeds[k]);
+		}
+		double referenceTime = referenceTimer.value();
+
+		//---frame table on the arc length path---
+		glm::vec3 point;
+		glm::mat4 turnMat(1.0f);
+
+		Stopwatch tableTimer;
+		for (int f = 0; f < run; f++)
+		{
+			tube.playerPosition(point, camTarget, directionMat, turnMat, speeds[k], 0.0f);
+		}
+		double tableTime = tableTimer.value();
+
+		cout << "  speed " << speeds[k] << ", " << run << " frames" << endl;
+		cout << "   per frame quaternions : " << referenceTime * 1000000.0 / run << " ns per frame, ends " << distanceFromPath(tube, referencePoint) << " away from the path" << endl;
+		cout << "   frame table and arc length : " << tableTime * 1000000.0 / run << " ns per frame, ends " << distanceFromPath(tube, point) << " away from the path" << endl;
+	}
+
+	cout << "  path table build : " << buildTime << " ms" << endl;
+}
+
+void Benchmarks::pathLookup(Tube& tube, int entityCount, int frames)
+{
+	const ArcLengthPath& path = tube.path;
+	const float speed = 10.0f;
+
+	cout << " Path lookup benchmark: " << entityCount << " entities, " << frames << " frames, " << path.getSegmentCount() << " segments" << endl;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> along(0.0f, path.getLength());
+
+	std::vector<float> s(entityCount);
+	for (int i = 0; i < entityCount; i++)
+		s[i] = along(rng);
+
+	//---binary search for every entity every frame---
+	std::vector<float> searched = s;
+	std::vector<glm::vec3> positions(entityCount);
+	int mismatches = 0;
+
+	Stopwatch searchTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < entityCount; i++)
+		{
+			searched[i] = path.wrap(searched[i] + speed);
+			positions[i] = path.position(searched[i]);
+		}
+	}
+	double searchTime = searchTimer.value();
+
+	//---every entity keeps the segment of its last lookup---
+	std::vector<float> hinted = s;
+	std::vector<int> hints(entityCount, -1);
+	glm::vec3 position, tangent;
+
+	Stopwatch hintTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < entityCount; i++)
+		{
+			hinted[i] = path.wrap(hinted[i] + speed);
+			path.evaluate(hinted[i], hints[i], position, tangent);
+		}
+	}
+	double hintTime = hintTimer.value();
+
+	for (int i = 0; i < entityCount; i++)
+	{
+		if (hints[i] != path.segmentAt(hinted[i]))
+			mismatches++;
+	}
+
+	//---sorted distances evaluated in bulk---
+	std::vector<float> sorted = s;
+	std::sort(sorted.begin(), sorted.end());
+	std::vector<glm::vec3> tangents;
+
+	Stopwatch bulkTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		path.evaluate(sorted, positions, tangents);
+	}
+	double bulkTime = bulkTimer.value();
+
+	for (int i = 0; i < entityCount; i++)
+	{
+		if (glm::length(positions[i] - path.position(sorted[i])) > 1e-3f)
+			mismatches++;
+	}
+
+	cout << "  binary search : " << searchTime * 1000000.0 / (frames * entityCount) << " ns per entity" << endl;
+	cout << "  hint : " << hintTime * 1000000.0 / (frames * entityCount) << " ns per entity" << endl;
+	cout << "  sorted bulk : " << bulkTime * 1000000.0 / (frames * entityCount) << " ns per entity" << endl;
+	cout << "  lookups different from the binary search : " << mismatches << endl;
+}
@@ -0,0 +1,119 @@
+#include "Benchmarks.h"
+#include "../tube.h"
+#include "../Projectiles/ProjectileSystem.h"
+#include "../Time/Stopwatch.h"
+
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+void Benchmarks::randomShot(Tube& tube, std::mt19937& rng, glm::vec3& origin, glm::vec3& direction)
+{
+	std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+
+	int n = tube.flake.verts.size();
+	int i = rng() % n;
+
+	origin = tube.flake.verts[i];
+	direction = tube.flake.verts[(i + 1) % n] - origin;
+	direction = glm::normalize(glm::normalize(direction) + glm::vec3(jitter(rng), jitter(rng), jitter(rng)));
+}
+
+void Benchmarks::projectilePool(Tube& tube, int projectileCount, int frames)
+{
+	const float speed = 9.0f;	// distance per frame of a missile in the game
+
+	cout << " Projectile benchmark: " << projectileCount << " projectiles, " << frames << " frames" << endl;
+
+	//---pool with the ray casts batched in the update---
+	std::mt19937 rng(1);
+	ProjectileSystem system(projectileCount);
+	system.setTube(&tube);
+
+	Stopwatch fireTimer;
+	for (int i = 0; i < projectileCount; i++)
+	{
+		glm::vec3 origin, direction;
+		randomShot(tube, rng, origin, direction);
+		system.fire(origin, direction, speed);
+	}
+	double fireTime = fireTimer.value();
+
+	Stopwatch castTimer;
+	system.update(0.0f);
+	double castTime = castTimer.value();
+
+	double updateTime = 0.0;
+	double refireTime = 0.0;
+	int impacts = 0;
+
+	for (int f = 0; f < frames; f++)
+	{
+		Stopwatch updateTimer;
+		system.update(1.0f);
+		updateTime += updateTimer.value();
+
+		// keep the number of live projectiles constant
+		Stopwatch refireTimer;
+		int impactedNow = system.getImpacted().size();
+		for (int i = 0; i < impactedNow; i++)
+		{
+			glm::vec3 origin, direction;
+			randomShot(tube, rng, origin, direction);
+			system.fire(origin, direction, speed);
+		}
+		refireTime += refireTimer.value();
+		impacts += impactedNow;
+	}
+
+	// moving without refiring, so only the integration is timed
+	Stopwatch integrateTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		system.update(0.0f);
+	}
+	double integrateTime = integrateTimer.value();
+
+	std::vector<glm::vec3> drawPositions;
+	Stopwatch gatherTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		system.gatherPositions(drawPositions, -0.5f);
+	}
+	double gatherTime = gatherTimer.value();
+
+	//---per frame point testing---
+	rng.seed(1);
+	std::vector<glm::vec3> points(projectileCount);
+	std::vector<glm::vec3> directions(projectileCount);
+	for (int i = 0; i < projectileCount; i++)
+	{
+		randomShot(tube, rng, points[i], directions[i]);
+	}
+
+	int pointImpacts = 0;
+	Stopwatch pointTimer;
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < projectileCount; i++)
+		{
+			points[i] += directions[i] * speed;
+
+			if (!tube.collisionBetweenPoint(points[i], speed, 0, 3))
+			{
+				pointImpacts++;
+				randomShot(tube, rng, points[i], directions[i]);
+			}
+		}
+	}
+	double pointTime = pointTimer.value();
+
+	cout << "  fire (slot from the free list): " << fireTime / projectileCount * 1000.0 << " us per projectile" << endl;
+	cout << "  batched ray casts: " << castTime / projectileCount * 1000.0 << " us per projectile" << endl;
+	cout << "  update with the casts of the refired: " << updateTime / frames << " ms per frame, " << impacts << " impacts" << endl;
+	cout << "  refire of impacted projectiles: " << refireTime / frames << " ms per frame" << endl;
+	cout << "  integration of " << system.getActiveCount() << " projectiles: " << integrateTime / frames << " ms per frame" << endl;
+	cout << "  gather of the draw positions: " << gatherTime / frames << " ms per frame" << endl;
+	cout << "  point testing: " << pointTime / frames << " ms per frame, " << pointImpacts << " impacts" << endl;
+}
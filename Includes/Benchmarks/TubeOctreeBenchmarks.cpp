@@ -0,0 +1,193 @@
+#include "Benchmarks.h"
+#include "../tube.h"
+#include "../Octree/OctreeSources.h"
+#include "../Octree/SpatialOctree.h"
+#include "../Time/Stopwatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// the test of Tube::collisionBetweenPoint on triangle i
+static bool pointNearTubeTriangle(Tube& tube, int i, const glm::vec3& point, float threshold)
+{
+	float dist = glm::dot(point - tube.verts[(int)tube.triangles[i].x], tube.norms[i]);
+
+	return abs(dist) < threshold && tube.BarycentricCalculation(point, dist, i);
+}
+
+void Benchmarks::tubeOctree(Tube& tube, int queryCount)
+{
+	cout << " Tube octree benchmark: " << queryCount << " points and rays, " << tube.triangles.size() << " triangles" << endl;
+
+	TubeTriangleSource source(tube);
+	SpatialOctree<TubeTriangleSource> octree;
+
+	Stopwatch buildTimer;
+	octree.build(source);
+	double buildTime = buildTimer.value();
+
+	OctreeStatistics statistics = octree.getStatistics();
+	cout << "  build: " << buildTime << " ms, " << statistics.memory / 1024 << " KB, " << statistics.nodeCount << " nodes, " << statistics.leafCount
+		<< " leaves, depth " << statistics.depth << ", " << statistics.averageLeafPrimitives << " triangles per leaf on average and "
+		<< statistics.maxLeafPrimitives << " at most" << endl;
+
+	//---points round the path and shots along it, like the projectiles---
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> offset(-1.2f * tube.getRadius(), 1.2f * tube.getRadius());
+	std::vector<glm::vec3> points(queryCount), origins(queryCount), directions(queryCount);
+	for (int q = 0; q < queryCount; q++)
+	{
+		points[q] = tube.flake.verts[rng() % tube.flake.verts.size()] + glm::vec3(offset(rng), offset(rng), offset(rng));
+		randomShot(tube, rng, origins[q], directions[q]);
+	}
+
+	float threshold = tube.getRadius() * 0.1f;
+	float rayLength = 100000.0f;
+
+	std::vector<bool> octreePoint(queryCount), octreeRay(queryCount);
+	std::vector<float> octreeDistance(queryCount);
+	int pointHits = 0, rayHits = 0;
+
+	Stopwatch pointTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		octreePoint[q] = octree.visitLeavesNear(points[q], threshold, [&](int leaf)
+		{
+			const int* triangles = octree.getPrimitives(leaf);
+			for (int k = 0; k < octree.getNode(leaf).primitiveCount; k++)
+			{
+				if (pointNearTubeTriangle(tube, triangles[k], points[q], threshold))
+					return true;
+			}
+			return false;
+		});
+		pointHits += octreePoint[q];
+	}
+	double pointTime = pointTimer.value();
+
+	Stopwatch rayTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		float distance = rayLength;
+		int nearest = -1;
+		octree.visitLeavesAlongRay(origins[q], directions[q], distance, [&](int leaf, float& distance)
+		{
+			const int* triangles = octree.getPrimitives(leaf);
+			for (int k = 0; k < octree.getNode(leaf).primitiveCount; k++)
+			{
+				float t;
+				if (tube.RayTriangleCalculation(origins[q], directions[q], triangles[k], t) && t >= 0.0f && t < distance)
+				{
+					distance = t;
+					nearest = triangles[k];
+				}
+			}
+		});
+		octreeRay[q] = nearest >= 0;
+		octreeDistance[q] = distance;
+		rayHits += octreeRay[q];
+	}
+	double rayTime = rayTimer.value();
+
+	//---the multi resolution point test and the hierarchy ray cast of the tube---
+	std::vector<bool> tubePoint(queryCount), tubeRay(queryCount);
+	std::vector<float> tubeDistance(queryCount);
+	int tubePointHits = 0, tubeRayHits = 0;
+
+	Stopwatch tubePointTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		tubePoint[q] = tube.pointCollision(points[q], threshold);
+		tubePointHits += tubePoint[q];
+	}
+	double tubePointTime = tubePointTimer.value();
+
+	Stopwatch tubeRayTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		float distance;
+		tubeRay[q] = tube.rayCast(origins[q], directions[q], distance);
+		tubeDistance[q] = distance;
+		tubeRayHits += tubeRay[q];
+	}
+	double tubeRayTime = tubeRayTimer.value();
+
+	//---every triangle, on a part of the points since it is slow---
+	int bruteCount = queryCount / 10;
+	int brutePointHits = 0;
+	int mismatches = 0;
+	Stopwatch bruteTimer;
+	for (int q = 0; q < bruteCount; q++)
+	{
+		bool hit = false;
+		for (int i = 0; i < tube.triangles.size() && !hit; i++)
+			hit = pointNearTubeTriangle(tube, i, points[q], threshold);
+
+		brutePointHits += hit;
+		mismatches += hit != octreePoint[q];
+	}
+	double bruteTime = bruteTimer.value();
+
+	for (int q = 0; q < queryCount; q++)
+	{
+		if (octreePoint[q] != tubePoint[q] || octreeRay[q] != tubeRay[q]
+			|| (octreeRay[q] && abs(octreeDistance[q] - tubeDistance[q]) > 0.001f * tube.getRadius()))
+			mismatches++;
+	}
+
+	cout << "  octree: " << pointTime * 1000.0 / queryCount << " us per point, " << rayTime * 1000.0 / queryCount << " us per ray, hits "
+		<< pointHits << " " << rayHits << endl;
+	cout << "  tube: " << tubePointTime * 1000.0 / queryCount << " us per point, " << tubeRayTime * 1000.0 / queryCount << " us per ray, hits "
+		<< tubePointHits << " " << tubeRayHits << endl;
+	cout << "  every triangle: " << bruteTime * 1000.0 / bruteCount << " us per point, " << brutePointHits << " hits of " << bruteCount << endl;
+	cout << "  queries answered differently: " << mismatches << endl;
+
+	//---the same tree over the path points, counting the ones near each query point---
+	PointCloudSource cloud(tube.flake.verts);
+	SpatialOctree<PointCloudSource> pointOctree;
+
+	Stopwatch cloudBuildTimer;
+	pointOctree.build(cloud, OctreeBuildParameters());
+	double cloudBuildTime = cloudBuildTimer.value();
+
+	float reach = 2.0f * tube.getRadius();
+	int found = 0, expected = 0;
+	std::vector<int> near;
+	Stopwatch cloudTimer;
+	for (int q = 0; q < queryCount; q++)
+	{
+		near.clear();
+		pointOctree.visitLeavesNear(points[q], reach, [&](int leaf)
+		{
+			const int* indices = pointOctree.getPrimitives(leaf);
+			for (int k = 0; k < pointOctree.getNode(leaf).primitiveCount; k++)
+			{
+				glm::vec3 d = tube.flake.verts[indices[k]] - points[q];
+				if (glm::dot(d, d) <= reach * reach)
+					near.push_back(indices[k]);
+			}
+			return false;
+		});
+
+		// a point on the border of two cells is in both leaves
+		std::sort(near.begin(), near.end());
+		found += std::unique(near.begin(), near.end()) - near.begin();
+	}
+	double cloudTime = cloudTimer.value();
+
+	for (int q = 0; q < queryCount; q++)
+	{
+		for (int i = 0; i < tube.flake.verts.size(); i++)
+		{
+			glm::vec3 d = tube.flake.verts[i] - points[q];
+			expected += glm::dot(d, d) <= reach * reach;
+		}
+	}
+
+	cout << "  path points: " << tube.flake.verts.size() << ", build " << cloudBuildTime << " ms, " << cloudTime * 1000.0 / queryCount
+		<< " us per query, " << found << " found of " << expected << endl;
+}
@@ -0,0 +1,441 @@
+#include "BVH.h"
+#include "../tube.h"
+#include "../Utilities/IntersectionTests.h"
+
+#include <algorithm>
+
+static float boxArea(const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	glm::vec3 e = boxMax - boxMin;
+	return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+const float BVH::TRAVERSAL_COST = 1.0f;
+
+BVH::BVH()
+{
+	depth = 0;
+}
+
+void BVH::buildFromTube(const Tube& tube)
+{
+	std::vector<BVHTriangle> source(tube.triangles.size());
+
+	for (int i = 0; i < tube.triangles.size(); i++)
+	{
+		source[i].v0 = tube.verts[tube.triangles[i].x];
+		source[i].v1 = tube.verts[tube.triangles[i].y];
+		source[i].v2 = tube.verts[tube.triangles[i].z];
+	}
+
+	buildFromTriangles(source);
+}
+
+void BVH::buildFromTriangles(const std::vector<BVHTriangle>& sourceTriangles)
+{
+	int count = sourceTriangles.size();
+
+	nodes.clear();
+	triangles.clear();
+	triangleIds.resize(count);
+	centroids.resize(count);
+	primitiveMin.resize(count);
+	primitiveMax.resize(count);
+	depth = 0;
+
+	if (count == 0)
+		return;
+
+	for (int i = 0; i < count; i++)
+	{
+		const BVHTriangle& t = sourceTriangles[i];
+		triangleIds[i] = i;
+		primitiveMin[i] = glm::min(glm::min(t.v0, t.v1), t.v2);
+		primitiveMax[i] = glm::max(glm::max(t.v0, t.v1), t.v2);
+		centroids[i] = (t.v0 + t.v1 + t.v2) * (1.0f / 3.0f);
+	}
+
+	// a binary tree with leaves of at least one triangle has fewer than 2n nodes
+	nodes.reserve(2 * count);
+	nodes.push_back(BVHNode());
+	subdivide(0, 0, count, 1);
+
+	// copy the triangles into leaf order, so a leaf reads one contiguous block
+	triangles.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		triangles[i] = sourceTriangles[triangleIds[i]];
+	}
+
+	centroids.clear();
+	primitiveMin.clear();
+	primitiveMax.clear();
+}
+
+void BVH::subdivide(unsigned int nodeIndex, unsigned int first, unsigned int count, int level)
+{
+	if (level > depth)
+		depth = level;
+
+	glm::vec3 boundsMin = primitiveMin[triangleIds[first]];
+	glm::vec3 boundsMax = primitiveMax[triangleIds[first]];
+	glm::vec3 centroidMin = centroids[triangleIds[first]];
+	glm::vec3 centroidMax = centroidMin;
+
+	for (unsigned int i = first + 1; i < first + count; i++)
+	{
+		unsigned int id = triangleIds[i];
+		boundsMin = glm::min(boundsMin, primitiveMin[id]);
+		boundsMax = glm::max(boundsMax, primitiveMax[id]);
+		centroidMin = glm::min(centroidMin, centroids[id]);
+		centroidMax = glm::max(centroidMax, centroids[id]);
+	}
+
+	nodes[nodeIndex].boundsMin = boundsMin;
+	nodes[nodeIndex].boundsMax = boundsMax;
+	nodes[nodeIndex].leftFirst = first;
+	nodes[nodeIndex].count = count;
+
+	// the traversal stacks hold one entry per level
+	if (count <= 2 || level >= MAX_TREE_DEPTH)
+		return;
+
+	//---find the cheapest split between bins on all three axes---
+	float bestCost = 1e30f;
+	int bestAxis = -1;
+	int bestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+			continue;
+
+		float scale = BINS / extent;
+
+		int binCount[BINS];
+		glm::vec3 binMin[BINS], binMax[BINS];
+		for (int b = 0; b < BINS; b++)
+		{
+			binCount[b] = 0;
+			binMin[b] = glm::vec3(1e30f);
+			binMax[b] = glm::vec3(-1e30f);
+		}
+
+		for (unsigned int i = first; i < first + count; i++)
+		{
+			unsigned int id = triangleIds[i];
+			int b = std::min(BINS - 1, (int)((centroids[id][axis] - centroidMin[axis]) * scale));
+			binCount[b]++;
+			binMin[b] = glm::min(binMin[b], primitiveMin[id]);
+			binMax[b] = glm::max(binMax[b], primitiveMax[id]);
+		}
+
+		// areas and counts left of every split plane, swept from both sides
+		float leftArea[BINS - 1], rightArea[BINS - 1];
+		int leftCount[BINS - 1], rightCount[BINS - 1];
+		glm::vec3 leftMin(1e30f), leftMax(-1e30f), rightMin(1e30f), rightMax(-1e30f);
+		int leftSum = 0, rightSum = 0;
+
+		for (int b = 0; b < BINS - 1; b++)
+		{
+			leftSum += binCount[b];
+			leftCount[b] = leftSum;
+			leftMin = glm::min(leftMin, binMin[b]);
+			leftMax = glm::max(leftMax, binMax[b]);
+			leftArea[b] = leftSum > 0 ? boxArea(leftMin, leftMax) : 0.0f;
+
+			rightSum += binCount[BINS - 1 - b];
+			rightCount[BINS - 2 - b] = rightSum;
+			rightMin = glm::min(rightMin, binMin[BINS - 1 - b]);
+			rightMax = glm::max(rightMax, binMax[BINS - 1 - b]);
+			rightArea[BINS - 2 - b] = rightSum > 0 ? boxArea(rightMin, rightMax) : 0.0f;
+		}
+
+		for (int b = 0; b < BINS - 1; b++)
+		{
+			if (leftCount[b] == 0 || rightCount[b] == 0)
+				continue;
+
+			float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	// all centroids in one point, the triangles can not be separated
+	if (bestAxis < 0)
+		return;
+
+	// keep the leaf when testing all its triangles is cheaper than visiting two more boxes
+	float area = boxArea(boundsMin, boundsMax);
+	if (bestCost + TRAVERSAL_COST * area >= count * area && count <= MAX_LEAF_SIZE)
+		return;
+
+	//---partition the triangle ids around the split plane---
+	float scale = BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	int i = first;
+	int j = first + count - 1;
+
+	while (i <= j)
+	{
+		int b = std::min(BINS - 1, (int)((centroids[triangleIds[i]][bestAxis] - centroidMin[bestAxis]) * scale));
+
+		if (b <= bestSplit)
+		{
+			i++;
+		}
+		else
+		{
+			std::swap(triangleIds[i], triangleIds[j]);
+			j--;
+		}
+	}
+
+	unsigned int leftCount = i - first;
+
+	// the first child follows its parent, the second child comes after the whole first subtree
+	unsigned int leftChild = nodes.size();
+	nodes.push_back(BVHNode());
+	subdivide(leftChild, first, leftCount, level + 1);
+
+	unsigned int rightChild = nodes.size();
+	nodes.push_back(BVHNode());
+	subdivide(rightChild, i, count - leftCount, level + 1);
+
+	nodes[nodeIndex].leftFirst = rightChild;
+	nodes[nodeIndex].count = 0;
+}
+
+// entry distance of the ray into the node box, or 1e30 when the box is missed before tMax
+float BVH::rayBox(const BVHNode& node, const glm::vec3& origin, const glm::vec3& invDirection, float tMax)
+{
+	float tx1 = (node.boundsMin.x - origin.x) * invDirection.x, tx2 = (node.boundsMax.x - origin.x) * invDirection.x;
+	float tNear = std::min(tx1, tx2), tFar = std::max(tx1, tx2);
+	float ty1 = (node.boundsMin.y - origin.y) * invDirection.y, ty2 = (node.boundsMax.y - origin.y) * invDirection.y;
+	tNear = std::max(tNear, std::min(ty1, ty2)), tFar = std::min(tFar, std::max(ty1, ty2));
+	float tz1 = (node.boundsMin.z - origin.z) * invDirection.z, tz2 = (node.boundsMax.z - origin.z) * invDirection.z;
+	tNear = std::max(tNear, std::min(tz1, tz2)), tFar = std::min(tFar, std::max(tz1, tz2));
+
+	if (tFar >= tNear && tNear <= tMax && tFar >= 0.0f)
+		return tNear;
+
+	return 1e30f;
+}
+
+bool BVH::intersect(const glm::vec3& origin, const glm::vec3& direction, float tMax, BVHHit& hit) const
+{
+	hit.t = tMax;
+
+	if (nodes.empty())
+		return false;
+
+	glm::vec3 invDirection;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		invDirection[axis] = direction[axis] != 0.0f ? 1.0f / direction[axis] : 1e30f;
+	}
+
+	bool found = false;
+
+	unsigned int stack[64];
+	int top = 0;
+	unsigned int current = 0;
+
+	if (rayBox(nodes[0], origin, invDirection, tMax) == 1e30f)
+		return false;
+
+	while (true)
+	{
+		const BVHNode& node = nodes[current];
+
+		if (node.count > 0)
+		{
+			for (unsigned int i = node.leftFirst; i < node.leftFirst + node.count; i++)
+			{
+				float t, u, v;
+
+				if (IntersectionTests::rayTriangleIntersect(&origin[0], &direction[0], &triangles[i].v0[0], &triangles[i].v1[0], &triangles[i].v2[0], t, u, v))
+				{
+					if (t >= 0.0f && t <= hit.t)
+					{
+						hit.t = t;
+						hit.u = u;
+						hit.v = v;
+						hit.triangle = triangleIds[i];
+						found = true;
+					}
+				}
+			}
+
+			if (top == 0)
+				break;
+			current = stack[--top];
+			continue;
+		}
+
+		// visit the nearer child first, the farther one waits on the stack
+		unsigned int nearChild = current + 1;
+		unsigned int farChild = node.leftFirst;
+		float nearDistance = rayBox(nodes[nearChild], origin, invDirection, hit.t);
+		float farDistance = rayBox(nodes[farChild], origin, invDirection, hit.t);
+
+		if (nearDistance > farDistance)
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearDistance, farDistance);
+		}
+
+		if (nearDistance == 1e30f)
+		{
+			if (top == 0)
+				break;
+			current = stack[--top];
+		}
+		else
+		{
+			current = nearChild;
+			if (farDistance != 1e30f)
+				stack[top++] = farChild;
+		}
+	}
+
+	return found;
+}
+
+bool BVH::rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const
+{
+	BVHHit hit;
+
+	if (intersect(origin, direction, maxDistance, hit))
+	{
+		distance = hit.t;
+		return true;
+	}
+
+	distance = maxDistance;
+	return false;
+}
+
+bool BVH::segmentCollision(const glm::vec3& start, const glm::vec3& end, float& timeOfImpact) const
+{
+	BVHHit hit;
+	bool found = intersect(start, end - start, 1.0f, hit);
+
+	timeOfImpact = hit.t;
+	return found;
+}
+
+bool BVH::sphereCollision(const glm::vec3& center, float radius) const
+{
+	if (nodes.empty())
+		return false;
+
+	unsigned int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		unsigned int index = stack[--top];
+		const BVHNode& node = nodes[index];
+
+		// squared distance from the center to the box
+		glm::vec3 d = glm::max(node.boundsMin - center, glm::vec3(0.0f)) + glm::max(center - node.boundsMax, glm::vec3(0.0f));
+		if (glm::dot(d, d) > radius * radius)
+			continue;
+
+		if (node.count > 0)
+		{
+			for (unsigned int i = node.leftFirst; i < node.leftFirst + node.count; i++)
+			{
+				if (IntersectionTests::sphereTriangleIntersect(&center[0], radius, &triangles[i].v0[0], &triangles[i].v1[0], &triangles[i].v2[0]))
+					return true;
+			}
+		}
+		else
+		{
+			stack[top++] = node.leftFirst;
+			stack[top++] = index + 1;
+		}
+	}
+
+	return false;
+}
+
+bool BVH::pointCollision(const glm::vec3& point, float threshold) const
+{
+	if (nodes.empty())
+		return false;
+
+	unsigned int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		unsigned int index = stack[--top];
+		const BVHNode& node = nodes[index];
+
+		glm::vec3 d = glm::max(node.boundsMin - point, glm::vec3(0.0f)) + glm::max(point - node.boundsMax, glm::vec3(0.0f));
+		if (glm::dot(d, d) > threshold * threshold)
+			continue;
+
+		if (node.count > 0)
+		{
+			for (unsigned int i = node.leftFirst; i < node.leftFirst + node.count; i++)
+			{
+				const BVHTriangle& t = triangles[i];
+				glm::vec3 e1 = t.v1 - t.v0;
+				glm::vec3 e2 = t.v2 - t.v0;
+				glm::vec3 normal = glm::cross(e1, e2);
+
+				float lengthSquared = glm::dot(normal, normal);
+				if (lengthSquared == 0.0f)
+					continue;
+
+				normal = normal / glm::sqrt(lengthSquared);
+				float dist = glm::dot(point - t.v0, normal);
+				if (abs(dist) >= threshold)
+					continue;
+
+				// barycentric coordinates of the point projected on the plane
+				glm::vec3 p = point - normal * dist - t.v0;
+				float dot11 = glm::dot(e2, e2), dot12 = glm::dot(e2, e1), dot1p = glm::dot(e2, p);
+				float dot22 = glm::dot(e1, e1), dot2p = glm::dot(e1, p);
+				float invDenom = 1.0f / (dot11 * dot22 - dot12 * dot12);
+				float u = (dot22 * dot1p - dot12 * dot2p) * invDenom;
+				float v = (dot11 * dot2p - dot12 * dot1p) * invDenom;
+
+				if (u >= 0.0f && v >= 0.0f && u + v < 1.0f)
+					return true;
+			}
+		}
+		else
+		{
+			stack[top++] = node.leftFirst;
+			stack[top++] = index + 1;
+		}
+	}
+
+	return false;
+}
+
+int BVH::getNodeCount() const
+{
+	return nodes.size();
+}
+
+int BVH::getTriangleCount() const
+{
+	return triangles.size();
+}
+
+int BVH::getDepth() const
+{
+	return depth;
+}
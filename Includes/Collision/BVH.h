@@ -0,0 +1,84 @@
+/*---Bounding volume hierarchy over a triangle soup, built with binned SAH. The nodes are 32 bytes and stored depth first in one
+array: the first child of an inner node follows it, the node keeps the index of the second child. Triangles are copied into
+leaf order, so the structure stays valid after a model deletes its vertex data.---*/
+
+#ifndef _BVH_H
+#define _BVH_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class Tube;
+
+struct BVHNode
+{
+	glm::vec3 boundsMin;
+	unsigned int leftFirst;		// inner node: index of the second child, leaf: first triangle
+	glm::vec3 boundsMax;
+	unsigned int count;			// number of triangles in a leaf, 0 for inner nodes
+};
+
+struct BVHTriangle
+{
+	glm::vec3 v0, v1, v2;
+};
+
+struct BVHHit
+{
+	float t;					// distance along the ray in units of the direction
+	float u, v;					// barycentric coordinates of the hit
+	unsigned int triangle;		// index of the triangle in the source (tube triangle or model face)
+};
+
+class BVH
+{
+private:
+
+	std::vector<BVHNode> nodes;
+	std::vector<BVHTriangle> triangles;		// in leaf order
+	std::vector<unsigned int> triangleIds;	// source index of every triangle in leaf order
+	int depth;
+
+	// working data of the build
+	std::vector<glm::vec3> centroids;
+	std::vector<glm::vec3> primitiveMin, primitiveMax;
+
+	void subdivide(unsigned int nodeIndex, unsigned int first, unsigned int count, int level);
+
+	static float rayBox(const BVHNode& node, const glm::vec3& origin, const glm::vec3& invDirection, float tMax);
+
+public:
+
+	static const int BINS = 16;
+	static const float TRAVERSAL_COST;		// cost of visiting a node relative to one triangle test
+	static const int MAX_LEAF_SIZE = 8;		// leaves larger than this are split even when SAH would keep them
+	static const int MAX_TREE_DEPTH = 60;		// below this level everything is a leaf, so the 64 entry traversal stacks never overflow
+
+	BVH();
+
+	// the hits report the index of a triangle in sourceTriangles
+	void buildFromTriangles(const std::vector<BVHTriangle>& sourceTriangles);
+	void buildFromTube(const Tube& tube);
+
+	// closest hit of origin + t * direction for t in [0, tMax]. The direction does not have to be normalised.
+	bool intersect(const glm::vec3& origin, const glm::vec3& direction, float tMax, BVHHit& hit) const;
+
+	// casts a ray (direction must be normalised) up to maxDistance, distance is measured from the origin
+	bool rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+	// true when the line from start to end crosses a triangle, timeOfImpact is the fraction (0..1) of the first crossing
+	bool segmentCollision(const glm::vec3& start, const glm::vec3& end, float& timeOfImpact) const;
+
+	// true when the sphere touches a triangle
+	bool sphereCollision(const glm::vec3& center, float radius) const;
+
+	// true when the point is closer than threshold to the plane of a triangle it projects into (the test of ThreeDModel::collisionBetweenPoint)
+	bool pointCollision(const glm::vec3& point, float threshold) const;
+
+	int getNodeCount() const;
+	int getTriangleCount() const;
+	int getDepth() const;
+};
+
+#endif
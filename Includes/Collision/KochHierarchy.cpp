@@ -0,0 +1,413 @@
+#include "KochHierarchy.h"
+#include "../tube.h"
+#include "../Utilities/IntersectionTests.h"
+#include "../Utilities/ParallelFor.h"
+#include "../Utilities/Simd.h"
+
+#include <algorithm>
+#include <cstring>
+
+KochHierarchy::KochHierarchy()
+{
+	tube = NULL;
+	depth = 0;
+	inflation = 0.0f;
+}
+
+void KochHierarchy::build(Tube& tubeToBound, float tubeRadius)
+{
+	tube = &tubeToBound;
+	nodes.clear();
+
+	int cornerCount = tube->flake.cornerVerts.size();
+	if (cornerCount < 3)
+		return;
+
+	// a fractal of dimension d has 3 * 4^d corners
+	depth = 0;
+	while ((3 << (2 * depth)) < cornerCount)
+		depth++;
+
+	// the rounded corners move the path up to one radius away from the unrounded curve, the rings add another one
+	inflation = 2.0f * tubeRadius;
+
+	nodes.resize((1 << (2 * (depth + 1))) - 1);
+
+	ParallelFor::run(0, nodes.size(), [this](int i) { buildNode(i); });
+
+#ifdef USE_SSE
+	buildBlocks();
+#endif
+}
+
+void KochHierarchy::buildBlocks()
+{
+	const std::vector<std::vector<unsigned int> >& segments = tube->trianglesInBoxe;
+
+	segmentBlocks.assign(segments.size() + 1, 0);
+	for (int s = 0; s < segments.size(); s++)
+		segmentBlocks[s + 1] = segmentBlocks[s] + (segments[s].size() + 3) / 4;
+
+	KochTriangleBlock empty;
+	memset(&empty, 0, sizeof(empty));
+	blocks.assign(segmentBlocks.back(), empty);
+
+	ParallelFor::run(0, segments.size(), [&](int s)
+	{
+		for (int i = 0; i < segments[s].size(); i++)
+		{
+			KochTriangleBlock& block = blocks[segmentBlocks[s] + i / 4];
+			int lane = i % 4;
+
+			const glm::vec3& triangle = tube->triangles[segments[s][i]];
+			const glm::vec3& v0 = tube->verts[(int)triangle.x];
+			const glm::vec3& v1 = tube->verts[(int)triangle.y];
+			const glm::vec3& v2 = tube->verts[(int)triangle.z];
+
+			for (int a = 0; a < 3; a++)
+			{
+				block.v0[a][lane] = v0[a];
+				block.edge1[a][lane] = v1[a] - v0[a];
+				block.edge2[a][lane] = v2[a] - v0[a];
+			}
+		}
+	}, 16);
+}
+
+void KochHierarchy::buildNode(int i)
+{
+	const std::vector<glm::vec3>& corners = tube->flake.cornerVerts;
+	const std::vector<unsigned int>& offsets = tube->flake.cornerOffsets;
+
+	int level = 0;
+	while ((1 << (2 * (level + 1))) - 1 <= i)
+		level++;
+
+	int indexInLevel = i - ((1 << (2 * level)) - 1);
+	int span = 1 << (2 * (depth - level));		// number of leaf edges below the node
+	int firstCorner = indexInLevel * span;
+	int lastCorner = firstCorner + span;
+
+	KochNode& node = nodes[i];
+	node.start = corners[firstCorner];
+	node.end = corners[lastCorner % corners.size()];
+
+	if (level < depth)
+	{
+		// the peak of a sub-curve is the corner between its second and third child
+		node.peak = corners[firstCorner + span / 2];
+		node.firstChild = ((1 << (2 * (level + 1))) - 1) + indexInLevel * 4;
+	}
+	else
+	{
+		node.peak = (node.start + node.end) * 0.5f;
+		node.firstChild = -1;
+	}
+
+	node.firstSegment = offsets[firstCorner];
+	node.lastSegment = offsets[lastCorner];
+
+	glm::vec3 grow(inflation, inflation, inflation);
+	node.boxMin = glm::min(glm::min(node.start, node.end), node.peak) - grow;
+	node.boxMax = glm::max(glm::max(node.start, node.end), node.peak) + grow;
+}
+
+bool KochHierarchy::nodeReached(const KochNode& node, const glm::vec3& point, float radius) const
+{
+	if (point.x < node.boxMin.x - radius || point.x > node.boxMax.x + radius ||
+		point.y < node.boxMin.y - radius || point.y > node.boxMax.y + radius ||
+		point.z < node.boxMin.z - radius || point.z > node.boxMax.z + radius)
+		return false;
+
+	if (node.firstChild < 0)
+		return true;
+
+	// the caps of the upper levels are much smaller than their boxes when the base is not axis aligned
+	glm::vec3 closest;
+	IntersectionTests::closestPointOnTriangle(&point[0], &node.start[0], &node.end[0], &node.peak[0], &closest[0]);
+
+	glm::vec3 diff = point - closest;
+	float reach = inflation + radius;
+
+	return glm::dot(diff, diff) <= reach * reach;
+}
+
+bool KochHierarchy::nodeCrossed(const KochNode& node, const glm::vec3& start, const glm::vec3& invDirection, float tFar, float& tNear) const
+{
+	tNear = 0.0f;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t1 = (node.boxMin[axis] - start[axis]) * invDirection[axis];
+		float t2 = (node.boxMax[axis] - start[axis]) * invDirection[axis];
+
+		if (t1 > t2) std::swap(t1, t2);
+		if (t1 > tNear) tNear = t1;
+		if (t2 < tFar) tFar = t2;
+
+		if (tNear > tFar)
+			return false;
+	}
+
+	return true;
+}
+
+bool KochHierarchy::pointCollision(const glm::vec3& point, float threshold) const
+{
+	if (nodes.empty())
+		return false;
+
+	int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	stack[top++] = 1;
+	stack[top++] = 2;
+
+	while (top > 0)
+	{
+		const KochNode& node = nodes[stack[--top]];
+
+		if (!nodeReached(node, point, threshold))
+			continue;
+
+		if (node.firstChild >= 0)
+		{
+			for (int c = 0; c < 4; c++)
+				stack[top++] = node.firstChild + c;
+			continue;
+		}
+
+		for (unsigned int s = node.firstSegment; s < node.lastSegment; s++)
+		{
+			const std::vector<unsigned int>& trianglesInSegment = tube->trianglesInBoxe[s];
+
+			for (int j = 0; j < trianglesInSegment.size(); j++)
+			{
+				int i = trianglesInSegment[j];
+				float dist = glm::dot(point - tube->verts[tube->triangles[i].x], tube->norms[i]);
+
+				if (abs(dist) < threshold && tube->BarycentricCalculation(point, dist, i))
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool KochHierarchy::sphereCollision(const glm::vec3& center, float radius) const
+{
+	if (nodes.empty())
+		return false;
+
+	int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	stack[top++] = 1;
+	stack[top++] = 2;
+
+	while (top > 0)
+	{
+		const KochNode& node = nodes[stack[--top]];
+
+		if (!nodeReached(node, center, radius))
+			continue;
+
+		if (node.firstChild >= 0)
+		{
+			for (int c = 0; c < 4; c++)
+				stack[top++] = node.firstChild + c;
+			continue;
+		}
+
+		for (unsigned int s = node.firstSegment; s < node.lastSegment; s++)
+		{
+			const std::vector<unsigned int>& trianglesInSegment = tube->trianglesInBoxe[s];
+
+			for (int j = 0; j < trianglesInSegment.size(); j++)
+			{
+				const glm::vec3& triangle = tube->triangles[trianglesInSegment[j]];
+
+				if (IntersectionTests::sphereTriangleIntersect(&center[0], radius, &tube->verts[triangle.x][0], &tube->verts[triangle.y][0], &tube->verts[triangle.z][0]))
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+#ifdef USE_SSE
+// lowers timeOfImpact to the first crossing of the line start + t * direction with the triangles of block, in the
+// operations of IntersectionTests::rayTriangleIntersect so the answers are those of testing the triangles one by one
+static bool segmentBlock(const KochTriangleBlock& block, const glm::vec3& start, const glm::vec3& direction, float& timeOfImpact)
+{
+	__m128 dx = _mm_set1_ps(direction.x);
+	__m128 dy = _mm_set1_ps(direction.y);
+	__m128 dz = _mm_set1_ps(direction.z);
+	__m128 e1x = _mm_loadu_ps(block.edge1[0]);
+	__m128 e1y = _mm_loadu_ps(block.edge1[1]);
+	__m128 e1z = _mm_loadu_ps(block.edge1[2]);
+	__m128 e2x = _mm_loadu_ps(block.edge2[0]);
+	__m128 e2y = _mm_loadu_ps(block.edge2[1]);
+	__m128 e2z = _mm_loadu_ps(block.edge2[2]);
+
+	__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+	__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+	__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+	__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+
+	// the scalar test drops a determinant below the double 0.000001, which for a float is one not above 0.000001f.
+	// The zero padding has a zero determinant.
+	__m128 absolute = _mm_max_ps(det, _mm_sub_ps(_mm_setzero_ps(), det));
+	__m128 hit = _mm_cmpgt_ps(absolute, _mm_set1_ps(0.000001f));
+	if (_mm_movemask_ps(hit) == 0)
+		return false;
+
+	__m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), det);
+	__m128 tx = _mm_sub_ps(_mm_set1_ps(start.x), _mm_loadu_ps(block.v0[0]));
+	__m128 ty = _mm_sub_ps(_mm_set1_ps(start.y), _mm_loadu_ps(block.v0[1]));
+	__m128 tz = _mm_sub_ps(_mm_set1_ps(start.z), _mm_loadu_ps(block.v0[2]));
+	__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inverse);
+
+	__m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+	__m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+	__m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+	__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+	__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+	hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+	hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, _mm_set1_ps(timeOfImpact))));
+
+	int lanes = _mm_movemask_ps(hit);
+	if (lanes == 0)
+		return false;
+
+	float times[4];
+	_mm_storeu_ps(times, t);
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (((lanes >> lane) & 1) && times[lane] <= timeOfImpact)
+			timeOfImpact = times[lane];
+	}
+	return true;
+}
+#endif
+
+bool KochHierarchy::segmentCollision(const glm::vec3& start, const glm::vec3& end, float& timeOfImpact) const
+{
+	timeOfImpact = 1.0f;
+
+	if (nodes.empty())
+		return false;
+
+	glm::vec3 direction = end - start;
+	glm::vec3 invDirection;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		// a zero component gives an infinite slab, which the box test handles through the sign of the infinities
+		invDirection[axis] = direction[axis] != 0.0f ? 1.0f / direction[axis] : 1e30f;
+	}
+
+	bool hit = false;
+
+	int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	stack[top++] = 1;
+	stack[top++] = 2;
+
+	while (top > 0)
+	{
+		const KochNode& node = nodes[stack[--top]];
+
+		float tNear;
+		if (!nodeCrossed(node, start, invDirection, timeOfImpact, tNear))
+			continue;
+
+		if (node.firstChild >= 0)
+		{
+			// the nearest child on top, so the first hit prunes the boxes behind it
+			int children[4];
+			float entries[4];
+			int count = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				float entry;
+				if (!nodeCrossed(nodes[node.firstChild + c], start, invDirection, timeOfImpact, entry))
+					continue;
+
+				int k = count++;
+				for (; k > 0 && entries[k - 1] < entry; k--)
+				{
+					children[k] = children[k - 1];
+					entries[k] = entries[k - 1];
+				}
+				children[k] = node.firstChild + c;
+				entries[k] = entry;
+			}
+
+			for (int c = 0; c < count; c++)
+				stack[top++] = children[c];
+			continue;
+		}
+
+		for (unsigned int s = node.firstSegment; s < node.lastSegment; s++)
+		{
+#ifdef USE_SSE
+			for (unsigned int b = segmentBlocks[s]; b < segmentBlocks[s + 1]; b++)
+				hit = segmentBlock(blocks[b], start, direction, timeOfImpact) || hit;
+#else
+			const std::vector<unsigned int>& trianglesInSegment = tube->trianglesInBoxe[s];
+
+			for (int j = 0; j < trianglesInSegment.size(); j++)
+			{
+				float t;
+
+				if (tube->RayTriangleCalculation(start, direction, trianglesInSegment[j], t))
+				{
+					if (t >= 0.0f && t <= timeOfImpact)
+					{
+						timeOfImpact = t;
+						hit = true;
+					}
+				}
+			}
+#endif
+		}
+	}
+
+	return hit;
+}
+
+bool KochHierarchy::rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const
+{
+	float timeOfImpact;
+
+	if (segmentCollision(origin, origin + direction * maxDistance, timeOfImpact))
+	{
+		distance = timeOfImpact * maxDistance;
+		return true;
+	}
+
+	distance = maxDistance;
+	return false;
+}
+
+int KochHierarchy::getDepth() const
+{
+	return depth;
+}
+
+int KochHierarchy::getNodeCount() const
+{
+	return nodes.size();
+}
+
+const std::vector<KochNode>& KochHierarchy::getNodes() const
+{
+	return nodes;
+}
@@ -0,0 +1,75 @@
+/*---Bounding hierarchy over the tube that follows the recursion of the Koch curve. Every level k sub-curve lies inside the
+equilateral cap over its base (the triangle of its two end corners and its peak) and has exactly 4 children, so the tree is
+known without any sorting or splitting. Nodes are stored level by level, level k starts at index 4^k - 1 (3 roots). The
+segment query visits the nodes the line crosses nearest first, and with SSE tests the triangles of each tube segment four
+at a time from a copy in blocks, one coordinate of the four per array.---*/
+
+#ifndef _KOCH_HIERARCHY_H
+#define _KOCH_HIERARCHY_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class Tube;
+
+struct KochNode
+{
+	glm::vec3 start, end, peak;		// cap triangle holding the sub-curve, the peak is the middle of the base at the leaves
+	glm::vec3 boxMin, boxMax;		// box around the cap grown by the inflation radius
+	int firstChild;					// index of the first of the 4 children, -1 at the leaves
+	unsigned int firstSegment;		// tube segments [firstSegment, lastSegment) around the sub-curve
+	unsigned int lastSegment;
+};
+
+// four triangles of a tube segment for the ray kernel, the padding lanes of the last block of a segment are all zero
+struct KochTriangleBlock
+{
+	float v0[3][4], edge1[3][4], edge2[3][4];		// [axis][lane], the edges are v1 - v0 and v2 - v0
+};
+
+class KochHierarchy
+{
+private:
+
+	Tube* tube;
+	int depth;						// dimension of the fractal, the leaves are single edges at this level
+	float inflation;				// distance of the tube surface from the unrounded curve
+	std::vector<KochNode> nodes;
+	std::vector<KochTriangleBlock> blocks;		// built for the SSE kernel only
+	std::vector<unsigned int> segmentBlocks;		// the blocks of segment s are [segmentBlocks[s], segmentBlocks[s + 1])
+
+	void buildNode(int i);
+	void buildBlocks();
+
+	// false when no point within radius of the tube surface can be in the node
+	bool nodeReached(const KochNode& node, const glm::vec3& point, float radius) const;
+	// clips the line start + t * (end - start) against the node box, tFar is the largest t of interest and tNear is set
+	// to where the line enters the box
+	bool nodeCrossed(const KochNode& node, const glm::vec3& start, const glm::vec3& invDirection, float tFar, float& tNear) const;
+
+public:
+
+	KochHierarchy();
+
+	// builds the hierarchy from the corners of the tube's flake. Every node is independent, so the build runs in parallel.
+	void build(Tube& tubeToBound, float tubeRadius);
+
+	// true when the point is closer than threshold to a tube triangle it projects into (same test as Tube::collisionBetweenPoint)
+	bool pointCollision(const glm::vec3& point, float threshold) const;
+
+	// true when the sphere touches a tube triangle
+	bool sphereCollision(const glm::vec3& center, float radius) const;
+
+	// true when the line from start to end crosses a tube triangle, timeOfImpact is the fraction (0..1) of the first crossing
+	bool segmentCollision(const glm::vec3& start, const glm::vec3& end, float& timeOfImpact) const;
+
+	// casts a ray (direction must be normalised) up to maxDistance, distance is measured from the origin
+	bool rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+	int getDepth() const;
+	int getNodeCount() const;
+	const std::vector<KochNode>& getNodes() const;
+};
+
+#endif
@@ -0,0 +1,212 @@
+#include "MultiResolutionCollision.h"
+#include "../tube.h"
+#include "../Utilities/IntersectionTests.h"
+#include "../Utilities/ParallelFor.h"
+
+#include <algorithm>
+
+static float pointSegmentDistance(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b)
+{
+	glm::vec3 ab = b - a;
+	float lengthSquared = glm::dot(ab, ab);
+	float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(p - a, ab) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+
+	return glm::length(p - (a + ab * t));
+}
+
+// closest distance between the segments p1-q1 and p2-q2, from "Real-Time Collision Detection" by C. Ericson
+static float segmentSegmentDistance(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2)
+{
+	glm::vec3 d1 = q1 - p1;
+	glm::vec3 d2 = q2 - p2;
+	glm::vec3 r = p1 - p2;
+	float a = glm::dot(d1, d1);
+	float e = glm::dot(d2, d2);
+	float f = glm::dot(d2, r);
+	float s, t;
+
+	if (a <= 1e-12f && e <= 1e-12f)
+		return glm::length(r);
+
+	if (a <= 1e-12f)
+	{
+		s = 0.0f;
+		t = glm::clamp(f / e, 0.0f, 1.0f);
+	}
+	else
+	{
+		float c = glm::dot(d1, r);
+
+		if (e <= 1e-12f)
+		{
+			t = 0.0f;
+			s = glm::clamp(-c / a, 0.0f, 1.0f);
+		}
+		else
+		{
+			float b = glm::dot(d1, d2);
+			float denom = a * e - b * b;
+
+			s = denom != 0.0f ? glm::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+			t = (b * s + f) / e;
+
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = glm::clamp(-c / a, 0.0f, 1.0f);
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+				s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+
+	return glm::length((p1 + d1 * s) - (p2 + d2 * t));
+}
+
+static float segmentTriangleDistance(const glm::vec3& a, const glm::vec3& b, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+{
+	float t, u, v;
+	glm::vec3 direction = b - a;
+
+	if (IntersectionTests::rayTriangleIntersect(&a[0], &direction[0], &v0[0], &v1[0], &v2[0], t, u, v) && t >= 0.0f && t <= 1.0f)
+		return 0.0f;
+
+	glm::vec3 closest;
+	IntersectionTests::closestPointOnTriangle(&a[0], &v0[0], &v1[0], &v2[0], &closest[0]);
+	float distance = glm::length(a - closest);
+
+	IntersectionTests::closestPointOnTriangle(&b[0], &v0[0], &v1[0], &v2[0], &closest[0]);
+	distance = std::min(distance, glm::length(b - closest));
+
+	distance = std::min(distance, segmentSegmentDistance(a, b, v0, v1));
+	distance = std::min(distance, segmentSegmentDistance(a, b, v1, v2));
+	distance = std::min(distance, segmentSegmentDistance(a, b, v2, v0));
+
+	return distance;
+}
+
+MultiResolutionCollision::MultiResolutionCollision()
+{
+	tube = NULL;
+}
+
+void MultiResolutionCollision::build(Tube& tubeToTest)
+{
+	tube = &tubeToTest;
+
+	const std::vector<KochNode>& nodes = tube->hierarchy.getNodes();
+	int segmentCount = tube->trianglesInBoxe.size();
+	int pathCount = tube->flake.verts.size();
+
+	nodeInner.resize(nodes.size());
+	nodeOuter.resize(nodes.size());
+	segmentInner.resize(segmentCount);
+	segmentOuter.resize(segmentCount);
+
+	ParallelFor::run(0, nodes.size(), [&](int i)
+	{
+		shellOfTriangles(nodes[i].start, nodes[i].end, nodes[i].firstSegment, nodes[i].lastSegment, nodeInner[i], nodeOuter[i]);
+	}, 1);
+
+	ParallelFor::run(0, segmentCount, [&](int s)
+	{
+		shellOfTriangles(tube->flake.verts[s], tube->flake.verts[(s + 1) % pathCount], s, s + 1, segmentInner[s], segmentOuter[s]);
+	});
+}
+
+void MultiResolutionCollision::shellOfTriangles(const glm::vec3& edgeStart, const glm::vec3& edgeEnd, unsigned int firstSegment, unsigned int lastSegment, float& inner, float& outer) const
+{
+	inner = 1e30f;
+	outer = 0.0f;
+
+	for (unsigned int s = firstSegment; s < lastSegment; s++)
+	{
+		const std::vector<unsigned int>& trianglesInSegment = tube->trianglesInBoxe[s];
+
+		for (int j = 0; j < trianglesInSegment.size(); j++)
+		{
+			const glm::vec3& triangle = tube->triangles[trianglesInSegment[j]];
+			const glm::vec3& v0 = tube->verts[triangle.x];
+			const glm::vec3& v1 = tube->verts[triangle.y];
+			const glm::vec3& v2 = tube->verts[triangle.z];
+
+			// the distance from a segment is convex, so the farthest point of a triangle is one of its corners
+			outer = std::max(outer, pointSegmentDistance(v0, edgeStart, edgeEnd));
+			outer = std::max(outer, pointSegmentDistance(v1, edgeStart, edgeEnd));
+			outer = std::max(outer, pointSegmentDistance(v2, edgeStart, edgeEnd));
+
+			inner = std::min(inner, segmentTriangleDistance(edgeStart, edgeEnd, v0, v1, v2));
+		}
+	}
+}
+
+float MultiResolutionCollision::shellDistance(const glm::vec3& point, const glm::vec3& edgeStart, const glm::vec3& edgeEnd, float inner, float outer)
+{
+	// every point q of the triangles has inner <= |q - edge| <= outer, so |point - q| >= the gap to that range
+	float distance = pointSegmentDistance(point, edgeStart, edgeEnd);
+
+	return std::max(inner - distance, distance - outer);
+}
+
+bool MultiResolutionCollision::pointCollision(const glm::vec3& point, float threshold, long long* shellTests, long long* triangleTests) const
+{
+	const std::vector<KochNode>& nodes = tube->hierarchy.getNodes();
+	if (nodes.empty())
+		return false;
+
+	int shells = 0, triangles = 0;
+	bool hit = false;
+
+	int pathCount = tube->flake.verts.size();
+
+	int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	stack[top++] = 1;
+	stack[top++] = 2;
+
+	while (top > 0 && !hit)
+	{
+		int i = stack[--top];
+		const KochNode& node = nodes[i];
+
+		shells++;
+		if (shellDistance(point, node.start, node.end, nodeInner[i], nodeOuter[i]) >= threshold)
+			continue;
+
+		if (node.firstChild >= 0)
+		{
+			for (int c = 0; c < 4; c++)
+				stack[top++] = node.firstChild + c;
+			continue;
+		}
+
+		for (unsigned int s = node.firstSegment; s < node.lastSegment && !hit; s++)
+		{
+			shells++;
+			if (shellDistance(point, tube->flake.verts[s], tube->flake.verts[(s + 1) % pathCount], segmentInner[s], segmentOuter[s]) >= threshold)
+				continue;
+
+			const std::vector<unsigned int>& trianglesInSegment = tube->trianglesInBoxe[s];
+
+			for (int j = 0; j < trianglesInSegment.size() && !hit; j++)
+			{
+				int t = trianglesInSegment[j];
+				float dist = glm::dot(point - tube->verts[tube->triangles[t].x], tube->norms[t]);
+
+				triangles++;
+				hit = abs(dist) < threshold && tube->BarycentricCalculation(point, dist, t);
+			}
+		}
+	}
+
+	if (shellTests != NULL)
+		*shellTests += shells;
+	if (triangleTests != NULL)
+		*triangleTests += triangles;
+
+	return hit;
+}
@@ -0,0 +1,48 @@
+/*---Coarse-to-fine point collision with the tube. Every node of the Koch hierarchy keeps the shell around its base edge
+(the straight line of the lower dimension curve) that holds all tube triangles of the node: the smallest and largest
+distance of those triangles from the edge. A point whose distance from the edge is outside the shell by more than the
+threshold can not touch any of the triangles, so only nodes where the finer curve comes near the point are refined. Below
+the leaves the same test is made against the segments of the tube before their triangles are tested.---*/
+
+#ifndef _MULTI_RESOLUTION_COLLISION_H
+#define _MULTI_RESOLUTION_COLLISION_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class Tube;
+
+class MultiResolutionCollision
+{
+private:
+
+	Tube* tube;
+
+	// shells of the hierarchy nodes, in the order of KochHierarchy::getNodes
+	std::vector<float> nodeInner;
+	std::vector<float> nodeOuter;
+
+	// shells of the tube segments around the line between their ring centres
+	std::vector<float> segmentInner;
+	std::vector<float> segmentOuter;
+
+	void shellOfTriangles(const glm::vec3& edgeStart, const glm::vec3& edgeEnd, unsigned int firstSegment, unsigned int lastSegment, float& inner, float& outer) const;
+
+	// smallest distance of the point from any triangle inside the shell around the edge
+	static float shellDistance(const glm::vec3& point, const glm::vec3& edgeStart, const glm::vec3& edgeEnd, float inner, float outer);
+
+public:
+
+	MultiResolutionCollision();
+
+	// computes the shells from the triangles of the tube, the hierarchy of the tube has to be built first
+	void build(Tube& tubeToTest);
+
+	// true when the point is closer than threshold to a tube triangle it projects into (same test as Tube::collisionBetweenPoint).
+	// The numbers of shells and triangles the query tested are added to shellTests and triangleTests when given, for the
+	// benchmarks, so queries on several threads each keep their own counts.
+	bool pointCollision(const glm::vec3& point, float threshold, long long* shellTests = NULL, long long* triangleTests = NULL) const;
+};
+
+#endif
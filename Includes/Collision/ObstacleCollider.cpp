@@ -0,0 +1,183 @@
+#include "ObstacleCollider.h"
+#include "../Obstacles/ObstacleTransforms.h"
+
+#include <cmath>
+
+ObstacleCollider::ObstacleCollider()
+{
+	count = 0;
+	offset = 0.0f;
+	proxyCentre = glm::vec3(0.0f);
+	proxyHalfSize = glm::vec3(0.0f);
+	radius = 0.0f;
+	cellSize = 1.0f;
+	tableMask = 0;
+}
+
+void ObstacleCollider::setProxy(const glm::vec3& centre, const glm::vec3& halfSize)
+{
+	proxyCentre = centre;
+	proxyHalfSize = halfSize;
+
+	if (count > 0)
+		buildHash();
+}
+
+void ObstacleCollider::setObstacles(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& directions,
+	const std::vector<float>& rotationSpeeds, float offsetFromPath)
+{
+	count = points.size();
+	offset = offsetFromPath;
+
+	pointX.resize(count);
+	pointY.resize(count);
+	pointZ.resize(count);
+	axisX.resize(count);
+	axisY.resize(count);
+	axisZ.resize(count);
+	rotationSpeed.resize(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 axis = glm::normalize(directions[i]);
+
+		pointX[i] = points[i].x;
+		pointY[i] = points[i].y;
+		pointZ[i] = points[i].z;
+		axisX[i] = axis.x;
+		axisY[i] = axis.y;
+		axisZ[i] = axis.z;
+		rotationSpeed[i] = rotationSpeeds[i];
+	}
+
+	buildHash();
+}
+
+unsigned int ObstacleCollider::cellOf(int x, int y, int z) const
+{
+	return ((unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u ^ (unsigned int)z * 83492791u) & tableMask;
+}
+
+unsigned int ObstacleCollider::cellOf(const glm::vec3& point) const
+{
+	return cellOf((int)floor(point.x / cellSize), (int)floor(point.y / cellSize), (int)floor(point.z / cellSize));
+}
+
+void ObstacleCollider::buildHash()
+{
+	// the box spins round the path point with the model, offset below it
+	radius = glm::length(proxyCentre + glm::vec3(0.0f, -offset, 0.0f)) + glm::length(proxyHalfSize);
+	cellSize = radius > 0.0f ? 2.0f * radius : 1.0f;
+
+	unsigned int tableSize = 16;
+	while (tableSize < 4 * (unsigned int)count)
+		tableSize *= 2;
+	tableMask = tableSize - 1;
+
+	// the cells of each sphere, found twice: once to count the entries of every cell and once to place them
+	std::vector<unsigned int> sphereCells;
+	std::vector<int> sphereStart(count + 1, 0);
+
+	for (int i = 0; i < count; i++)
+	{
+		sphereStart[i] = sphereCells.size();
+
+		glm::vec3 centre(pointX[i], pointY[i], pointZ[i]);
+		glm::ivec3 low((int)floor((centre.x - radius) / cellSize), (int)floor((centre.y - radius) / cellSize), (int)floor((centre.z - radius) / cellSize));
+		glm::ivec3 high((int)floor((centre.x + radius) / cellSize), (int)floor((centre.y + radius) / cellSize), (int)floor((centre.z + radius) / cellSize));
+
+		for (int x = low.x; x <= high.x; x++)
+		{
+			for (int y = low.y; y <= high.y; y++)
+			{
+				for (int z = low.z; z <= high.z; z++)
+				{
+					// different cells can hash to the same entry, the sphere is only stored there once
+					unsigned int cell = cellOf(x, y, z);
+					bool stored = false;
+					for (int c = sphereStart[i]; c < sphereCells.size() && !stored; c++)
+						stored = sphereCells[c] == cell;
+
+					if (!stored)
+						sphereCells.push_back(cell);
+				}
+			}
+		}
+	}
+	sphereStart[count] = sphereCells.size();
+
+	cellStart.assign(tableSize + 1, 0);
+	for (int c = 0; c < sphereCells.size(); c++)
+		cellStart[sphereCells[c] + 1]++;
+	for (int c = 0; c < tableSize; c++)
+		cellStart[c + 1] += cellStart[c];
+
+	// filled in obstacle order, so a point always meets the obstacles of its cell in the same order
+	std::vector<int> filled(cellStart.begin(), cellStart.end() - 1);
+	cellEntries.resize(sphereCells.size());
+	for (int i = 0; i < count; i++)
+	{
+		for (int c = sphereStart[i]; c < sphereStart[i + 1]; c++)
+			cellEntries[filled[sphereCells[c]]++] = i;
+	}
+}
+
+bool ObstacleCollider::insideProxy(int obstacle, const glm::vec3& point, double time) const
+{
+	glm::vec3 v = point - glm::vec3(pointX[obstacle], pointY[obstacle], pointZ[obstacle]);
+	if (glm::dot(v, v) > radius * radius)
+		return false;
+
+	// undo the spin, the rotation by minus the angle round the axis
+	float angle = glm::radians(ObstacleTransforms::spinAngle(rotationSpeed[obstacle], time));
+	float c = cos(angle);
+	float s = -sin(angle);
+	glm::vec3 axis(axisX[obstacle], axisY[obstacle], axisZ[obstacle]);
+	glm::vec3 local = v * c + glm::cross(axis, v) * s + axis * glm::dot(axis, v) * (1.0f - c);
+
+	// then the offset of the model from the path point
+	local.y += offset;
+
+	glm::vec3 d = glm::abs(local - proxyCentre);
+	return d.x <= proxyHalfSize.x && d.y <= proxyHalfSize.y && d.z <= proxyHalfSize.z;
+}
+
+int ObstacleCollider::pointHit(const glm::vec3& point, double time) const
+{
+	if (count == 0)
+		return -1;
+
+	unsigned int cell = cellOf(point);
+
+	for (int e = cellStart[cell]; e < cellStart[cell + 1]; e++)
+	{
+		if (insideProxy(cellEntries[e], point, time))
+			return cellEntries[e];
+	}
+
+	return -1;
+}
+
+int ObstacleCollider::candidateCount(const glm::vec3& point) const
+{
+	if (count == 0)
+		return 0;
+
+	unsigned int cell = cellOf(point);
+	return cellStart[cell + 1] - cellStart[cell];
+}
+
+int ObstacleCollider::getCount() const
+{
+	return count;
+}
+
+float ObstacleCollider::getRadius() const
+{
+	return radius;
+}
+
+int ObstacleCollider::getCellCount() const
+{
+	return cellStart.empty() ? 0 : (int)cellStart.size() - 1;
+}
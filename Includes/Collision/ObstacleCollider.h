@@ -0,0 +1,62 @@
+/*---Points, like projectiles, against the spinning obstacles. The broad phase is a uniform spatial hash of the spheres
+that hold each obstacle at every spin: the obstacles do not move along the path, so the hash is built once and a point
+only looks at the obstacles stored in its own cell. The narrow phase takes the point into the local frame of each of them
+at the current spin and tests it against a box proxy of the model.---*/
+
+#ifndef _OBSTACLE_COLLIDER_H
+#define _OBSTACLE_COLLIDER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class ObstacleCollider
+{
+private:
+
+	int count;
+	float offset;				// distance of the model from the path point, it circles the path at this distance
+	glm::vec3 proxyCentre;		// box in the space of the model
+	glm::vec3 proxyHalfSize;
+	float radius;				// sphere round the path point holding the box at every spin
+
+	std::vector<float> pointX, pointY, pointZ;
+	std::vector<float> axisX, axisY, axisZ;		// normalised rotation axis
+	std::vector<float> rotationSpeed;
+
+	// the hash, every cell is as wide as a sphere so a sphere is in at most 8 cells. The obstacles of cell c are
+	// cellEntries[cellStart[c]] to cellEntries[cellStart[c + 1] - 1].
+	float cellSize;
+	unsigned int tableMask;
+	std::vector<int> cellStart;
+	std::vector<int> cellEntries;
+
+	unsigned int cellOf(int x, int y, int z) const;
+	unsigned int cellOf(const glm::vec3& point) const;
+	void buildHash();
+
+public:
+
+	ObstacleCollider();
+
+	// the box of the model the points are tested against, in the space of the model
+	void setProxy(const glm::vec3& centre, const glm::vec3& halfSize);
+
+	void setObstacles(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& directions,
+		const std::vector<float>& rotationSpeeds, float offsetFromPath);
+
+	// the first obstacle whose box holds point at time, or -1
+	int pointHit(const glm::vec3& point, double time) const;
+
+	// true when point is inside the box of obstacle at time
+	bool insideProxy(int obstacle, const glm::vec3& point, double time) const;
+
+	// obstacles the broad phase hands to the narrow phase for point
+	int candidateCount(const glm::vec3& point) const;
+
+	int getCount() const;
+	float getRadius() const;
+	int getCellCount() const;
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "ObstacleIndex.h"
+#include "ObstacleTransforms.h"
+
+#include <algorithm>
+#include <cmath>
+
+ObstacleIndex::ObstacleIndex()
+{
+	count = 0;
+	pathLength = 0.0f;
+}
+
+void ObstacleIndex::build(float loopLength, const std::vector<float>& distances, const std::vector<glm::vec3>& points,
+	const std::vector<glm::vec3>& directions, const std::vector<float>& rotationSpeeds)
+{
+	count = distances.size();
+	pathLength = loopLength;
+
+	std::vector<int> order(count);
+	for (int i = 0; i < count; i++)
+		order[i] = i;
+
+	// stable, so obstacles at the same distance keep the order they were placed in
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return distances[a] < distances[b]; });
+
+	arcLength.resize(count);
+	pointX.resize(count);
+	pointY.resize(count);
+	pointZ.resize(count);
+	directionX.resize(count);
+	directionY.resize(count);
+	directionZ.resize(count);
+	rotationSpeed.resize(count);
+	spin.assign(count, 0.0f);
+
+	for (int i = 0; i < count; i++)
+	{
+		int o = order[i];
+
+		arcLength[i] = wrap(distances[o]);
+		pointX[i] = points[o].x;
+		pointY[i] = points[o].y;
+		pointZ[i] = points[o].z;
+		directionX[i] = directions[o].x;
+		directionY[i] = directions[o].y;
+		directionZ[i] = directions[o].z;
+		rotationSpeed[i] = rotationSpeeds[o];
+	}
+}
+
+float ObstacleIndex::wrap(float s) const
+{
+	if (pathLength <= 0.0f)
+		return s;
+
+	s = fmod(s, pathLength);
+	return s < 0.0f ? s + pathLength : s;
+}
+
+int ObstacleIndex::lowerBound(float s) const
+{
+	return std::lower_bound(arcLength.begin(), arcLength.end(), s) - arcLength.begin();
+}
+
+void ObstacleIndex::range(float from, float to, std::vector<int>& result) const
+{
+	if (count == 0 || to < from)
+		return;
+
+	if (to - from >= pathLength)
+	{
+		for (int i = 0; i < count; i++)
+			result.push_back(i);
+		return;
+	}
+
+	float start = wrap(from);
+	float end = start + (to - from);
+
+	int first = lowerBound(start);
+	int last = std::upper_bound(arcLength.begin(), arcLength.end(), end) - arcLength.begin();
+
+	for (int i = first; i < last; i++)
+		result.push_back(i);
+
+	// the range runs past the end of the path and continues from its start
+	if (end >= pathLength)
+	{
+		int wrappedLast = std::upper_bound(arcLength.begin(), arcLength.end(), end - pathLength) - arcLength.begin();
+		if (wrappedLast > first)
+			wrappedLast = first;
+
+		for (int i = 0; i < wrappedLast; i++)
+			result.push_back(i);
+	}
+}
+
+int ObstacleIndex::advance(int& cursor, float s) const
+{
+	if (count == 0)
+		return -1;
+
+	// a distance below the obstacle behind the cursor means the path was wrapped
+	if (cursor > count || (cursor > 0 && s < arcLength[cursor - 1]))
+		cursor = 0;
+
+	while (cursor < count && arcLength[cursor] < s)
+		cursor++;
+
+	return cursor < count ? cursor : 0;
+}
+
+void ObstacleIndex::updateSpins(const std::vector<int>& obstacles, double time)
+{
+	for (int i = 0; i < obstacles.size(); i++)
+	{
+		int o = obstacles[i];
+		spin[o] = ObstacleTransforms::spinAngle(rotationSpeed[o], time);
+	}
+}
+
+int ObstacleIndex::getCount() const
+{
+	return count;
+}
+
+float ObstacleIndex::getPathLength() const
+{
+	return pathLength;
+}
+
+float ObstacleIndex::getArcLength(int i) const
+{
+	return arcLength[i];
+}
+
+glm::vec3 ObstacleIndex::getPoint(int i) const
+{
+	return glm::vec3(pointX[i], pointY[i], pointZ[i]);
+}
+
+glm::vec3 ObstacleIndex::getDirection(int i) const
+{
+	return glm::vec3(directionX[i], directionY[i], directionZ[i]);
+}
+
+float ObstacleIndex::getRotationSpeed(int i) const
+{
+	return rotationSpeed[i];
+}
+
+float ObstacleIndex::getSpin(int i) const
+{
+	return spin[i];
+}
+
+void ObstacleIndex::copyTo(std::vector<glm::vec3>& points, std::vector<glm::vec3>& directions, std::vector<float>& rotationSpeeds) const
+{
+	points.resize(count);
+	directions.resize(count);
+	rotationSpeeds.resize(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		points[i] = getPoint(i);
+		directions[i] = getDirection(i);
+		rotationSpeeds[i] = rotationSpeed[i];
+	}
+}
@@ -0,0 +1,61 @@
+/*---The obstacles sorted by their distance along the closed path of the tube, stored as a structure of arrays. Obstacles
+within a range of distances are found with two binary searches, so a query costs O(log n + k) for k results. A cursor
+follows something moving forward along the path, like the player, in amortised constant time.---*/
+
+#ifndef _OBSTACLE_INDEX_H
+#define _OBSTACLE_INDEX_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class ObstacleIndex
+{
+private:
+
+	int count;
+	float pathLength;
+
+	std::vector<float> arcLength;			// ascending
+	std::vector<float> pointX, pointY, pointZ;
+	std::vector<float> directionX, directionY, directionZ;
+	std::vector<float> rotationSpeed;
+	std::vector<float> spin;				// angle of each obstacle in degrees, set by updateSpins
+
+	// first obstacle at or after distance s, count when there is none
+	int lowerBound(float s) const;
+
+	// distance wrapped into [0, pathLength)
+	float wrap(float s) const;
+
+public:
+
+	ObstacleIndex();
+
+	// sorts the obstacles by their distance along a path of length loopLength
+	void build(float loopLength, const std::vector<float>& distances, const std::vector<glm::vec3>& points,
+		const std::vector<glm::vec3>& directions, const std::vector<float>& rotationSpeeds);
+
+	// appends the obstacles with a distance in [from, to], wrapping round the end of the path, in path order from from
+	void range(float from, float to, std::vector<int>& result) const;
+
+	// moves cursor to the first obstacle at or after s and returns it. s has to grow between calls, except when it wraps
+	// round the end of the path. Past the last obstacle the first one is ahead.
+	int advance(int& cursor, float s) const;
+
+	// sets the spins of the given obstacles at time, the others keep the angle they had
+	void updateSpins(const std::vector<int>& obstacles, double time);
+
+	int getCount() const;
+	float getPathLength() const;
+	float getArcLength(int i) const;
+	glm::vec3 getPoint(int i) const;
+	glm::vec3 getDirection(int i) const;
+	float getRotationSpeed(int i) const;
+	float getSpin(int i) const;
+
+	// the obstacles as arrays of structures, in path order
+	void copyTo(std::vector<glm::vec3>& points, std::vector<glm::vec3>& directions, std::vector<float>& rotationSpeeds) const;
+};
+
+#endif
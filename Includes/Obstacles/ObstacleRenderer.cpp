@@ -0,0 +1,39 @@
+#include "../gl/glew.h"
+#include "ObstacleRenderer.h"
+#include "ObstacleTransforms.h"
+#include "../3dStruct/threeDModel.h"
+
+ObstacleRenderer::ObstacleRenderer()
+{
+	matrixBuffer = 0;
+	capacity = 0;
+}
+
+void ObstacleRenderer::createBuffers(ThreeDModel& model, Shader* myShader, int maxObstacles)
+{
+	capacity = maxObstacles > 0 ? maxObstacles : 1;
+
+	glGenBuffers(1, &matrixBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, matrixBuffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	model.addInstanceMatrix(myShader, "in_ModelMatrix", matrixBuffer);
+}
+
+void ObstacleRenderer::render(const ObstacleTransforms& transforms, ThreeDModel& model, Shader* myShader)
+{
+	const std::vector<glm::mat4>& matrices = transforms.getTransforms();
+
+	int count = matrices.size() < capacity ? matrices.size() : capacity;
+	if (count == 0)
+		return;
+
+	// only the visible obstacles are uploaded, the buffer is orphaned so the driver does not wait for the last frame
+	glBindBuffer(GL_ARRAY_BUFFER, matrixBuffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), &matrices[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	model.drawElementsInstancedUsingVBO(myShader, count);
+}
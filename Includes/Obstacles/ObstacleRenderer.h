@@ -0,0 +1,28 @@
+/*---Draws the obstacles with one instanced draw of a model, from the matrices of the visible obstacles built by
+ObstacleTransforms.---*/
+
+#ifndef _OBSTACLE_RENDERER_H
+#define _OBSTACLE_RENDERER_H
+
+class ObstacleTransforms;
+class ThreeDModel;
+class Shader;
+
+class ObstacleRenderer
+{
+private:
+
+	unsigned int matrixBuffer;			// one model matrix per instance
+	int capacity;
+
+public:
+
+	ObstacleRenderer();
+
+	// the model has to be loaded with the shader, whose in_ModelMatrix attribute reads the instance buffer
+	void createBuffers(ThreeDModel& model, Shader* myShader, int maxObstacles);
+
+	void render(const ObstacleTransforms& transforms, ThreeDModel& model, Shader* myShader);
+};
+
+#endif
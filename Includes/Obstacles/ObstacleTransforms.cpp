@@ -0,0 +1,254 @@
+#include "ObstacleTransforms.h"
+#include "../Utilities/Simd.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+ObstacleTransforms::ObstacleTransforms()
+{
+	count = 0;
+	offset = 0.0f;
+	radius = 0.0f;
+}
+
+float ObstacleTransforms::spinAngle(float speed, double time)
+{
+	return (float)fmod(speed * time, 360.0);
+}
+
+void ObstacleTransforms::setObstacles(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& directions,
+	const std::vector<float>& rotationSpeeds, float offsetFromPath, float modelRadius)
+{
+	count = points.size();
+	offset = offsetFromPath;
+	radius = offsetFromPath + modelRadius;
+
+	int padded = (count + 3) & ~3;
+
+	pointX.assign(padded, 0.0f);
+	pointY.assign(padded, 0.0f);
+	pointZ.assign(padded, 0.0f);
+	axisX.assign(padded, 0.0f);
+	axisY.assign(padded, 1.0f);
+	axisZ.assign(padded, 0.0f);
+	rotationSpeed.assign(padded, 0.0f);
+
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 axis = glm::normalize(directions[i]);
+
+		pointX[i] = points[i].x;
+		pointY[i] = points[i].y;
+		pointZ[i] = points[i].z;
+		axisX[i] = axis.x;
+		axisY[i] = axis.y;
+		axisZ[i] = axis.z;
+		rotationSpeed[i] = rotationSpeeds[i];
+	}
+
+	visible.reserve(count);
+	transforms.reserve(count);
+}
+
+int ObstacleTransforms::cull(const glm::mat4& viewProjection)
+{
+	visible.clear();
+
+	// the planes of the frustum from the rows of the matrix, normalised so the sphere radius can be compared
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; r++)
+		rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+
+	glm::vec4 planes[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+	for (int p = 0; p < 6; p++)
+		planes[p] /= glm::length(glm::vec3(planes[p]));
+
+#ifdef USE_SSE
+	__m128 negativeRadius = _mm_set1_ps(-radius);
+
+	for (int i = 0; i < count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&pointX[i]);
+		__m128 y = _mm_loadu_ps(&pointY[i]);
+		__m128 z = _mm_loadu_ps(&pointZ[i]);
+
+		int inside = 15;
+		for (int p = 0; p < 6 && inside != 0; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[p].x)), _mm_mul_ps(y, _mm_set1_ps(planes[p].y))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(planes[p].z)), _mm_set1_ps(planes[p].w)));
+			inside &= _mm_movemask_ps(_mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		for (int lane = 0; inside != 0; lane++, inside >>= 1)
+		{
+			if ((inside & 1) && i + lane < count)
+				visible.push_back(i + lane);
+		}
+	}
+#else
+	for (int i = 0; i < count; i++)
+	{
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++)
+		{
+			inside = pointX[i] * planes[p].x + pointY[i] * planes[p].y + pointZ[i] * planes[p].z + planes[p].w >= -radius;
+		}
+
+		if (inside)
+			visible.push_back(i);
+	}
+#endif
+
+	return visible.size();
+}
+
+void ObstacleTransforms::showAll()
+{
+	visible.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		visible[i] = i;
+	}
+}
+
+#ifdef USE_SSE
+// sin(2 pi turns) of four angles given in turns in [-0.5, 0.5], folded to the quarter turn round 0 where the series
+// to x^11 is good to float precision
+static __m128 sinTurns(__m128 turns)
+{
+	__m128 signBit = _mm_set1_ps(-0.0f);
+	__m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(turns, signBit));
+	__m128 outer = _mm_cmpgt_ps(_mm_andnot_ps(signBit, turns), _mm_set1_ps(0.25f));
+
+	// sin(pi - x) = sin(x)
+	turns = _mm_or_ps(_mm_and_ps(outer, _mm_sub_ps(half, turns)), _mm_andnot_ps(outer, turns));
+
+	__m128 x = _mm_mul_ps(turns, _mm_set1_ps(6.28318531f));
+	__m128 x2 = _mm_mul_ps(x, x);
+
+	__m128 series = _mm_set1_ps(-2.50521084e-8f);
+	series = _mm_add_ps(_mm_mul_ps(series, x2), _mm_set1_ps(2.75573192e-6f));
+	series = _mm_add_ps(_mm_mul_ps(series, x2), _mm_set1_ps(-1.98412698e-4f));
+	series = _mm_add_ps(_mm_mul_ps(series, x2), _mm_set1_ps(8.33333333e-3f));
+	series = _mm_add_ps(_mm_mul_ps(series, x2), _mm_set1_ps(-1.66666667e-1f));
+	series = _mm_add_ps(_mm_mul_ps(series, x2), _mm_set1_ps(1.0f));
+
+	return _mm_mul_ps(series, x);
+}
+#endif
+
+void ObstacleTransforms::build(double time)
+{
+	int visibleCount = visible.size();
+	transforms.resize(visibleCount);
+
+	// one thread, the whole frame is a few matrices per microsecond and starting threads for it costs more
+	for (int first = 0; first < visibleCount; first += 4)
+	{
+		int lanes = visibleCount - first < 4 ? visibleCount - first : 4;
+
+		// the spin as a fraction of a turn, taken off the whole turns in double as spinAngle does
+		float x[4], y[4], z[4], px[4], py[4], pz[4], turns[4];
+		for (int lane = 0; lane < 4; lane++)
+		{
+			int i = visible[first + (lane < lanes ? lane : lanes - 1)];
+			double spin = rotationSpeed[i] * time / 360.0;
+
+			x[lane] = axisX[i];
+			y[lane] = axisY[i];
+			z[lane] = axisZ[i];
+			px[lane] = pointX[i];
+			py[lane] = pointY[i];
+			pz[lane] = pointZ[i];
+			turns[lane] = (float)(spin - floor(spin));
+		}
+
+#ifdef USE_SSE
+		__m128 ax = _mm_loadu_ps(x), ay = _mm_loadu_ps(y), az = _mm_loadu_ps(z);
+
+		// from [0, 1) turns to [-0.5, 0.5], and a quarter turn on for the cosine
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 spin = _mm_loadu_ps(turns);
+		spin = _mm_sub_ps(spin, _mm_and_ps(_mm_cmpgt_ps(spin, _mm_set1_ps(0.5f)), one));
+		__m128 cosineSpin = _mm_add_ps(spin, _mm_set1_ps(0.25f));
+		cosineSpin = _mm_sub_ps(cosineSpin, _mm_and_ps(_mm_cmpgt_ps(cosineSpin, _mm_set1_ps(0.5f)), one));
+
+		__m128 vs = sinTurns(spin), vc = sinTurns(cosineSpin);
+		__m128 t = _mm_sub_ps(one, vc);
+		__m128 tx = _mm_mul_ps(t, ax), ty = _mm_mul_ps(t, ay), tz = _mm_mul_ps(t, az);
+
+		// the columns of the rotation, as glm::rotate builds them
+		__m128 columns[4][4];
+		columns[0][0] = _mm_add_ps(vc, _mm_mul_ps(tx, ax));
+		columns[0][1] = _mm_add_ps(_mm_mul_ps(tx, ay), _mm_mul_ps(vs, az));
+		columns[0][2] = _mm_sub_ps(_mm_mul_ps(tx, az), _mm_mul_ps(vs, ay));
+		columns[1][0] = _mm_sub_ps(_mm_mul_ps(ty, ax), _mm_mul_ps(vs, az));
+		columns[1][1] = _mm_add_ps(vc, _mm_mul_ps(ty, ay));
+		columns[1][2] = _mm_add_ps(_mm_mul_ps(ty, az), _mm_mul_ps(vs, ax));
+		columns[2][0] = _mm_add_ps(_mm_mul_ps(tz, ax), _mm_mul_ps(vs, ay));
+		columns[2][1] = _mm_sub_ps(_mm_mul_ps(tz, ay), _mm_mul_ps(vs, ax));
+		columns[2][2] = _mm_add_ps(vc, _mm_mul_ps(tz, az));
+
+		// the model sits offset below the path point in the spinning frame
+		__m128 down = _mm_set1_ps(-offset);
+		columns[3][0] = _mm_add_ps(_mm_mul_ps(columns[1][0], down), _mm_loadu_ps(px));
+		columns[3][1] = _mm_add_ps(_mm_mul_ps(columns[1][1], down), _mm_loadu_ps(py));
+		columns[3][2] = _mm_add_ps(_mm_mul_ps(columns[1][2], down), _mm_loadu_ps(pz));
+
+		for (int col = 0; col < 4; col++)
+		{
+			columns[col][3] = _mm_set1_ps(col == 3 ? 1.0f : 0.0f);
+
+			// from one component of four obstacles to four components of one obstacle
+			_MM_TRANSPOSE4_PS(columns[col][0], columns[col][1], columns[col][2], columns[col][3]);
+
+			for (int lane = 0; lane < lanes; lane++)
+				_mm_storeu_ps(&transforms[first + lane][col][0], columns[col][lane]);
+		}
+#else
+		for (int lane = 0; lane < lanes; lane++)
+		{
+			float angle = turns[lane] * 6.28318531f;
+			float c = cos(angle), s = sin(angle);
+			float t = 1.0f - c;
+			glm::mat4& m = transforms[first + lane];
+
+			m[0] = glm::vec4(c + t * x[lane] * x[lane], t * x[lane] * y[lane] + s * z[lane], t * x[lane] * z[lane] - s * y[lane], 0.0f);
+			m[1] = glm::vec4(t * y[lane] * x[lane] - s * z[lane], c + t * y[lane] * y[lane], t * y[lane] * z[lane] + s * x[lane], 0.0f);
+			m[2] = glm::vec4(t * z[lane] * x[lane] + s * y[lane], t * z[lane] * y[lane] - s * x[lane], c + t * z[lane] * z[lane], 0.0f);
+			m[3] = glm::vec4(glm::vec3(m[1]) * -offset + glm::vec3(px[lane], py[lane], pz[lane]), 1.0f);
+		}
+#endif
+	}
+}
+
+void ObstacleTransforms::buildReference(double time, std::vector<glm::mat4>& reference) const
+{
+	reference.resize(visible.size());
+
+	for (int v = 0; v < visible.size(); v++)
+	{
+		int i = visible[v];
+
+		glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(pointX[i], pointY[i], pointZ[i]));
+		m = glm::rotate(m, spinAngle(rotationSpeed[i], time), glm::vec3(axisX[i], axisY[i], axisZ[i]));
+		reference[v] = glm::translate(m, glm::vec3(0.0f, -offset, 0.0f));
+	}
+}
+
+int ObstacleTransforms::getCount() const
+{
+	return count;
+}
+
+const std::vector<int>& ObstacleTransforms::getVisible() const
+{
+	return visible;
+}
+
+const std::vector<glm::mat4>& ObstacleTransforms::getTransforms() const
+{
+	return transforms;
+}
@@ -0,0 +1,57 @@
+/*---The model matrices of the obstacles for an instanced draw. The static part of every obstacle (its point on the path,
+rotation axis and spin speed) is kept as a structure of arrays. Each frame the obstacles are culled against the view
+frustum, and the matrices of the visible ones are built four at a time with SSE, sin and cos included.---*/
+
+#ifndef _OBSTACLE_TRANSFORMS_H
+#define _OBSTACLE_TRANSFORMS_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class ObstacleTransforms
+{
+private:
+
+	int count;
+
+	// one entry per obstacle, padded to a multiple of 4 for the SSE loops
+	std::vector<float> pointX, pointY, pointZ;
+	std::vector<float> axisX, axisY, axisZ;		// normalised rotation axis
+	std::vector<float> rotationSpeed;
+
+	float offset;			// distance of the model from the path point, it circles the path at this distance
+	float radius;			// sphere round the path point holding the model at every spin
+
+	std::vector<int> visible;
+	std::vector<glm::mat4> transforms;			// one per visible obstacle, in the order of visible
+
+public:
+
+	ObstacleTransforms();
+
+	// angle in degrees at time of an obstacle spinning speed degrees per time unit
+	static float spinAngle(float speed, double time);
+
+	// modelRadius is the radius of the sphere round the model
+	void setObstacles(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& directions,
+		const std::vector<float>& rotationSpeeds, float offsetFromPath, float modelRadius);
+
+	// keeps the obstacles whose sphere is at least partly inside the frustum of viewProjection, returns how many
+	int cull(const glm::mat4& viewProjection);
+
+	// marks every obstacle visible
+	void showAll();
+
+	// model matrices of the visible obstacles at time, translate(point) * rotate(spin, axis) * translate(0, -offset, 0)
+	void build(double time);
+
+	// the same matrices with the glm calls, one obstacle at a time
+	void buildReference(double time, std::vector<glm::mat4>& reference) const;
+
+	int getCount() const;
+	const std::vector<int>& getVisible() const;
+	const std::vector<glm::mat4>& getTransforms() const;
+};
+
+#endif
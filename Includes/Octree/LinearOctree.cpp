@@ -0,0 +1,912 @@
+#include "../gl/glew.h"
+#include "LinearOctree.h"
+#include "../3DStruct/threeDModel.h"
+#include "../Box.h"
+#include "../Utilities/IntersectionTests.h"
+#include "../Utilities/ParallelFor.h"
+#include "../Utilities/Simd.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+// the faces of a ThreeDModel for SpatialOctree, tested against the cells the way Octree tests them
+struct ModelFaceSource
+{
+	ThreeDModel& model;
+
+	ModelFaceSource(ThreeDModel& model) : model(model)
+	{
+	}
+
+	int getCount() const
+	{
+		return model.numberOfTriangles;
+	}
+
+	void getExtent(double minimum[3], double maximum[3]) const
+	{
+		model.calcBoundingBox(minimum[0], minimum[1], minimum[2], maximum[0], maximum[1], maximum[2]);
+	}
+
+	void getBounds(int i, float low[3], float high[3]) const
+	{
+		for (int a = 0; a < 3; a++)
+		{
+			low[a] = high[a] = (&model.theVerts[model.theFaces[i].thePoints[0]].x)[a];
+			for (int v = 1; v < 3; v++)
+			{
+				float c = (&model.theVerts[model.theFaces[i].thePoints[v]].x)[a];
+				low[a] = c < low[a] ? c : low[a];
+				high[a] = c > high[a] ? c : high[a];
+			}
+		}
+	}
+
+	bool overlaps(int i, const double centre[3], const double halfSize[3]) const
+	{
+		return model.isPrimitiveIntersectingOctreeCell(const_cast<double*>(centre), const_cast<double*>(halfSize), i);
+	}
+};
+
+
+// calls classify(i, keys) for every i in [0, count), in blocks split over the threads, and returns all the keys sorted.
+// Each block sorts its own keys, then the blocks are merged in pairs, the pairs of each round in parallel.
+template <class Classify>
+static void collectSortedKeys(int count, Classify classify, std::vector<unsigned long long>& keys)
+{
+	const int blockSize = 4096;
+	int blockCount = (count + blockSize - 1) / blockSize;
+
+	std::vector<std::vector<unsigned long long> > blocks(blockCount);
+	ParallelFor::run(0, blockCount, [&](int b)
+	{
+		int end = (b + 1) * blockSize < count ? (b + 1) * blockSize : count;
+		for (int i = b * blockSize; i < end; i++)
+			classify(i, blocks[b]);
+
+		std::sort(blocks[b].begin(), blocks[b].end());
+	}, 1);
+
+	while (blocks.size() > 1)
+	{
+		int pairs = blocks.size() / 2;
+		std::vector<std::vector<unsigned long long> > merged((blocks.size() + 1) / 2);
+
+		ParallelFor::run(0, pairs, [&](int p)
+		{
+			std::vector<unsigned long long>& a = blocks[2 * p];
+			std::vector<unsigned long long>& b = blocks[2 * p + 1];
+			merged[p].resize(a.size() + b.size());
+			std::merge(a.begin(), a.end(), b.begin(), b.end(), merged[p].begin());
+		}, 1);
+
+		if (blocks.size() % 2 == 1)
+			merged.back().swap(blocks.back());
+
+		blocks.swap(merged);
+	}
+
+	keys.clear();
+	if (blockCount > 0)
+		keys.swap(blocks[0]);
+}
+
+
+LinearOctree::LinearOctree()
+{
+	peakBuildMemory = 0;
+	clear();
+}
+
+LinearOctree::~LinearOctree()
+{
+	for (int i = 0; i < boxes.size(); i++)
+		delete boxes[i];
+}
+
+void LinearOctree::clear()
+{
+	for (int i = 0; i < boxes.size(); i++)
+		delete boxes[i];
+	boxes.clear();
+
+	tree.clear();
+	std::vector<TriangleBlock>().swap(blocks);
+	std::vector<int>().swap(vertices);
+	std::vector<int>().swap(vertexRanges);
+	file.close();
+
+	nodeData = NULL;
+	nodeCount = 0;
+	depth = 0;
+	primitiveData = NULL;
+	blockData = NULL;
+	blockCount = 0;
+
+	meshPositions = NULL;
+	meshFaces = NULL;
+	meshNormals = NULL;
+}
+
+void LinearOctree::build(ThreeDModel& model, const BuildParameters& parameters)
+{
+	clear();
+
+	tree.build(ModelFaceSource(model), parameters);
+	peakBuildMemory = tree.getPeakBuildMemory();
+
+	buildBlocks(model);
+
+	nodeData = tree.getNodes();
+	nodeCount = tree.getNodeCount();
+	depth = tree.getDepth();
+	primitiveData = tree.getPrimitiveArena();
+	blockData = blocks.empty() ? NULL : &blocks[0];
+	blockCount = blocks.size();
+
+	boxes.assign(nodeCount, NULL);
+}
+
+void LinearOctree::buildVertexLists(ThreeDModel& model)
+{
+	// a loaded octree has no tree to classify the vertices in
+	if (tree.getNodeCount() == 0)
+		return;
+
+	const std::vector<int>& leafOrder = tree.getLeafOrder();
+	std::vector<int> leafRank(tree.getNodeCount(), -1);
+	for (int l = 0; l < leafOrder.size(); l++)
+		leafRank[leafOrder[l]] = l;
+
+	//---the vertices, each in the leaves whose cell holds it---
+	std::vector<unsigned long long> keys;
+	collectSortedKeys(model.numberOfVertices, [&](int v, std::vector<unsigned long long>& blockKeys)
+	{
+		const float* position = &model.theVerts[v].x;
+
+		int stack[8 * MAX_LEVELS + 1];
+		int top = 0;
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			int n = stack[--top];
+			const Node& node = tree.getNode(n);
+			if (node.level > 0 && (position[0] < node.min[0] || position[0] > node.max[0] || position[1] < node.min[1] || position[1] > node.max[1]
+				|| position[2] < node.min[2] || position[2] > node.max[2]))
+				continue;
+
+			if (node.childMask == 0)
+			{
+				blockKeys.push_back(((unsigned long long)leafRank[n] << 32) | (unsigned int)v);
+				continue;
+			}
+
+			for (int c = tree.getChildCount(n) - 1; c >= 0; c--)
+				stack[top++] = node.firstChild + c;
+		}
+	}, keys);
+
+	peakBuildMemory = std::max(peakBuildMemory, tree.getMemoryUsed() + 2 * keys.capacity() * sizeof(unsigned long long));
+
+	vertices.resize(keys.size());
+	vertexRanges.assign(2 * tree.getNodeCount(), 0);
+	for (int i = 0; i < keys.size(); i++)
+	{
+		vertexRanges[2 * leafOrder[keys[i] >> 32] + 1]++;
+		vertices[i] = (int)(keys[i] & 0xffffffffu);
+	}
+
+	int vertexStart = 0;
+	for (int l = 0; l < leafOrder.size(); l++)
+	{
+		vertexRanges[2 * leafOrder[l]] = vertexStart;
+		vertexStart += vertexRanges[2 * leafOrder[l] + 1];
+	}
+
+	// an inner node's list is those of its leaves, and its children come after it in the array
+	for (int n = tree.getNodeCount() - 1; n >= 0; n--)
+	{
+		const Node& node = tree.getNode(n);
+		if (node.childMask == 0)
+			continue;
+
+		int last = node.firstChild + tree.getChildCount(n) - 1;
+		vertexRanges[2 * n] = vertexRanges[2 * node.firstChild];
+		vertexRanges[2 * n + 1] = vertexRanges[2 * last] + vertexRanges[2 * last + 1] - vertexRanges[2 * n];
+	}
+}
+
+LinearOctree::Statistics LinearOctree::getStatistics() const
+{
+	Statistics statistics = SpatialOctree<ModelFaceSource, Node>::getStatistics(nodeData, nodeCount);
+	statistics.memory = getMemoryUsed();
+	return statistics;
+}
+
+void LinearOctree::printStatistics() const
+{
+	Statistics statistics = getStatistics();
+	cout << " Octree: " << statistics.nodeCount << " nodes, " << statistics.leafCount << " leaves, depth " << statistics.depth << ", "
+		<< statistics.averageLeafPrimitives << " triangles per leaf on average and " << statistics.maxLeafPrimitives << " at most, "
+		<< statistics.memory / 1024 << " KB" << endl;
+}
+
+int LinearOctree::getDepth() const
+{
+	return depth;
+}
+
+int LinearOctree::getNodeCount() const
+{
+	return nodeCount;
+}
+
+const LinearOctree::Node& LinearOctree::getNode(int node) const
+{
+	return nodeData[node];
+}
+
+bool LinearOctree::isLeaf(int node) const
+{
+	return nodeData[node].childMask == 0;
+}
+
+int LinearOctree::getChild(int node, int octant) const
+{
+	return SpatialOctree<ModelFaceSource, Node>::getChild(nodeData[node], octant);
+}
+
+const int* LinearOctree::getPrimitives(int node) const
+{
+	return primitiveData == NULL ? NULL : primitiveData + nodeData[node].primitiveStart;
+}
+
+const int* LinearOctree::getVertices(int node) const
+{
+	return vertexRanges.empty() || vertices.empty() ? NULL : &vertices[0] + vertexRanges[2 * node];
+}
+
+int LinearOctree::getVertexCount(int node) const
+{
+	return vertexRanges.empty() ? 0 : vertexRanges[2 * node + 1];
+}
+
+size_t LinearOctree::getMemoryUsed() const
+{
+	if (file.isOpen())
+		return file.getSize();
+
+	return tree.getMemoryUsed() + blocks.capacity() * sizeof(TriangleBlock) + (vertices.capacity() + vertexRanges.capacity()) * sizeof(int);
+}
+
+size_t LinearOctree::getPeakBuildMemory() const
+{
+	return peakBuildMemory;
+}
+
+void LinearOctree::buildBlocks(ThreeDModel& model)
+{
+	const std::vector<int>& leafOrder = tree.getLeafOrder();
+
+	int blockCount = 0;
+	for (int n = 0; n < tree.getNodeCount(); n++)
+	{
+		tree.getNode(n).blockStart = 0;
+		tree.getNode(n).blockCount = 0;
+	}
+
+	for (int l = 0; l < leafOrder.size(); l++)
+	{
+		Node& leaf = tree.getNode(leafOrder[l]);
+		leaf.blockStart = blockCount;
+		leaf.blockCount = (leaf.primitiveCount + 3) / 4;
+		blockCount += leaf.blockCount;
+	}
+
+	unsigned int allBits = 0xffffffffu;
+	float laneOn;
+	memcpy(&laneOn, &allBits, sizeof(float));
+
+	blocks.assign(blockCount, TriangleBlock());
+	ParallelFor::run(0, leafOrder.size(), [&](int l)
+	{
+		const Node& leaf = tree.getNode(leafOrder[l]);
+
+		for (int i = 0; i < 4 * leaf.blockCount; i++)
+		{
+			TriangleBlock& block = blocks[leaf.blockStart + i / 4];
+			int lane = i % 4;
+
+			block.faces[lane] = i < leaf.primitiveCount ? tree.getPrimitives(leafOrder[l])[i] : -1;
+			block.laneMask[lane] = 0.0f;
+			if (block.faces[lane] < 0)
+				continue;
+
+			const unsigned int* points = model.theFaces[block.faces[lane]].thePoints;
+			glm::vec3 v0(model.theVerts[points[0]].x, model.theVerts[points[0]].y, model.theVerts[points[0]].z);
+			glm::vec3 v1(model.theVerts[points[1]].x, model.theVerts[points[1]].y, model.theVerts[points[1]].z);
+			glm::vec3 v2(model.theVerts[points[2]].x, model.theVerts[points[2]].y, model.theVerts[points[2]].z);
+
+			glm::vec3 edge0 = v2 - v0;
+			glm::vec3 edge1 = v1 - v0;
+			glm::vec3 normal = glm::cross(edge1, edge0);
+			float lengthSquared = glm::dot(normal, normal);
+			float dot00 = glm::dot(edge0, edge0);
+			float dot01 = glm::dot(edge0, edge1);
+			float dot11 = glm::dot(edge1, edge1);
+			float denominator = dot00 * dot11 - dot01 * dot01;
+
+			for (int a = 0; a < 3; a++)
+			{
+				block.v0[a][lane] = v0[a];
+				block.v1[a][lane] = v1[a];
+				block.v2[a][lane] = v2[a];
+				block.normal[a][lane] = lengthSquared > 0.0f ? normal[a] / sqrt(lengthSquared) : 0.0f;
+			}
+			block.dot00[lane] = dot00;
+			block.dot01[lane] = dot01;
+			block.dot11[lane] = dot11;
+			block.invDenom[lane] = denominator != 0.0f ? 1.0f / denominator : 0.0f;
+			block.laneMask[lane] = lengthSquared > 0.0f && denominator != 0.0f ? laneOn : 0.0f;
+		}
+	}, 16);
+}
+
+
+#ifndef USE_SSE
+static bool laneActive(const LinearOctree::TriangleBlock& block, int lane)
+{
+	unsigned int bits;
+	memcpy(&bits, &block.laneMask[lane], sizeof(bits));
+	return bits != 0;
+}
+#endif
+
+// the lanes of block whose triangle the point projects into from closer than threshold, a bit per lane
+static int pointBlock(const LinearOctree::TriangleBlock& block, const glm::vec3& point, float threshold)
+{
+#ifdef USE_SSE
+	__m128 dx = _mm_sub_ps(_mm_set1_ps(point.x), _mm_loadu_ps(block.v0[0]));
+	__m128 dy = _mm_sub_ps(_mm_set1_ps(point.y), _mm_loadu_ps(block.v0[1]));
+	__m128 dz = _mm_sub_ps(_mm_set1_ps(point.z), _mm_loadu_ps(block.v0[2]));
+	__m128 nx = _mm_loadu_ps(block.normal[0]);
+	__m128 ny = _mm_loadu_ps(block.normal[1]);
+	__m128 nz = _mm_loadu_ps(block.normal[2]);
+
+	__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, nx), _mm_mul_ps(dy, ny)), _mm_mul_ps(dz, nz));
+	__m128 absolute = _mm_max_ps(dist, _mm_sub_ps(_mm_setzero_ps(), dist));
+	__m128 hit = _mm_and_ps(_mm_cmplt_ps(absolute, _mm_set1_ps(threshold)), _mm_loadu_ps(block.laneMask));
+	if (_mm_movemask_ps(hit) == 0)
+		return 0;
+
+	// the point projected on the plane, from v0
+	__m128 qx = _mm_sub_ps(dx, _mm_mul_ps(nx, dist));
+	__m128 qy = _mm_sub_ps(dy, _mm_mul_ps(ny, dist));
+	__m128 qz = _mm_sub_ps(dz, _mm_mul_ps(nz, dist));
+
+	__m128 e0x = _mm_sub_ps(_mm_loadu_ps(block.v2[0]), _mm_loadu_ps(block.v0[0]));
+	__m128 e0y = _mm_sub_ps(_mm_loadu_ps(block.v2[1]), _mm_loadu_ps(block.v0[1]));
+	__m128 e0z = _mm_sub_ps(_mm_loadu_ps(block.v2[2]), _mm_loadu_ps(block.v0[2]));
+	__m128 e1x = _mm_sub_ps(_mm_loadu_ps(block.v1[0]), _mm_loadu_ps(block.v0[0]));
+	__m128 e1y = _mm_sub_ps(_mm_loadu_ps(block.v1[1]), _mm_loadu_ps(block.v0[1]));
+	__m128 e1z = _mm_sub_ps(_mm_loadu_ps(block.v1[2]), _mm_loadu_ps(block.v0[2]));
+
+	__m128 dot02 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0x, qx), _mm_mul_ps(e0y, qy)), _mm_mul_ps(e0z, qz));
+	__m128 dot12 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, qx), _mm_mul_ps(e1y, qy)), _mm_mul_ps(e1z, qz));
+	__m128 dot00 = _mm_loadu_ps(block.dot00);
+	__m128 dot01 = _mm_loadu_ps(block.dot01);
+	__m128 dot11 = _mm_loadu_ps(block.dot11);
+	__m128 invDenom = _mm_loadu_ps(block.invDenom);
+
+	__m128 u = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dot11, dot02), _mm_mul_ps(dot01, dot12)), invDenom);
+	__m128 v = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dot00, dot12), _mm_mul_ps(dot01, dot02)), invDenom);
+
+	__m128 zero = _mm_setzero_ps();
+	hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)));
+	hit = _mm_and_ps(hit, _mm_cmplt_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+
+	return _mm_movemask_ps(hit);
+#else
+	int hits = 0;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (!laneActive(block, lane))
+			continue;
+
+		glm::vec3 v0(block.v0[0][lane], block.v0[1][lane], block.v0[2][lane]);
+		glm::vec3 normal(block.normal[0][lane], block.normal[1][lane], block.normal[2][lane]);
+		float dist = glm::dot(point - v0, normal);
+		if (abs(dist) >= threshold)
+			continue;
+
+		glm::vec3 q = point - normal * dist - v0;
+		glm::vec3 edge0 = glm::vec3(block.v2[0][lane], block.v2[1][lane], block.v2[2][lane]) - v0;
+		glm::vec3 edge1 = glm::vec3(block.v1[0][lane], block.v1[1][lane], block.v1[2][lane]) - v0;
+		float dot02 = glm::dot(edge0, q);
+		float dot12 = glm::dot(edge1, q);
+		float u = (block.dot11[lane] * dot02 - block.dot01[lane] * dot12) * block.invDenom[lane];
+		float v = (block.dot00[lane] * dot12 - block.dot01[lane] * dot02) * block.invDenom[lane];
+
+		if (u >= 0.0f && v >= 0.0f && u + v < 1.0f)
+			hits |= 1 << lane;
+	}
+	return hits;
+#endif
+}
+
+// the lanes of block whose plane is closer than radius to centre, the triangles the sphere can touch
+static int planeBlock(const LinearOctree::TriangleBlock& block, const glm::vec3& centre, float radius)
+{
+#ifdef USE_SSE
+	__m128 dx = _mm_sub_ps(_mm_set1_ps(centre.x), _mm_loadu_ps(block.v0[0]));
+	__m128 dy = _mm_sub_ps(_mm_set1_ps(centre.y), _mm_loadu_ps(block.v0[1]));
+	__m128 dz = _mm_sub_ps(_mm_set1_ps(centre.z), _mm_loadu_ps(block.v0[2]));
+
+	__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(block.normal[0])), _mm_mul_ps(dy, _mm_loadu_ps(block.normal[1]))),
+		_mm_mul_ps(dz, _mm_loadu_ps(block.normal[2])));
+	__m128 absolute = _mm_max_ps(dist, _mm_sub_ps(_mm_setzero_ps(), dist));
+
+	return _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(absolute, _mm_set1_ps(radius)), _mm_loadu_ps(block.laneMask)));
+#else
+	int lanes = 0;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (!laneActive(block, lane))
+			continue;
+
+		glm::vec3 d = centre - glm::vec3(block.v0[0][lane], block.v0[1][lane], block.v0[2][lane]);
+		glm::vec3 normal(block.normal[0][lane], block.normal[1][lane], block.normal[2][lane]);
+		if (abs(glm::dot(d, normal)) <= radius)
+			lanes |= 1 << lane;
+	}
+	return lanes;
+#endif
+}
+
+static bool sphereLane(const LinearOctree::TriangleBlock& block, int lane, const glm::vec3& centre, float radius)
+{
+	float v0[3] = { block.v0[0][lane], block.v0[1][lane], block.v0[2][lane] };
+	float v1[3] = { block.v1[0][lane], block.v1[1][lane], block.v1[2][lane] };
+	float v2[3] = { block.v2[0][lane], block.v2[1][lane], block.v2[2][lane] };
+
+	return IntersectionTests::sphereTriangleIntersect(&centre.x, radius, v0, v1, v2);
+}
+
+// the nearest hit of the ray on the triangles of block closer than distance, returns its lane or -1 and lowers distance
+static int rayBlock(const LinearOctree::TriangleBlock& block, const glm::vec3& origin, const glm::vec3& direction, float& distance)
+{
+	const float epsilon = 0.000001f;		// the determinant limit of IntersectionTests::rayTriangleIntersect
+
+#ifdef USE_SSE
+	__m128 v0x = _mm_loadu_ps(block.v0[0]);
+	__m128 v0y = _mm_loadu_ps(block.v0[1]);
+	__m128 v0z = _mm_loadu_ps(block.v0[2]);
+	__m128 e1x = _mm_sub_ps(_mm_loadu_ps(block.v1[0]), v0x);
+	__m128 e1y = _mm_sub_ps(_mm_loadu_ps(block.v1[1]), v0y);
+	__m128 e1z = _mm_sub_ps(_mm_loadu_ps(block.v1[2]), v0z);
+	__m128 e2x = _mm_sub_ps(_mm_loadu_ps(block.v2[0]), v0x);
+	__m128 e2y = _mm_sub_ps(_mm_loadu_ps(block.v2[1]), v0y);
+	__m128 e2z = _mm_sub_ps(_mm_loadu_ps(block.v2[2]), v0z);
+	__m128 dx = _mm_set1_ps(direction.x);
+	__m128 dy = _mm_set1_ps(direction.y);
+	__m128 dz = _mm_set1_ps(direction.z);
+
+	// Moller-Trumbore on the four triangles
+	__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+	__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+	__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+	__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+	__m128 absolute = _mm_max_ps(det, _mm_sub_ps(_mm_setzero_ps(), det));
+	__m128 hit = _mm_and_ps(_mm_cmpge_ps(absolute, _mm_set1_ps(epsilon)), _mm_loadu_ps(block.laneMask));
+	if (_mm_movemask_ps(hit) == 0)
+		return -1;
+
+	__m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), det);
+	__m128 tx = _mm_sub_ps(_mm_set1_ps(origin.x), v0x);
+	__m128 ty = _mm_sub_ps(_mm_set1_ps(origin.y), v0y);
+	__m128 tz = _mm_sub_ps(_mm_set1_ps(origin.z), v0z);
+	__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inverse);
+
+	__m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+	__m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+	__m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+	__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+	__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)));
+	hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+	hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, _mm_set1_ps(distance))));
+
+	int lanes = _mm_movemask_ps(hit);
+	if (lanes == 0)
+		return -1;
+
+	float distances[4];
+	_mm_storeu_ps(distances, t);
+#else
+	int lanes = 0;
+	float distances[4];
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (!laneActive(block, lane))
+			continue;
+
+		float v0[3] = { block.v0[0][lane], block.v0[1][lane], block.v0[2][lane] };
+		float v1[3] = { block.v1[0][lane], block.v1[1][lane], block.v1[2][lane] };
+		float v2[3] = { block.v2[0][lane], block.v2[1][lane], block.v2[2][lane] };
+		float u, v;
+
+		if (IntersectionTests::rayTriangleIntersect(&origin.x, &direction.x, v0, v1, v2, distances[lane], u, v)
+			&& distances[lane] >= 0.0f && distances[lane] <= distance)
+			lanes |= 1 << lane;
+	}
+#endif
+
+	int nearest = -1;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (((lanes >> lane) & 1) && distances[lane] <= distance)
+		{
+			distance = distances[lane];
+			nearest = lane;
+		}
+	}
+	return nearest;
+}
+
+bool LinearOctree::pointCollision(const glm::vec3& point, float threshold) const
+{
+	if (blockCount == 0)
+		return false;
+
+	return SpatialOctree<ModelFaceSource, Node>::visitLeavesNear(nodeData, nodeCount, point, threshold, [&](int leaf)
+	{
+		const Node& node = nodeData[leaf];
+		for (int b = node.blockStart; b < node.blockStart + node.blockCount; b++)
+		{
+			if (pointBlock(blockData[b], point, threshold) != 0)
+				return true;
+		}
+		return false;
+	});
+}
+
+bool LinearOctree::sphereCollision(const glm::vec3& centre, float radius) const
+{
+	if (blockCount == 0)
+		return false;
+
+	return SpatialOctree<ModelFaceSource, Node>::visitLeavesNear(nodeData, nodeCount, centre, radius, [&](int leaf)
+	{
+		const Node& node = nodeData[leaf];
+		for (int b = node.blockStart; b < node.blockStart + node.blockCount; b++)
+		{
+			int lanes = planeBlock(blockData[b], centre, radius);
+			for (int lane = 0; lanes != 0; lane++, lanes >>= 1)
+			{
+				if ((lanes & 1) && sphereLane(blockData[b], lane, centre, radius))
+					return true;
+			}
+		}
+		return false;
+	});
+}
+
+void LinearOctree::sphereTriangles(const glm::vec3& centre, float radius, std::vector<int>& result) const
+{
+	if (blockCount == 0)
+		return;
+
+	int first = result.size();
+
+	SpatialOctree<ModelFaceSource, Node>::visitLeavesNear(nodeData, nodeCount, centre, radius, [&](int leaf)
+	{
+		const Node& node = nodeData[leaf];
+		for (int b = node.blockStart; b < node.blockStart + node.blockCount; b++)
+		{
+			int lanes = planeBlock(blockData[b], centre, radius);
+			for (int lane = 0; lanes != 0; lane++, lanes >>= 1)
+			{
+				if ((lanes & 1) && sphereLane(blockData[b], lane, centre, radius))
+					result.push_back(blockData[b].faces[lane]);
+			}
+		}
+		return false;
+	});
+
+	// a triangle crossing cells is in the leaf of each
+	std::sort(result.begin() + first, result.end());
+	result.erase(std::unique(result.begin() + first, result.end()), result.end());
+}
+
+int LinearOctree::rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const
+{
+	distance = maxDistance;
+	if (blockCount == 0)
+		return -1;
+
+	int nearest = -1;
+	SpatialOctree<ModelFaceSource, Node>::visitLeavesAlongRay(nodeData, nodeCount, origin, direction, distance, [&](int leaf, float& distance)
+	{
+		const Node& node = nodeData[leaf];
+		for (int b = node.blockStart; b < node.blockStart + node.blockCount; b++)
+		{
+			int lane = rayBlock(blockData[b], origin, direction, distance);
+			if (lane >= 0)
+				nearest = blockData[b].faces[lane];
+		}
+	});
+
+	return nearest;
+}
+
+void LinearOctree::processVerticesByLeaf(ThreeDModel* model) const
+{
+	for (int n = 0; n < nodeCount; n++)
+	{
+		const Node& node = nodeData[n];
+		if (node.childMask == 0 && getVertexCount(n) > 0)
+		{
+			model->calcVertNormals(const_cast<int*>(getVertices(n)), getVertexCount(n), const_cast<int*>(getPrimitives(n)), node.primitiveCount);
+		}
+	}
+}
+
+//---the baked file: a header, then each section at an offset from the start of the file that is a multiple of 16---
+
+static const char BAKE_MAGIC[4] = { 'F', 'F', 'O', 'T' };
+static const unsigned int BAKE_VERSION = 2;		// 1 had the vertex lists of the leaves
+
+enum
+{
+	SECTION_NODES,
+	SECTION_PRIMITIVES,
+	SECTION_BLOCKS,
+	SECTION_POSITIONS,		// three floats per vertex
+	SECTION_FACES,			// three vertex indices per face
+	SECTION_NORMALS,		// three floats per vertex
+	SECTION_COUNT
+};
+
+struct BakeHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int nodeSize, blockSize;	// a file written by a build with other layouts is not used
+	int depth;
+	unsigned int offset[SECTION_COUNT];
+	unsigned int count[SECTION_COUNT];		// elements of each section
+};
+
+static const unsigned int sectionElementSize[SECTION_COUNT] =
+{
+	sizeof(LinearOctree::Node), sizeof(int), sizeof(LinearOctree::TriangleBlock), 3 * sizeof(float), 3 * sizeof(unsigned int), 3 * sizeof(float)
+};
+
+// true when the ranges of every node are inside the sections and its children are below it, one level deeper, so the
+// traversals of a damaged file stay in the mapping and within their stacks
+static bool validNodes(const LinearOctree::Node* nodes, int nodeCount, int primitiveCount, int blockCount)
+{
+	for (int n = 0; n < nodeCount; n++)
+	{
+		const LinearOctree::Node& node = nodes[n];
+		if (node.primitiveStart < 0 || node.primitiveCount < 0 || node.primitiveStart + node.primitiveCount > primitiveCount
+			|| node.blockStart < 0 || node.blockCount < 0 || node.blockStart + node.blockCount > blockCount
+			|| node.level < 0 || node.level > LinearOctree::MAX_LEVELS || (n == 0 && node.level != 0))
+			return false;
+
+		if (node.childMask == 0)
+			continue;
+
+		int children = SpatialOctree<ModelFaceSource, LinearOctree::Node>::getChildCount(node);
+		if (node.childMask >= 256 || node.firstChild <= n || node.firstChild + children > nodeCount)
+			return false;
+
+		for (int c = 0; c < children; c++)
+		{
+			if (nodes[node.firstChild + c].level != node.level + 1)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static unsigned int alignSection(unsigned int offset)
+{
+	return (offset + 15) & ~15u;
+}
+
+bool LinearOctree::save(const char* path, const ThreeDModel& model) const
+{
+	if (nodeCount == 0 || model.theVerts == NULL || model.theFaces == NULL || model.theVertNormals == NULL)
+		return false;
+
+	BakeHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BAKE_MAGIC, 4);
+	header.version = BAKE_VERSION;
+	header.nodeSize = sizeof(Node);
+	header.blockSize = sizeof(TriangleBlock);
+	header.depth = depth;
+
+	header.count[SECTION_NODES] = nodeCount;
+	header.count[SECTION_PRIMITIVES] = nodeData[0].primitiveCount;
+	header.count[SECTION_BLOCKS] = blockCount;
+	header.count[SECTION_POSITIONS] = model.numberOfVertices;
+	header.count[SECTION_FACES] = model.numberOfTriangles;
+	header.count[SECTION_NORMALS] = model.numberOfVertices;
+
+	unsigned int offset = alignSection(sizeof(BakeHeader));
+	for (int section = 0; section < SECTION_COUNT; section++)
+	{
+		header.offset[section] = offset;
+		offset = alignSection(offset + header.count[section] * sectionElementSize[section]);
+	}
+
+	// the mesh as plain arrays, so the file does not depend on the layout of Vector3d and aFace
+	std::vector<float> positions(3 * model.numberOfVertices), normals(3 * model.numberOfVertices);
+	for (int v = 0; v < model.numberOfVertices; v++)
+	{
+		positions[3 * v] = model.theVerts[v].x;
+		positions[3 * v + 1] = model.theVerts[v].y;
+		positions[3 * v + 2] = model.theVerts[v].z;
+		normals[3 * v] = model.theVertNormals[v].x;
+		normals[3 * v + 1] = model.theVertNormals[v].y;
+		normals[3 * v + 2] = model.theVertNormals[v].z;
+	}
+
+	std::vector<unsigned int> faces(3 * model.numberOfTriangles);
+	for (int f = 0; f < model.numberOfTriangles; f++)
+	{
+		for (int k = 0; k < 3; k++)
+			faces[3 * f + k] = model.theFaces[f].thePoints[k];
+	}
+
+	const void* sections[SECTION_COUNT] =
+	{
+		nodeData, primitiveData, blockData,
+		positions.empty() ? NULL : &positions[0], faces.empty() ? NULL : &faces[0], normals.empty() ? NULL : &normals[0]
+	};
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+		return false;
+
+	out.write((const char*)&header, sizeof(header));
+
+	const char padding[16] = { 0 };
+	unsigned int written = sizeof(header);
+	for (int section = 0; section < SECTION_COUNT; section++)
+	{
+		out.write(padding, header.offset[section] - written);
+		out.write((const char*)sections[section], header.count[section] * sectionElementSize[section]);
+		written = header.offset[section] + header.count[section] * sectionElementSize[section];
+	}
+
+	return (bool)out;
+}
+
+bool LinearOctree::load(const char* path, const ThreeDModel& model)
+{
+	clear();
+
+	if (!file.open(path))
+		return false;
+
+	const char* data = file.getData();
+	size_t size = file.getSize();
+
+	BakeHeader header;
+	bool valid = size >= sizeof(header);
+	if (valid)
+	{
+		memcpy(&header, data, sizeof(header));
+		valid = memcmp(header.magic, BAKE_MAGIC, 4) == 0 && header.version == BAKE_VERSION && header.nodeSize == sizeof(Node)
+			&& header.blockSize == sizeof(TriangleBlock) && header.count[SECTION_NODES] > 0;
+	}
+
+	for (int section = 0; section < SECTION_COUNT && valid; section++)
+	{
+		valid = header.offset[section] % 16 == 0 && header.offset[section] <= size
+			&& header.count[section] <= (size - header.offset[section]) / sectionElementSize[section];
+	}
+
+	// the file is only used for the mesh it was written for
+	valid = valid && header.count[SECTION_POSITIONS] == model.numberOfVertices && header.count[SECTION_FACES] == model.numberOfTriangles
+		&& header.count[SECTION_NORMALS] == model.numberOfVertices && model.theVerts != NULL && model.theFaces != NULL;
+
+	const float* positions = valid ? (const float*)(data + header.offset[SECTION_POSITIONS]) : NULL;
+	const unsigned int* faces = valid ? (const unsigned int*)(data + header.offset[SECTION_FACES]) : NULL;
+
+	for (int v = 0; v < model.numberOfVertices && valid; v++)
+	{
+		valid = positions[3 * v] == model.theVerts[v].x && positions[3 * v + 1] == model.theVerts[v].y && positions[3 * v + 2] == model.theVerts[v].z;
+	}
+
+	for (int f = 0; f < model.numberOfTriangles && valid; f++)
+	{
+		valid = faces[3 * f] == model.theFaces[f].thePoints[0] && faces[3 * f + 1] == model.theFaces[f].thePoints[1]
+			&& faces[3 * f + 2] == model.theFaces[f].thePoints[2];
+	}
+
+	const Node* nodes = valid ? (const Node*)(data + header.offset[SECTION_NODES]) : NULL;
+	valid = valid && validNodes(nodes, header.count[SECTION_NODES], header.count[SECTION_PRIMITIVES], header.count[SECTION_BLOCKS]);
+
+	if (!valid)
+	{
+		clear();
+		return false;
+	}
+
+	nodeData = nodes;
+	nodeCount = header.count[SECTION_NODES];
+	depth = header.depth;
+	primitiveData = (const int*)(data + header.offset[SECTION_PRIMITIVES]);
+	blockData = (const TriangleBlock*)(data + header.offset[SECTION_BLOCKS]);
+	blockCount = header.count[SECTION_BLOCKS];
+
+	meshPositions = positions;
+	meshFaces = faces;
+	meshNormals = (const float*)(data + header.offset[SECTION_NORMALS]);
+
+	peakBuildMemory = 0;
+	boxes.assign(nodeCount, NULL);
+	return true;
+}
+
+bool LinearOctree::isLoaded() const
+{
+	return file.isOpen();
+}
+
+const float* LinearOctree::getMeshPositions() const
+{
+	return meshPositions;
+}
+
+const unsigned int* LinearOctree::getMeshFaces() const
+{
+	return meshFaces;
+}
+
+const float* LinearOctree::getMeshNormals() const
+{
+	return meshNormals;
+}
+
+void LinearOctree::drawBox(int node, Shader* myShader)
+{
+	if (boxes[node] == NULL)
+	{
+		const Node& n = nodeData[node];
+		boxes[node] = new Box();
+		boxes[node]->constructGeometry(myShader, n.min[0], n.min[1], n.min[2], n.max[0], n.max[1], n.max[2]);
+	}
+	else
+	{
+		boxes[node]->render();
+	}
+}
+
+void LinearOctree::drawAllBoxes(Shader* myShader)
+{
+	for (int n = 0; n < nodeCount; n++)
+		drawBox(n, myShader);
+}
+
+void LinearOctree::drawBoxesAtLeaves(Shader* myShader)
+{
+	for (int n = 0; n < nodeCount; n++)
+	{
+		if (isLeaf(n))
+			drawBox(n, myShader);
+	}
+}
@@ -0,0 +1,148 @@
+/*---The octree of a ThreeDModel, a SpatialOctree of its faces. The triangles of every leaf are also copied into blocks of
+four, one coordinate of the four per array, which the point, sphere and ray queries test four at a time after descending
+only into the cells the query reaches. The copy keeps the queries working after the model deletes its vertex and face data.
+On request the octree also lists the vertices of each leaf in a second arena in Morton order, classified in blocks whose
+sorted keys are merged in parallel, so the lists do not depend on the number of threads. With the uniform parameters the
+leaves hold the same triangles and vertices as the leaves of Octree. The octree can be saved with the mesh it indexes as
+one flat file, and a later run maps the file in place of the build, with the queries reading the nodes and blocks straight
+from the mapping.---*/
+
+#ifndef _LINEAR_OCTREE_H
+#define _LINEAR_OCTREE_H
+
+#include "SpatialOctree.h"
+#include "../Utilities/MappedFile.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class ThreeDModel;
+class Shader;
+class Box;
+struct ModelFaceSource;
+
+class LinearOctree
+{
+public:
+
+	static const int MAX_LEVELS = 10;
+
+	typedef OctreeBuildParameters BuildParameters;
+	typedef OctreeStatistics Statistics;
+
+	struct Node : public OctreeNode
+	{
+		int blockStart, blockCount;		// triangle blocks of a leaf
+	};
+
+	// four triangles of a leaf for the query kernels
+	struct TriangleBlock
+	{
+		float v0[3][4], v1[3][4], v2[3][4];		// [axis][lane]
+		float normal[3][4];			// unit normal
+		float dot00[4], dot01[4], dot11[4];		// dot products of the edges v2 - v0 and v1 - v0 for the barycentric test
+		float invDenom[4];
+		float laneMask[4];			// all bits set for a triangle, 0 for the padding of the last block and degenerate triangles
+		int faces[4];
+	};
+
+private:
+
+	SpatialOctree<ModelFaceSource, Node> tree;		// empty for a loaded octree
+	std::vector<TriangleBlock> blocks;
+
+	// the vertex arena, and the start and count of each node in it, empty unless buildVertexLists was called
+	std::vector<int> vertices;
+	std::vector<int> vertexRanges;
+	size_t peakBuildMemory;
+
+	MappedFile file;
+
+	// the arrays the queries read, in the members above for a built octree or in the mapped file for a loaded one
+	const Node* nodeData;
+	int nodeCount;
+	int depth;
+	const int* primitiveData;
+	const TriangleBlock* blockData;
+	int blockCount;
+
+	// the mesh in the file, NULL for a built octree
+	const float* meshPositions;
+	const unsigned int* meshFaces;
+	const float* meshNormals;
+
+	std::vector<Box*> boxes;		// drawn bounds, created on the first draw
+
+	void buildBlocks(ThreeDModel& model);
+	void clear();
+	void drawBox(int node, Shader* myShader);
+
+public:
+
+	LinearOctree();
+	~LinearOctree();
+
+	// octant i has x in bit 2, y in bit 1 and z in bit 0, the order of Octree's children
+	void build(ThreeDModel& model, const BuildParameters& parameters = BuildParameters());
+
+	// lists the vertices each leaf's cell holds, for comparing the leaves with Octree. Neither the build, the queries nor
+	// the vertex normals need them, so they are only made here and are not saved with the octree.
+	void buildVertexLists(ThreeDModel& model);
+
+	int getDepth() const;		// of the deepest leaf
+	int getNodeCount() const;
+	const Node& getNode(int node) const;
+	bool isLeaf(int node) const;
+
+	// the child of node in octant, or -1
+	int getChild(int node, int octant) const;
+
+	const int* getPrimitives(int node) const;
+	const int* getVertices(int node) const;		// NULL until buildVertexLists
+	int getVertexCount(int node) const;
+
+	// writes the octree and the mesh it indexes, the vertex positions, faces and vertex normals of model, to path as one
+	// file. Everything in it is an index or an offset from its start, so it can be used wherever it is mapped.
+	bool save(const char* path, const ThreeDModel& model) const;
+
+	// maps a file written by save in place of a build. False when there is none, or it was written for another mesh than
+	// the one of model, which is compared vertex by vertex and face by face.
+	bool load(const char* path, const ThreeDModel& model);
+
+	bool isLoaded() const;
+
+	// the mesh of a loaded octree, three floats per vertex position and normal and three vertex indices per face.
+	// NULL for a built octree.
+	const float* getMeshPositions() const;
+	const unsigned int* getMeshFaces() const;
+	const float* getMeshNormals() const;
+
+	// bytes held by the nodes, the arenas and the blocks, or the size of the loaded file, and the most held during the build
+	size_t getMemoryUsed() const;
+	size_t getPeakBuildMemory() const;
+
+	Statistics getStatistics() const;
+	void printStatistics() const;
+
+	// true when the point is closer than threshold to the plane of a triangle it projects into, the test of
+	// ThreeDModel::collisionBetweenPoint
+	bool pointCollision(const glm::vec3& point, float threshold) const;
+
+	// true when a triangle is closer than radius to centre
+	bool sphereCollision(const glm::vec3& centre, float radius) const;
+
+	// append the faces closer than radius to centre, each once
+	void sphereTriangles(const glm::vec3& centre, float radius, std::vector<int>& result) const;
+
+	// the face first hit by the ray from origin along the normalised direction within maxDistance, or -1
+	int rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+	// the vertex normals of each leaf from the triangles of the leaf, over the lists of buildVertexLists
+	void processVerticesByLeaf(ThreeDModel* model) const;
+
+	void drawAllBoxes(Shader* myShader);
+	void drawBoxesAtLeaves(Shader* myShader);
+};
+
+#endif
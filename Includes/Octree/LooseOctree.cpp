@@ -0,0 +1,465 @@
+#include "LooseOctree.h"
+
+#include <cfloat>
+#include <cmath>
+
+LooseOctree::LooseOctree(const glm::vec3& worldCentre, float halfSize, int maximumDepth)
+{
+	worldMin = worldCentre - glm::vec3(halfSize);
+	worldHalfSize = halfSize;
+	maxDepth = maximumDepth < MAX_LEVELS - 1 ? maximumDepth : MAX_LEVELS - 1;
+	objectCount = 0;
+	firstOverflow = -1;
+
+	for (int depth = 0; depth < MAX_LEVELS; depth++)
+		inverseCellSize[depth] = (float)(1 << depth) / (2.0f * worldHalfSize);
+
+	clear();
+}
+
+int LooseOctree::newNode(int parent, int depth, const glm::ivec3& cell)
+{
+	int node;
+	if (!freeNodes.empty())
+	{
+		node = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	else
+	{
+		node = nodes.size();
+		nodes.push_back(Node());
+	}
+
+	Node& n = nodes[node];
+	n.halfSize = worldHalfSize / (float)(1 << depth);
+	n.centre = worldMin + (glm::vec3(cell) * 2.0f + glm::vec3(1.0f)) * n.halfSize;
+	n.depth = depth;
+	n.cell = cell;
+	n.parent = parent;
+	n.firstObject = -1;
+	n.subtreeCount = 0;
+	for (int c = 0; c < 8; c++)
+		n.children[c] = -1;
+
+	return node;
+}
+
+void LooseOctree::freeNode(int node)
+{
+	int parent = nodes[node].parent;
+	if (parent >= 0)
+	{
+		for (int c = 0; c < 8; c++)
+		{
+			if (nodes[parent].children[c] == node)
+				nodes[parent].children[c] = -1;
+		}
+	}
+
+	freeNodes.push_back(node);
+}
+
+int LooseOctree::depthFor(float radius) const
+{
+	int depth = 0;
+	float halfSize = worldHalfSize;
+	while (depth < maxDepth && halfSize * 0.5f >= radius)
+	{
+		halfSize *= 0.5f;
+		depth++;
+	}
+
+	return depth;
+}
+
+glm::ivec3 LooseOctree::cellAt(const glm::vec3& centre, int depth) const
+{
+	glm::vec3 position = (centre - worldMin) * inverseCellSize[depth];
+	glm::ivec3 cell((int)floor(position.x), (int)floor(position.y), (int)floor(position.z));
+
+	return glm::clamp(cell, glm::ivec3(0), glm::ivec3((1 << depth) - 1));
+}
+
+bool LooseOctree::insideWorld(const glm::vec3& centre, float radius) const
+{
+	glm::vec3 position = centre - worldMin;
+	float edge = 2.0f * worldHalfSize;
+
+	return radius <= worldHalfSize && position.x >= 0.0f && position.y >= 0.0f && position.z >= 0.0f
+		&& position.x < edge && position.y < edge && position.z < edge;
+}
+
+void LooseOctree::link(int id, int depth, const glm::ivec3& cell)
+{
+	// down from the root, the child at each level is given by the next bit of the cell coordinates
+	int node = 0;
+	nodes[0].subtreeCount++;
+
+	for (int level = 1; level <= depth; level++)
+	{
+		int shift = depth - level;
+		glm::ivec3 childCell = glm::ivec3(cell.x >> shift, cell.y >> shift, cell.z >> shift);
+		int child = (childCell.x & 1) | ((childCell.y & 1) << 1) | ((childCell.z & 1) << 2);
+
+		if (nodes[node].children[child] < 0)
+		{
+			int created = newNode(node, level, childCell);
+			nodes[node].children[child] = created;
+		}
+
+		node = nodes[node].children[child];
+		nodes[node].subtreeCount++;
+	}
+
+	objectNode[id] = node;
+	objectDepth[id] = depth;
+	objectCell[id] = cell;
+	previousObject[id] = -1;
+	nextObject[id] = nodes[node].firstObject;
+	if (nodes[node].firstObject >= 0)
+		previousObject[nodes[node].firstObject] = id;
+	nodes[node].firstObject = id;
+}
+
+void LooseOctree::linkOverflow(int id)
+{
+	objectNode[id] = OVERFLOW_NODE;
+	objectDepth[id] = -1;
+	previousObject[id] = -1;
+	nextObject[id] = firstOverflow;
+	if (firstOverflow >= 0)
+		previousObject[firstOverflow] = id;
+	firstOverflow = id;
+}
+
+void LooseOctree::unlink(int id)
+{
+	int node = objectNode[id];
+
+	if (previousObject[id] >= 0)
+		nextObject[previousObject[id]] = nextObject[id];
+	else if (node == OVERFLOW_NODE)
+		firstOverflow = nextObject[id];
+	else
+		nodes[node].firstObject = nextObject[id];
+	if (nextObject[id] >= 0)
+		previousObject[nextObject[id]] = previousObject[id];
+
+	if (node == OVERFLOW_NODE)
+	{
+		objectNode[id] = -1;
+		return;
+	}
+
+	// up to the root, giving back the nodes left empty. The root always stays.
+	while (node >= 0)
+	{
+		int parent = nodes[node].parent;
+		nodes[node].subtreeCount--;
+
+		if (nodes[node].subtreeCount == 0 && node != 0)
+			freeNode(node);
+
+		node = parent;
+	}
+
+	objectNode[id] = -1;
+}
+
+int LooseOctree::insert(const glm::vec3& centre, float radius)
+{
+	int id;
+	if (!freeObjects.empty())
+	{
+		id = freeObjects.back();
+		freeObjects.pop_back();
+	}
+	else
+	{
+		id = centres.size();
+		centres.push_back(centre);
+		radii.push_back(radius);
+		objectNode.push_back(-1);
+		objectDepth.push_back(0);
+		objectCell.push_back(glm::ivec3(0));
+		nextObject.push_back(-1);
+		previousObject.push_back(-1);
+	}
+
+	centres[id] = centre;
+	radii[id] = radius;
+
+	int depth = depthFor(radius);
+	if (insideWorld(centre, radius))
+		link(id, depth, cellAt(centre, depth));
+	else
+		linkOverflow(id);
+
+	objectCount++;
+	return id;
+}
+
+bool LooseOctree::relocate(int id, int depth)
+{
+	if (!insideWorld(centres[id], radii[id]))
+	{
+		if (objectNode[id] == OVERFLOW_NODE)
+			return false;
+
+		unlink(id);
+		linkOverflow(id);
+		return true;
+	}
+
+	glm::ivec3 cell = cellAt(centres[id], depth);
+	if (objectNode[id] != OVERFLOW_NODE && depth == objectDepth[id] && cell == objectCell[id])
+		return false;
+
+	unlink(id);
+	link(id, depth, cell);
+	return true;
+}
+
+bool LooseOctree::move(int id, const glm::vec3& centre)
+{
+	centres[id] = centre;
+
+	// the depth of an object in the overflow list is not kept
+	return relocate(id, objectNode[id] == OVERFLOW_NODE ? depthFor(radii[id]) : objectDepth[id]);
+}
+
+bool LooseOctree::move(int id, const glm::vec3& centre, float radius)
+{
+	if (radius == radii[id])
+		return move(id, centre);
+
+	centres[id] = centre;
+	radii[id] = radius;
+
+	return relocate(id, depthFor(radius));
+}
+
+void LooseOctree::remove(int id)
+{
+	if (!contains(id))
+		return;
+
+	unlink(id);
+	freeObjects.push_back(id);
+	objectCount--;
+}
+
+void LooseOctree::clear()
+{
+	nodes.clear();
+	freeNodes.clear();
+	newNode(-1, 0, glm::ivec3(0));
+	firstOverflow = -1;
+
+	objectNode.assign(objectNode.size(), -1);
+	freeObjects.clear();
+	for (int id = objectNode.size() - 1; id >= 0; id--)
+		freeObjects.push_back(id);
+	objectCount = 0;
+}
+
+int LooseOctree::update(const std::vector<int>& ids, const std::vector<glm::vec3>& newCentres)
+{
+	int relocated = 0;
+
+	for (int i = 0; i < ids.size(); i++)
+	{
+		if (move(ids[i], newCentres[i]))
+			relocated++;
+	}
+
+	return relocated;
+}
+
+void LooseOctree::querySphere(const glm::vec3& centre, float radius, std::vector<int>& result) const
+{
+	// the objects outside the world cube have no node bounds to prune them by
+	for (int id = firstOverflow; id >= 0; id = nextObject[id])
+	{
+		glm::vec3 d = centres[id] - centre;
+		float reach = radius + radii[id];
+		if (glm::dot(d, d) <= reach * reach)
+			result.push_back(id);
+	}
+
+	int stack[8 * MAX_LEVELS + 1];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = nodes[stack[--top]];
+
+		// distance from the centre to the loose bounds of the node
+		glm::vec3 outside = glm::max(glm::abs(centre - node.centre) - glm::vec3(2.0f * node.halfSize), glm::vec3(0.0f));
+		if (glm::dot(outside, outside) > radius * radius)
+			continue;
+
+		for (int id = node.firstObject; id >= 0; id = nextObject[id])
+		{
+			glm::vec3 d = centres[id] - centre;
+			float reach = radius + radii[id];
+			if (glm::dot(d, d) <= reach * reach)
+				result.push_back(id);
+		}
+
+		for (int c = 0; c < 8; c++)
+		{
+			if (node.children[c] >= 0)
+				stack[top++] = node.children[c];
+		}
+	}
+}
+
+void LooseOctree::queryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<int>& result) const
+{
+	for (int id = firstOverflow; id >= 0; id = nextObject[id])
+	{
+		glm::vec3 outside = glm::max(glm::max(boxMin - centres[id], centres[id] - boxMax), glm::vec3(0.0f));
+		if (glm::dot(outside, outside) <= radii[id] * radii[id])
+			result.push_back(id);
+	}
+
+	int stack[8 * MAX_LEVELS + 1];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = nodes[stack[--top]];
+
+		glm::vec3 loose(2.0f * node.halfSize);
+		if (glm::any(glm::lessThan(node.centre + loose, boxMin)) || glm::any(glm::greaterThan(node.centre - loose, boxMax)))
+			continue;
+
+		for (int id = node.firstObject; id >= 0; id = nextObject[id])
+		{
+			glm::vec3 outside = glm::max(glm::max(boxMin - centres[id], centres[id] - boxMax), glm::vec3(0.0f));
+			if (glm::dot(outside, outside) <= radii[id] * radii[id])
+				result.push_back(id);
+		}
+
+		for (int c = 0; c < 8; c++)
+		{
+			if (node.children[c] >= 0)
+				stack[top++] = node.children[c];
+		}
+	}
+}
+
+// distance along the ray to where it enters the box, or a negative value when it misses it
+static float rayBoxEntry(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	glm::vec3 t0 = (boxMin - origin) * inverseDirection;
+	glm::vec3 t1 = (boxMax - origin) * inverseDirection;
+	glm::vec3 nearest = glm::min(t0, t1);
+	glm::vec3 farthest = glm::max(t0, t1);
+
+	float entry = glm::max(glm::max(nearest.x, nearest.y), glm::max(nearest.z, 0.0f));
+	float exit = glm::min(glm::min(farthest.x, farthest.y), farthest.z);
+
+	return entry <= exit ? entry : -1.0f;
+}
+
+// distance along the ray to where it enters the sphere, 0 when it starts inside it, or a negative value when it misses it
+static float raySphereEntry(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& centre, float radius)
+{
+	glm::vec3 m = origin - centre;
+	float b = glm::dot(m, direction);
+	float c = glm::dot(m, m) - radius * radius;
+	if (c > 0.0f && b > 0.0f)
+		return -1.0f;
+
+	float discriminant = b * b - c;
+	if (discriminant < 0.0f)
+		return -1.0f;
+
+	float root = sqrt(discriminant);
+	return glm::max(-b - root, 0.0f);
+}
+
+int LooseOctree::rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const
+{
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	int nearest = -1;
+	distance = maxDistance;
+
+	for (int id = firstOverflow; id >= 0; id = nextObject[id])
+	{
+		float t = raySphereEntry(origin, direction, centres[id], radii[id]);
+		if (t >= 0.0f && t <= distance)
+		{
+			distance = t;
+			nearest = id;
+		}
+	}
+
+	int stack[8 * MAX_LEVELS + 1];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = nodes[stack[--top]];
+
+		glm::vec3 loose(2.0f * node.halfSize);
+		float entry = rayBoxEntry(origin, inverseDirection, node.centre - loose, node.centre + loose);
+		if (entry < 0.0f || entry > distance)
+			continue;
+
+		for (int id = node.firstObject; id >= 0; id = nextObject[id])
+		{
+			float t = raySphereEntry(origin, direction, centres[id], radii[id]);
+			if (t >= 0.0f && t <= distance)
+			{
+				distance = t;
+				nearest = id;
+			}
+		}
+
+		for (int c = 0; c < 8; c++)
+		{
+			if (node.children[c] >= 0)
+				stack[top++] = node.children[c];
+		}
+	}
+
+	return nearest;
+}
+
+glm::vec3 LooseOctree::getCentre(int id) const
+{
+	return centres[id];
+}
+
+float LooseOctree::getRadius(int id) const
+{
+	return radii[id];
+}
+
+bool LooseOctree::contains(int id) const
+{
+	return id >= 0 && id < objectNode.size() && objectNode[id] != -1;
+}
+
+int LooseOctree::getObjectCount() const
+{
+	return objectCount;
+}
+
+int LooseOctree::getNodeCount() const
+{
+	return nodes.size() - freeNodes.size();
+}
+
+int LooseOctree::getPoolSize() const
+{
+	return nodes.size();
+}
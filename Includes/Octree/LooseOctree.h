@@ -0,0 +1,110 @@
+/*---A loose octree of moving spheres, for the projectiles, obstacles and the player. Every node holds the objects whose
+centre is in its cell and whose radius is at most its half size. The bounds of a node are twice its cell, so such an
+object never pokes out of them. An object's node only depends on its position and size, so it is found in at most
+maxDepth steps and moves without touching the others. An object that stays in its cell is not relocated at all. Nodes
+come from a pool and go back to it when their subtree is empty. An object that does not fit in the world cube, by its
+centre or its size, is kept in an overflow list that every query tests without pruning. The simulation does not use it,
+the obstacles stay where they are placed, so the missiles find them in the spatial hash of ObstacleCollider and the player
+in ObstacleIndex. It is built with its benchmark into the headless runner.---*/
+
+#ifndef _LOOSE_OCTREE_H
+#define _LOOSE_OCTREE_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class LooseOctree
+{
+public:
+
+	static const int MAX_LEVELS = 16;
+
+private:
+
+	struct Node
+	{
+		glm::vec3 centre;			// of the cell, the loose bounds are centre +- 2 halfSize
+		float halfSize;
+		int depth;
+		glm::ivec3 cell;			// coordinates of the cell among the cells of its depth
+		int parent;
+		int children[8];
+		int firstObject;			// objects of the node as a doubly linked list
+		int subtreeCount;			// objects in the node and below it, the node is freed when it reaches 0
+	};
+
+	glm::vec3 worldMin;
+	float worldHalfSize;
+	int maxDepth;
+	float inverseCellSize[MAX_LEVELS];		// 1 over the width of the cells of each depth
+
+	std::vector<Node> nodes;
+	std::vector<int> freeNodes;
+
+	// one entry per object id
+	std::vector<glm::vec3> centres;
+	std::vector<float> radii;
+	std::vector<int> objectNode;		// -1 for a free id, OVERFLOW_NODE outside the world cube
+	std::vector<int> objectDepth;		// depth and cell of the node, kept here so a move does not have to read the node
+	std::vector<glm::ivec3> objectCell;
+	std::vector<int> nextObject, previousObject;
+	std::vector<int> freeObjects;
+	int firstOverflow;				// objects outside the world cube, linked through nextObject like a node
+	int objectCount;
+
+	static const int OVERFLOW_NODE = -2;
+
+	int newNode(int parent, int depth, const glm::ivec3& cell);
+	void freeNode(int node);
+
+	// the deepest level whose half size still covers radius
+	int depthFor(float radius) const;
+
+	// the cell of depth holding centre
+	glm::ivec3 cellAt(const glm::vec3& centre, int depth) const;
+
+	// true when the sphere lies in the loose bounds of the cell it would be linked to
+	bool insideWorld(const glm::vec3& centre, float radius) const;
+
+	void link(int id, int depth, const glm::ivec3& cell);
+	void linkOverflow(int id);
+	void unlink(int id);
+
+	// links id to the node of depth its centre is in, or to the overflow list. Returns true when that changed.
+	bool relocate(int id, int depth);
+
+public:
+
+	// a cube of half size worldHalfSize round worldCentre. Objects outside it are kept in the overflow list.
+	LooseOctree(const glm::vec3& worldCentre, float worldHalfSize, int maximumDepth = 8);
+
+	// returns the id of the new object
+	int insert(const glm::vec3& centre, float radius);
+
+	// returns true when the object changed node
+	bool move(int id, const glm::vec3& centre);
+	bool move(int id, const glm::vec3& centre, float radius);
+
+	void remove(int id);
+	void clear();
+
+	// moves the objects ids to centres, returns how many changed node
+	int update(const std::vector<int>& ids, const std::vector<glm::vec3>& centres);
+
+	// append the objects whose sphere overlaps the query
+	void querySphere(const glm::vec3& centre, float radius, std::vector<int>& result) const;
+	void queryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<int>& result) const;
+
+	// nearest object whose sphere the ray from origin along the normalised direction enters within maxDistance, or -1
+	int rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+	glm::vec3 getCentre(int id) const;
+	float getRadius(int id) const;
+	bool contains(int id) const;
+	int getObjectCount() const;
+	int getNodeCount() const;		// nodes in use
+	int getPoolSize() const;		// nodes allocated, in use or free
+};
+
+#endif
@@ -7,8 +7,6 @@ using namespace std;
 #include "../3DStruct/threeDModel.h"
 #include <math.h>
 
-const int FACE_LIMIT = 1;
-
 Octree::Octree()
 {
 	minX = 0;
@@ -610,3 +608,12 @@ int Octree::getPrimitiveListSize()
 	return PrimitiveListSize;
 }
 
+int* Octree::getVertexList()
+{
+	return VertexList;
+}
+
+int Octree::getVertexListSize()
+{
+	return VertexListSize;
+}
@@ -33,6 +33,8 @@ public:
 	void getMaxValues(double* max);
 	int* getPrimitiveList();
 	int getPrimitiveListSize();
+	int* getVertexList();
+	int getVertexListSize();
 	void Delete();
 	void set(int L, float x, float y, float z, float X, float Y, float Z, int* PrimList, int PrimListSize, int* vertList, int VertListSize);
 	void start(int L, float x, float y, float z, float X, float Y, float Z, ThreeDModel* model);
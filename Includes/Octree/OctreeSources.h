@@ -0,0 +1,127 @@
+/*---Primitive sources for SpatialOctree. TubeTriangleSource hands it the triangles of a Tube and PointCloudSource a set of
+points, like the obstacle positions. The sources only hold a reference, so the geometry must outlive the build. The cells
+are tested with boxes a little larger than them, so a point on the border of two cells is in the leaves of both.---*/
+
+#ifndef _OCTREE_SOURCES_H
+#define _OCTREE_SOURCES_H
+
+#include "../tube.h"
+#include "../Utilities/IntersectionTests.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// the box round a list of points
+static inline void pointExtent(const std::vector<glm::vec3>& points, double minimum[3], double maximum[3])
+{
+	for (int a = 0; a < 3; a++)
+	{
+		minimum[a] = points.empty() ? 0.0 : points[0][a];
+		maximum[a] = minimum[a];
+	}
+
+	for (int i = 1; i < points.size(); i++)
+	{
+		for (int a = 0; a < 3; a++)
+		{
+			minimum[a] = points[i][a] < minimum[a] ? points[i][a] : minimum[a];
+			maximum[a] = points[i][a] > maximum[a] ? points[i][a] : maximum[a];
+		}
+	}
+}
+
+struct TubeTriangleSource
+{
+	const Tube& tube;
+
+	TubeTriangleSource(const Tube& tube) : tube(tube)
+	{
+	}
+
+	int getCount() const
+	{
+		return tube.triangles.size();
+	}
+
+	void getExtent(double minimum[3], double maximum[3]) const
+	{
+		pointExtent(tube.verts, minimum, maximum);
+	}
+
+	void getBounds(int i, float low[3], float high[3]) const
+	{
+		const glm::vec3& a = tube.verts[(int)tube.triangles[i].x];
+		const glm::vec3& b = tube.verts[(int)tube.triangles[i].y];
+		const glm::vec3& c = tube.verts[(int)tube.triangles[i].z];
+
+		for (int k = 0; k < 3; k++)
+		{
+			low[k] = glm::min(glm::min(a[k], b[k]), c[k]);
+			high[k] = glm::max(glm::max(a[k], b[k]), c[k]);
+		}
+	}
+
+	bool overlaps(int i, const double centre[3], const double halfSize[3]) const
+	{
+		double triangle[3][3];
+		for (int v = 0; v < 3; v++)
+		{
+			const glm::vec3& corner = tube.verts[(int)tube.triangles[i][v]];
+			for (int k = 0; k < 3; k++)
+				triangle[v][k] = corner[k];
+		}
+
+		return IntersectionTests::triBoxOverlap(const_cast<double*>(centre), const_cast<double*>(halfSize), triangle) != 0;
+	}
+};
+
+struct PointCloudSource
+{
+	const std::vector<glm::vec3>& points;
+
+	PointCloudSource(const std::vector<glm::vec3>& points) : points(points)
+	{
+	}
+
+	int getCount() const
+	{
+		return points.size();
+	}
+
+	// a cube round the points, so points in a plane, like the path of the flake, do not give cells of no thickness
+	void getExtent(double minimum[3], double maximum[3]) const
+	{
+		pointExtent(points, minimum, maximum);
+
+		double size = 0.0;
+		for (int a = 0; a < 3; a++)
+			size = maximum[a] - minimum[a] > size ? maximum[a] - minimum[a] : size;
+
+		for (int a = 0; a < 3; a++)
+		{
+			double centre = (minimum[a] + maximum[a]) / 2.0;
+			minimum[a] = centre - size / 2.0;
+			maximum[a] = centre + size / 2.0;
+		}
+	}
+
+	void getBounds(int i, float low[3], float high[3]) const
+	{
+		for (int k = 0; k < 3; k++)
+			low[k] = high[k] = points[i][k];
+	}
+
+	bool overlaps(int i, const double centre[3], const double halfSize[3]) const
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			if (points[i][k] < centre[k] - halfSize[k] || points[i][k] > centre[k] + halfSize[k])
+				return false;
+		}
+
+		return true;
+	}
+};
+
+#endif
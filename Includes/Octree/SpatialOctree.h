@@ -0,0 +1,690 @@
+/*---An octree over any set of primitives, given by a PrimitiveSource class with
+	int getCount() const;
+	void getExtent(double minimum[3], double maximum[3]) const;				the box round all of them
+	void getBounds(int i, float low[3], float high[3]) const;				the box round primitive i
+	bool overlaps(int i, const double centre[3], const double halfSize[3]) const;	primitive i against a cell
+The source is a template parameter, so the calls in the inner loops are resolved and inlined at compile time. The tree is
+built top down a level at a time. A node is split while it holds more primitives than the build parameters allow, it is
+above the deepest level, and the primitives a query would then test save enough on testing its own. Each level tests
+its primitives against the children of their node spread over the threads, and the lists are filled in order, so the
+tree does not depend on the number of threads. The cells are halved the way Octree halves them and tested with boxes
+1.001 times their size, so a model built with the uniform parameters gets the leaves of Octree. The nodes are emitted
+level by level into one array, with the children of a node next to each other, and the lists of the leaves live in one
+arena in Morton order, so the primitives below any node are one contiguous range. The node type can carry more than
+OctreeNode for an owner that adds its own lists, like LinearOctree.---*/
+
+#ifndef _SPATIAL_OCTREE_H
+#define _SPATIAL_OCTREE_H
+
+#include "../Utilities/ParallelFor.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+struct OctreeBuildParameters
+{
+	int maxDepth;				// levels below the root
+	int maxLeafPrimitives;		// a node with more primitives is split
+	bool costRule;				// split only when the estimated cost of a query drops
+	float traversalCost;		// cost of visiting the children of a node, in primitive tests
+	float minimumBenefit;		// fraction of the cost of a node its split has to save
+
+	OctreeBuildParameters()
+	{
+		maxDepth = 8;
+		maxLeafPrimitives = 32;
+		costRule = true;
+		traversalCost = 2.0f;
+		minimumBenefit = 0.1f;
+	}
+
+	// every node with a primitive split down to depth, the tree of Octree
+	static OctreeBuildParameters uniform(int depth)
+	{
+		OctreeBuildParameters parameters;
+		parameters.maxDepth = depth;
+		parameters.maxLeafPrimitives = 0;
+		parameters.costRule = false;
+		return parameters;
+	}
+};
+
+struct OctreeStatistics
+{
+	int nodeCount, leafCount, depth;
+	float averageLeafPrimitives;
+	int maxLeafPrimitives;
+	size_t memory;
+};
+
+struct OctreeNode
+{
+	float min[3], max[3];
+	int level;
+	int firstChild;				// index of the first child, the others follow in octant order
+	int childMask;				// bit i set when the child of octant i exists
+	int primitiveStart, primitiveCount;		// range of the primitive arena, for an inner node every entry of its leaves
+};
+
+// the cells of one axis at every level, split the way Octree splits them
+struct OctreeAxisCells
+{
+	std::vector<std::vector<float> > bounds;	// bounds[level][k] to bounds[level][k + 1] is cell k of level
+	std::vector<std::vector<double> > testCentre;		// box of each cell handed to the overlap test, per level
+	std::vector<std::vector<double> > testHalfSize;
+	std::vector<std::vector<double> > testLow, testHigh;	// the same box as a range, both ascending
+
+	void build(double minimum, double maximum, int depth)
+	{
+		bounds.resize(depth + 1);
+		bounds[0].resize(2);
+		bounds[0][0] = (float)minimum;
+		bounds[0][1] = (float)maximum;
+
+		for (int level = 0; level < depth; level++)
+		{
+			const std::vector<float>& parent = bounds[level];
+			std::vector<float>& child = bounds[level + 1];
+			int cells = parent.size() - 1;
+
+			child.resize(2 * cells + 1);
+			for (int k = 0; k < cells; k++)
+			{
+				child[2 * k] = parent[k];
+				child[2 * k + 1] = (float)(((double)parent[k] + (double)parent[k + 1]) / 2.0);
+			}
+			child[2 * cells] = parent[cells];
+		}
+
+		// Octree tests a box 1.001 times the size of the cell, from the unrounded middle of the parent
+		testCentre.resize(depth + 1);
+		testHalfSize.resize(depth + 1);
+		testLow.resize(depth + 1);
+		testHigh.resize(depth + 1);
+
+		for (int level = 0; level <= depth; level++)
+		{
+			int cells = bounds[level].size() - 1;
+			testCentre[level].resize(cells);
+			testHalfSize[level].resize(cells);
+			testLow[level].resize(cells);
+			testHigh[level].resize(cells);
+
+			for (int k = 0; k < cells; k++)
+			{
+				double low, high;
+				if (level == 0)
+				{
+					low = bounds[0][0];
+					high = bounds[0][1];
+				}
+				else
+				{
+					double parentLow = bounds[level - 1][k / 2];
+					double parentHigh = bounds[level - 1][k / 2 + 1];
+					double middle = (parentHigh + parentLow) / 2.0;
+					low = (k & 1) ? middle : parentLow;
+					high = (k & 1) ? parentHigh : middle;
+				}
+
+				testCentre[level][k] = (high + low) / 2.0;
+				testHalfSize[level][k] = (testCentre[level][k] - low) * 1.001;
+				testLow[level][k] = testCentre[level][k] - testHalfSize[level][k];
+				testHigh[level][k] = testCentre[level][k] + testHalfSize[level][k];
+			}
+		}
+	}
+};
+
+template <class PrimitiveSource, class Node = OctreeNode>
+class SpatialOctree
+{
+public:
+
+	static const int MAX_LEVELS = 10;
+
+private:
+
+	int depth;
+	std::vector<Node> nodes;
+	std::vector<int> primitives;
+	std::vector<int> leafOrder;		// the leaves in Morton order
+	size_t peakBuildMemory;
+
+	static int childCount(int childMask)
+	{
+		int count = 0;
+		for (int i = 0; i < 8; i++)
+			count += (childMask >> i) & 1;
+		return count;
+	}
+
+	static float surfaceArea(const Node& node)
+	{
+		float x = node.max[0] - node.min[0];
+		float y = node.max[1] - node.min[1];
+		float z = node.max[2] - node.min[2];
+		return x * y + y * z + z * x;
+	}
+
+	static float boxDistanceSquared(const Node& node, const glm::vec3& point)
+	{
+		float total = 0.0f;
+		for (int a = 0; a < 3; a++)
+		{
+			float outside = glm::max(glm::max(node.min[a] - point[a], point[a] - node.max[a]), 0.0f);
+			total += outside * outside;
+		}
+		return total;
+	}
+
+	// distance along the ray to where it enters the box of node, or a negative value when it misses it
+	static float rayBoxEntry(const Node& node, const glm::vec3& origin, const glm::vec3& inverseDirection)
+	{
+		glm::vec3 t0 = (glm::vec3(node.min[0], node.min[1], node.min[2]) - origin) * inverseDirection;
+		glm::vec3 t1 = (glm::vec3(node.max[0], node.max[1], node.max[2]) - origin) * inverseDirection;
+		glm::vec3 nearest = glm::min(t0, t1);
+		glm::vec3 farthest = glm::max(t0, t1);
+
+		float entry = glm::max(glm::max(nearest.x, nearest.y), glm::max(nearest.z, 0.0f));
+		float exit = glm::min(glm::min(farthest.x, farthest.y), farthest.z);
+
+		return entry <= exit ? entry : -1.0f;
+	}
+
+public:
+
+	SpatialOctree()
+	{
+		depth = 0;
+		peakBuildMemory = 0;
+	}
+
+	// gives back the memory of the tree
+	void clear()
+	{
+		std::vector<Node>().swap(nodes);
+		std::vector<int>().swap(primitives);
+		std::vector<int>().swap(leafOrder);
+		depth = 0;
+	}
+
+	void build(const PrimitiveSource& source, const OctreeBuildParameters& parameters = OctreeBuildParameters())
+	{
+		int maxDepth = parameters.maxDepth < MAX_LEVELS ? parameters.maxDepth : MAX_LEVELS;
+
+		double minimum[3], maximum[3];
+		source.getExtent(minimum, maximum);
+
+		OctreeAxisCells axes[3];
+		for (int a = 0; a < 3; a++)
+			axes[a].build(minimum[a], maximum[a], maxDepth);
+
+		int primitiveCount = source.getCount();
+
+		// every level tests the bounding boxes of the primitives against the children of their node
+		std::vector<float> primitiveBounds(6 * primitiveCount);
+		ParallelFor::run(0, primitiveCount, [&](int p)
+		{
+			source.getBounds(p, &primitiveBounds[6 * p], &primitiveBounds[6 * p + 3]);
+		}, 1024);
+
+		//---the nodes level by level from the root, a node split while it holds too many primitives and splitting pays---
+		nodes.clear();
+		std::vector<int> cells;							// cell coordinates of each node among the cells of its level
+		std::vector<std::vector<int> > levelPrimitives(1);	// the primitives of the nodes of each level, a range per node
+
+		Node root = Node();
+		for (int a = 0; a < 3; a++)
+		{
+			root.min[a] = axes[a].bounds[0][0];
+			root.max[a] = axes[a].bounds[0][1];
+			cells.push_back(0);
+		}
+		root.level = 0;
+		root.firstChild = -1;
+		root.childMask = 0;
+		root.primitiveStart = 0;
+		root.primitiveCount = primitiveCount;
+		nodes.push_back(root);
+
+		levelPrimitives[0].resize(primitiveCount);
+		for (int p = 0; p < primitiveCount; p++)
+			levelPrimitives[0][p] = p;
+
+		size_t buildMemory = primitiveBounds.capacity() * sizeof(float) + levelPrimitives[0].capacity() * sizeof(int);
+		peakBuildMemory = 0;
+		depth = 0;
+
+		int levelBegin = 0;
+		for (int level = 0; level < maxDepth && levelBegin < nodes.size(); level++)
+		{
+			int levelEnd = nodes.size();
+			levelPrimitives.push_back(std::vector<int>());
+			const std::vector<int>& entries = levelPrimitives[level];
+			std::vector<int>& next = levelPrimitives[level + 1];
+
+			// the children each primitive overlaps, a bit per octant, for the nodes holding too many to stay leaves
+			std::vector<unsigned char> entryOctants(entries.size(), 0);
+			std::vector<int> entryNode(entries.size(), -1);
+			for (int n = levelBegin; n < levelEnd; n++)
+			{
+				if (nodes[n].primitiveCount > parameters.maxLeafPrimitives)
+					std::fill(entryNode.begin() + nodes[n].primitiveStart, entryNode.begin() + nodes[n].primitiveStart + nodes[n].primitiveCount, n);
+			}
+
+			ParallelFor::run(0, entries.size(), [&](int e)
+			{
+				if (entryNode[e] < 0)
+					return;
+
+				const int* cell = &cells[3 * entryNode[e]];
+				int p = entries[e];
+				const float* lowBound = &primitiveBounds[6 * p];
+				const float* highBound = lowBound + 3;
+
+				// the children of the node on each axis whose test box the bounding box reaches
+				int first[3], last[3];
+				bool inside = true;
+				for (int a = 0; a < 3; a++)
+				{
+					const std::vector<double>& testLow = axes[a].testLow[level + 1];
+					const std::vector<double>& testHigh = axes[a].testHigh[level + 1];
+					int low = 2 * cell[a];
+
+					first[a] = lowBound[a] <= testHigh[low] && highBound[a] >= testLow[low] ? low : low + 1;
+					last[a] = lowBound[a] <= testHigh[low + 1] && highBound[a] >= testLow[low + 1] ? low + 1 : low;
+					if (first[a] > last[a])
+						return;
+
+					inside = inside && first[a] == last[a] && lowBound[a] >= testLow[first[a]] && highBound[a] <= testHigh[first[a]];
+				}
+
+				// a primitive whose bounding box is inside the test box of one child overlaps it without the full test, that
+				// is most primitives of a detailed mesh
+				if (inside)
+				{
+					entryOctants[e] = 1 << (((first[0] & 1) << 2) | ((first[1] & 1) << 1) | (first[2] & 1));
+					return;
+				}
+
+				for (int x = first[0]; x <= last[0]; x++)
+				{
+					for (int y = first[1]; y <= last[1]; y++)
+					{
+						for (int z = first[2]; z <= last[2]; z++)
+						{
+							double centre[3] = { axes[0].testCentre[level + 1][x], axes[1].testCentre[level + 1][y], axes[2].testCentre[level + 1][z] };
+							double halfSize[3] = { axes[0].testHalfSize[level + 1][x], axes[1].testHalfSize[level + 1][y], axes[2].testHalfSize[level + 1][z] };
+
+							if (source.overlaps(p, centre, halfSize))
+								entryOctants[e] |= 1 << (((x & 1) << 2) | ((y & 1) << 1) | (z & 1));
+						}
+					}
+				}
+			}, 1024);
+
+			// the children of each split node. A split is undone when the primitives a query would test, those of each child
+			// weighted by the chance a query reaching the node also reaches the child, don't save enough on the node's.
+			for (int n = levelBegin; n < levelEnd; n++)
+			{
+				if (nodes[n].primitiveCount <= parameters.maxLeafPrimitives)
+					continue;
+
+				int begin = nodes[n].primitiveStart;
+				int end = begin + nodes[n].primitiveCount;
+
+				int octantCount[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+				for (int e = begin; e < end; e++)
+				{
+					for (int octant = 0; octant < 8; octant++)
+						octantCount[octant] += (entryOctants[e] >> octant) & 1;
+				}
+
+				Node children[8];
+				int childCells[8][3];
+				for (int octant = 0; octant < 8; octant++)
+				{
+					children[octant] = Node();
+					childCells[octant][0] = 2 * cells[3 * n] + ((octant >> 2) & 1);
+					childCells[octant][1] = 2 * cells[3 * n + 1] + ((octant >> 1) & 1);
+					childCells[octant][2] = 2 * cells[3 * n + 2] + (octant & 1);
+					for (int a = 0; a < 3; a++)
+					{
+						children[octant].min[a] = axes[a].bounds[level + 1][childCells[octant][a]];
+						children[octant].max[a] = axes[a].bounds[level + 1][childCells[octant][a] + 1];
+					}
+				}
+
+				bool split = true;
+				if (parameters.costRule)
+				{
+					float parentArea = surfaceArea(nodes[n]);
+					float splitCost = parameters.traversalCost;
+					for (int octant = 0; octant < 8; octant++)
+					{
+						if (octantCount[octant] > 0 && parentArea > 0.0f)
+							splitCost += octantCount[octant] * surfaceArea(children[octant]) / parentArea;
+					}
+					split = splitCost < (1.0f - parameters.minimumBenefit) * nodes[n].primitiveCount;
+				}
+
+				if (!split)
+					continue;
+
+				// the lists of the children one after the other in octant order, each in the order of the node's list
+				int fill[8];
+				nodes[n].firstChild = nodes.size();
+				for (int octant = 0; octant < 8; octant++)
+				{
+					if (octantCount[octant] == 0)
+						continue;
+
+					Node& child = children[octant];
+					child.level = level + 1;
+					child.firstChild = -1;
+					child.childMask = 0;
+					child.primitiveStart = next.size();
+					child.primitiveCount = octantCount[octant];
+					fill[octant] = child.primitiveStart;
+
+					nodes[n].childMask |= 1 << octant;
+					nodes.push_back(child);
+					cells.insert(cells.end(), childCells[octant], childCells[octant] + 3);
+					next.resize(next.size() + octantCount[octant]);
+					depth = level + 1;
+				}
+
+				for (int e = begin; e < end; e++)
+				{
+					for (int octant = 0; octant < 8; octant++)
+					{
+						if ((entryOctants[e] >> octant) & 1)
+							next[fill[octant]++] = entries[e];
+					}
+				}
+			}
+
+			peakBuildMemory = std::max(peakBuildMemory, buildMemory + entryOctants.capacity() + entryNode.capacity() * sizeof(int)
+				+ next.capacity() * sizeof(int) + nodes.capacity() * sizeof(Node));
+
+			buildMemory += next.capacity() * sizeof(int);
+			levelBegin = levelEnd;
+		}
+
+		//---the leaves in Morton order, down the tree with the children in octant order---
+		leafOrder.clear();
+		std::vector<int> stack;
+		stack.push_back(0);
+		while (!stack.empty())
+		{
+			int n = stack.back();
+			stack.pop_back();
+
+			if (nodes[n].childMask == 0)
+			{
+				leafOrder.push_back(n);
+				continue;
+			}
+
+			for (int c = childCount(nodes[n].childMask) - 1; c >= 0; c--)
+				stack.push_back(nodes[n].firstChild + c);
+		}
+
+		// the lists of the leaves one after the other in that order
+		primitives.clear();
+		for (int l = 0; l < leafOrder.size(); l++)
+		{
+			Node& leaf = nodes[leafOrder[l]];
+			const std::vector<int>& list = levelPrimitives[leaf.level];
+			int start = primitives.size();
+			primitives.insert(primitives.end(), list.begin() + leaf.primitiveStart, list.begin() + leaf.primitiveStart + leaf.primitiveCount);
+			leaf.primitiveStart = start;
+		}
+
+		// an inner node's list is those of its leaves, and its children come after it in the array
+		for (int n = nodes.size() - 1; n >= 0; n--)
+		{
+			Node& node = nodes[n];
+			if (node.childMask == 0)
+				continue;
+
+			int last = node.firstChild + childCount(node.childMask) - 1;
+			node.primitiveStart = nodes[node.firstChild].primitiveStart;
+			node.primitiveCount = nodes[last].primitiveStart + nodes[last].primitiveCount - node.primitiveStart;
+		}
+	}
+
+	// calls visit(leaf) for every leaf closer than radius to centre, and stops when it returns true. Returns whether one did.
+	template <class Visit>
+	bool visitLeavesNear(const glm::vec3& centre, float radius, Visit visit) const
+	{
+		return visitLeavesNear(nodes.empty() ? NULL : &nodes[0], nodes.size(), centre, radius, visit);
+	}
+
+	// the same over a node array kept elsewhere, like a tree mapped from a file
+	template <class Visit>
+	static bool visitLeavesNear(const Node* nodes, int nodeCount, const glm::vec3& centre, float radius, Visit visit)
+	{
+		if (nodeCount == 0)
+			return false;
+
+		int stack[8 * MAX_LEVELS + 1];
+		int top = 0;
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			int n = stack[--top];
+			const Node& node = nodes[n];
+			if (boxDistanceSquared(node, centre) > radius * radius)
+				continue;
+
+			if (node.childMask == 0)
+			{
+				if (visit(n))
+					return true;
+				continue;
+			}
+
+			for (int c = childCount(node.childMask) - 1; c >= 0; c--)
+				stack[top++] = node.firstChild + c;
+		}
+
+		return false;
+	}
+
+	// calls visit(leaf, distance) for the leaves the ray from origin along direction enters before distance, nearest first.
+	// The visit lowers distance to the hits it finds, which cuts off the leaves behind them.
+	template <class Visit>
+	void visitLeavesAlongRay(const glm::vec3& origin, const glm::vec3& direction, float& distance, Visit visit) const
+	{
+		visitLeavesAlongRay(nodes.empty() ? NULL : &nodes[0], nodes.size(), origin, direction, distance, visit);
+	}
+
+	template <class Visit>
+	static void visitLeavesAlongRay(const Node* nodes, int nodeCount, const glm::vec3& origin, const glm::vec3& direction, float& distance, Visit visit)
+	{
+		if (nodeCount == 0)
+			return;
+
+		glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+		// nodes with the distance the ray enters them, the nearest child on top
+		int stack[8 * MAX_LEVELS + 1];
+		float entries[8 * MAX_LEVELS + 1];
+		int top = 0;
+
+		float rootEntry = rayBoxEntry(nodes[0], origin, inverseDirection);
+		if (rootEntry < 0.0f)
+			return;
+		stack[top] = 0;
+		entries[top++] = rootEntry;
+
+		while (top > 0)
+		{
+			top--;
+			if (entries[top] > distance)
+				continue;
+
+			const Node& node = nodes[stack[top]];
+			if (node.childMask == 0)
+			{
+				visit(stack[top], distance);
+				continue;
+			}
+
+			int children[8];
+			float childEntries[8];
+			int count = 0;
+			for (int c = 0; c < childCount(node.childMask); c++)
+			{
+				float entry = rayBoxEntry(nodes[node.firstChild + c], origin, inverseDirection);
+				if (entry < 0.0f || entry > distance)
+					continue;
+
+				// farthest first
+				int i = count++;
+				while (i > 0 && childEntries[i - 1] < entry)
+				{
+					children[i] = children[i - 1];
+					childEntries[i] = childEntries[i - 1];
+					i--;
+				}
+				children[i] = node.firstChild + c;
+				childEntries[i] = entry;
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				stack[top] = children[i];
+				entries[top++] = childEntries[i];
+			}
+		}
+	}
+
+	int getDepth() const		// of the deepest leaf
+	{
+		return depth;
+	}
+
+	int getNodeCount() const
+	{
+		return nodes.size();
+	}
+
+	const Node& getNode(int node) const
+	{
+		return nodes[node];
+	}
+
+	// for an owner filling in the fields it adds to the nodes
+	Node& getNode(int node)
+	{
+		return nodes[node];
+	}
+
+	bool isLeaf(int node) const
+	{
+		return nodes[node].childMask == 0;
+	}
+
+	// the child of node in octant, or -1
+	int getChild(int node, int octant) const
+	{
+		return getChild(nodes[node], octant);
+	}
+
+	static int getChild(const Node& node, int octant)
+	{
+		if ((node.childMask & (1 << octant)) == 0)
+			return -1;
+
+		// the children before it in octant order
+		return node.firstChild + childCount(node.childMask & ((1 << octant) - 1));
+	}
+
+	int getChildCount(int node) const
+	{
+		return childCount(nodes[node].childMask);
+	}
+
+	static int getChildCount(const Node& node)
+	{
+		return childCount(node.childMask);
+	}
+
+	const int* getPrimitives(int node) const
+	{
+		return primitives.empty() ? NULL : &primitives[nodes[node].primitiveStart];
+	}
+
+	// the node array and the primitive arena, for an owner that keeps pointers to them
+	const Node* getNodes() const
+	{
+		return nodes.empty() ? NULL : &nodes[0];
+	}
+
+	const int* getPrimitiveArena() const
+	{
+		return primitives.empty() ? NULL : &primitives[0];
+	}
+
+	int getPrimitiveArenaSize() const
+	{
+		return primitives.size();
+	}
+
+	const std::vector<int>& getLeafOrder() const
+	{
+		return leafOrder;
+	}
+
+	// bytes held by the nodes and the arena, and the most held during the build
+	size_t getMemoryUsed() const
+	{
+		return nodes.capacity() * sizeof(Node) + (primitives.capacity() + leafOrder.capacity()) * sizeof(int);
+	}
+
+	size_t getPeakBuildMemory() const
+	{
+		return peakBuildMemory;
+	}
+
+	OctreeStatistics getStatistics() const
+	{
+		OctreeStatistics statistics = getStatistics(nodes.empty() ? NULL : &nodes[0], nodes.size());
+		statistics.memory = getMemoryUsed();
+		return statistics;
+	}
+
+	// the statistics of a node array kept elsewhere, without its memory
+	static OctreeStatistics getStatistics(const Node* nodes, int nodeCount)
+	{
+		OctreeStatistics statistics;
+		statistics.nodeCount = nodeCount;
+		statistics.leafCount = 0;
+		statistics.depth = 0;
+		statistics.maxLeafPrimitives = 0;
+		statistics.memory = 0;
+
+		long long leafPrimitives = 0;
+		for (int n = 0; n < nodeCount; n++)
+		{
+			if (nodes[n].childMask != 0)
+				continue;
+
+			statistics.leafCount++;
+			statistics.depth = std::max(statistics.depth, nodes[n].level);
+			leafPrimitives += nodes[n].primitiveCount;
+			statistics.maxLeafPrimitives = std::max(statistics.maxLeafPrimitives, nodes[n].primitiveCount);
+		}
+		statistics.averageLeafPrimitives = statistics.leafCount > 0 ? (float)leafPrimitives / statistics.leafCount : 0.0f;
+
+		return statistics;
+	}
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*---Closed polyline parameterised by the distance travelled along it. A prefix sum of the segment lengths maps a distance
+to its segment with a binary search, or in constant time when the caller keeps the segment of its last lookup as a hint and
+moves forward, so an entity can move any distance in one step. The orientation of every segment is kept with it for the player.---*/
+
+#ifndef _ARC_LENGTH_PATH_H
+#define _ARC_LENGTH_PATH_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+class ArcLengthPath
+{
+private:
+
+	std::vector<glm::vec3> points;
+	std::vector<glm::vec3> directions;	// unit direction of every segment
+	std::vector<float> lengths;		// length of every segment, the difference of two prefix sums rounds far along the loop
+	std::vector<glm::quat> orientations;	// turns -z onto the direction of every segment
+	std::vector<float> cumulative;		// distance from points[0] to points[i], the last entry is the length of the loop
+
+	static const int HINT_STEPS = 4;	// segments walked forward from a hint before falling back to the binary search
+
+public:
+
+	ArcLengthPath();
+
+	// the path runs through the points and back to the first one
+	void build(const std::vector<glm::vec3>& pathPoints);
+
+	float getLength() const;
+	int getSegmentCount() const;
+
+	// distance of the start of the segment from the start of the path
+	float segmentStart(int segment) const;
+	float segmentLength(int segment) const;
+	const glm::quat& segmentOrientation(int segment) const;
+
+	// brings a distance into [0, length), going round the loop in either direction
+	float wrap(float s) const;
+
+	// segment holding the distance s, with a binary search
+	int segmentAt(float s) const;
+	// same as segmentAt, but starts looking at the hint, usually the segment of the previous lookup
+	int segmentAt(float s, int hint) const;
+
+	glm::vec3 position(float s) const;
+	glm::vec3 tangent(float s) const;
+
+	// position and tangent at s, hint is updated to the segment of s
+	void evaluate(float s, int& hint, glm::vec3& position, glm::vec3& tangent) const;
+
+	// evaluates many distances at once. Ascending distances are found by walking forward, others by the binary search.
+	void evaluate(const std::vector<float>& s, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& tangents) const;
+};
+
+#endif
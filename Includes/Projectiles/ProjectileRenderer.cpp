@@ -0,0 +1,40 @@
+#include "../gl/glew.h"
+#include "ProjectileRenderer.h"
+#include "ProjectileSystem.h"
+#include "../3dStruct/threeDModel.h"
+
+ProjectileRenderer::ProjectileRenderer()
+{
+	offsetBuffer = 0;
+	capacity = 0;
+}
+
+void ProjectileRenderer::createBuffers(ThreeDModel& model, Shader* myShader, int maxProjectiles)
+{
+	capacity = maxProjectiles;
+	positions.reserve(capacity);
+
+	glGenBuffers(1, &offsetBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, offsetBuffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	model.addInstanceAttribute(myShader, "in_Offset", offsetBuffer, 3);
+}
+
+void ProjectileRenderer::render(const ProjectileSystem& system, ThreeDModel& model, Shader* myShader, float offsetTime)
+{
+	system.gatherPositions(positions, offsetTime);
+
+	int count = positions.size() < capacity ? positions.size() : capacity;
+	if (count == 0)
+		return;
+
+	// orphan the buffer so the driver does not wait for the draw of the last frame
+	glBindBuffer(GL_ARRAY_BUFFER, offsetBuffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::vec3), &positions[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	model.drawElementsInstancedUsingVBO(myShader, count);
+}
@@ -0,0 +1,34 @@
+/*---Draws every live projectile of a ProjectileSystem with one instanced draw of a model. The positions are copied into
+an instance buffer each frame, moved back along the velocity so they are drawn between the last two ticks.---*/
+
+#ifndef _PROJECTILE_RENDERER_H
+#define _PROJECTILE_RENDERER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class ProjectileSystem;
+class ThreeDModel;
+class Shader;
+
+class ProjectileRenderer
+{
+private:
+
+	unsigned int offsetBuffer;			// one world position per instance
+	int capacity;
+	std::vector<glm::vec3> positions;
+
+public:
+
+	ProjectileRenderer();
+
+	// the model has to be loaded with the shader, whose in_Offset attribute reads the instance buffer
+	void createBuffers(ThreeDModel& model, Shader* myShader, int maxProjectiles);
+
+	// offsetTime is in the time units of the system, -(1 - alpha) * time step draws the projectiles between ticks
+	void render(const ProjectileSystem& system, ThreeDModel& model, Shader* myShader, float offsetTime);
+};
+
+#endif
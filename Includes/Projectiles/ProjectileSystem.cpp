@@ -0,0 +1,244 @@
+#include "ProjectileSystem.h"
+#include "../tube.h"
+#include "../Utilities/ParallelFor.h"
+#include "../Utilities/Simd.h"
+
+#include <cfloat>
+
+ProjectileSystem::ProjectileSystem(int poolCapacity)
+{
+	tube = NULL;
+	now = 0.0f;
+	capacity = poolCapacity;
+	slotCount = 0;
+	activeCount = 0;
+
+	int padded = (capacity + 3) & ~3;
+
+	positionX.assign(padded, 0.0f);
+	positionY.assign(padded, 0.0f);
+	positionZ.assign(padded, 0.0f);
+	velocityX.assign(padded, 0.0f);
+	velocityY.assign(padded, 0.0f);
+	velocityZ.assign(padded, 0.0f);
+	age.assign(padded, 0.0f);
+	lifetime.assign(padded, FLT_MAX);
+	state.assign(padded, DEAD);
+
+	// the lowest slots are taken first while the pool fills, so the live projectiles start packed at the start of the
+	// arrays. Later the slots come back in the order the projectiles die, and slotCount only drops when the highest dies.
+	freeSlots.reserve(capacity);
+	for (int i = capacity - 1; i >= 0; i--)
+	{
+		freeSlots.push_back(i);
+	}
+
+	fired.reserve(capacity);
+	impacted.reserve(capacity);
+}
+
+void ProjectileSystem::setTube(const Tube* tubeToHit)
+{
+	tube = tubeToHit;
+}
+
+int ProjectileSystem::fire(const glm::vec3& origin, const glm::vec3& direction, float speed)
+{
+	if (freeSlots.empty())
+		return -1;
+
+	int id = freeSlots.back();
+	freeSlots.pop_back();
+
+	positionX[id] = origin.x;
+	positionY[id] = origin.y;
+	positionZ[id] = origin.z;
+	velocityX[id] = direction.x * speed;
+	velocityY[id] = direction.y * speed;
+	velocityZ[id] = direction.z * speed;
+	age[id] = 0.0f;
+	lifetime[id] = FLT_MAX;
+	state[id] = FIRED;
+
+	fired.push_back(id);
+
+	if (id >= slotCount)
+		slotCount = id + 1;
+	activeCount++;
+
+	return id;
+}
+
+void ProjectileSystem::remove(int id)
+{
+	if (isAlive(id))
+	{
+		// a dead slot does not move and never reaches its lifetime, so the integration can run over it unchecked
+		state[id] = DEAD;
+		velocityX[id] = 0.0f;
+		velocityY[id] = 0.0f;
+		velocityZ[id] = 0.0f;
+		lifetime[id] = FLT_MAX;
+		freeSlots.push_back(id);
+		activeCount--;
+	}
+}
+
+void ProjectileSystem::clear()
+{
+	for (int i = 0; i < slotCount; i++)
+	{
+		remove(i);
+	}
+
+	fired.clear();
+}
+
+void ProjectileSystem::retire(int id)
+{
+	// step back to the impact point, the projectile flew past it during the tick
+	float overshoot = age[id] - lifetime[id];
+	positionX[id] -= velocityX[id] * overshoot;
+	positionY[id] -= velocityY[id] * overshoot;
+	positionZ[id] -= velocityZ[id] * overshoot;
+
+	remove(id);
+	impacted.push_back(id);
+}
+
+void ProjectileSystem::castFired()
+{
+	// a slot can be in the list twice when it was removed and fired again, it is only cast once
+	int count = 0;
+	for (int i = 0; i < fired.size(); i++)
+	{
+		int id = fired[i];
+		if (state[id] == FIRED)
+		{
+			state[id] = FLYING;
+			fired[count++] = id;
+		}
+	}
+	fired.resize(count);
+
+	// the tube is static and the flights are straight lines, so the impacts are known before the projectiles move
+	ParallelFor::run(0, count, [&](int i)
+	{
+		int id = fired[i];
+
+		glm::vec3 origin(positionX[id], positionY[id], positionZ[id]);
+		glm::vec3 velocity(velocityX[id], velocityY[id], velocityZ[id]);
+		float speed = glm::length(velocity);
+
+		float distance = 0.0f;
+		if (tube != NULL && speed > 0.0f)
+		{
+			tube->rayCast(origin, velocity / speed, distance);
+		}
+
+		lifetime[id] = speed > 0.0f ? distance / speed : 0.0f;
+	}, 256);
+
+	fired.clear();
+}
+
+void ProjectileSystem::integrate(float deltaTime)
+{
+	int end = (slotCount + 3) & ~3;
+
+#ifdef USE_SSE
+	__m128 dt = _mm_set1_ps(deltaTime);
+
+	for (int i = 0; i < end; i += 4)
+	{
+		_mm_storeu_ps(&positionX[i], _mm_add_ps(_mm_loadu_ps(&positionX[i]), _mm_mul_ps(_mm_loadu_ps(&velocityX[i]), dt)));
+		_mm_storeu_ps(&positionY[i], _mm_add_ps(_mm_loadu_ps(&positionY[i]), _mm_mul_ps(_mm_loadu_ps(&velocityY[i]), dt)));
+		_mm_storeu_ps(&positionZ[i], _mm_add_ps(_mm_loadu_ps(&positionZ[i]), _mm_mul_ps(_mm_loadu_ps(&velocityZ[i]), dt)));
+
+		__m128 newAge = _mm_add_ps(_mm_loadu_ps(&age[i]), dt);
+		_mm_storeu_ps(&age[i], newAge);
+
+		int hits = _mm_movemask_ps(_mm_cmpge_ps(newAge, _mm_loadu_ps(&lifetime[i])));
+		for (int lane = 0; hits != 0; lane++, hits >>= 1)
+		{
+			if (hits & 1)
+				retire(i + lane);
+		}
+	}
+#else
+	for (int i = 0; i < end; i++)
+	{
+		positionX[i] += velocityX[i] * deltaTime;
+		positionY[i] += velocityY[i] * deltaTime;
+		positionZ[i] += velocityZ[i] * deltaTime;
+		age[i] += deltaTime;
+
+		if (age[i] >= lifetime[i])
+			retire(i);
+	}
+#endif
+}
+
+void ProjectileSystem::update(float deltaTime)
+{
+	now += deltaTime;
+	impacted.clear();
+
+	castFired();
+	integrate(deltaTime);
+
+	while (slotCount > 0 && state[slotCount - 1] == DEAD)
+	{
+		slotCount--;
+	}
+}
+
+glm::vec3 ProjectileSystem::position(int id) const
+{
+	return glm::vec3(positionX[id], positionY[id], positionZ[id]);
+}
+
+bool ProjectileSystem::isAlive(int id) const
+{
+	return id >= 0 && id < capacity && state[id] != DEAD;
+}
+
+int ProjectileSystem::getActiveCount() const
+{
+	return activeCount;
+}
+
+int ProjectileSystem::getCapacity() const
+{
+	return capacity;
+}
+
+int ProjectileSystem::getSlotCount() const
+{
+	return slotCount;
+}
+
+float ProjectileSystem::getTime() const
+{
+	return now;
+}
+
+void ProjectileSystem::gatherPositions(std::vector<glm::vec3>& positions, float offsetTime) const
+{
+	positions.clear();
+
+	for (int i = 0; i < slotCount; i++)
+	{
+		if (state[i] != DEAD)
+		{
+			positions.push_back(glm::vec3(positionX[i] + velocityX[i] * offsetTime,
+				positionY[i] + velocityY[i] * offsetTime,
+				positionZ[i] + velocityZ[i] * offsetTime));
+		}
+	}
+}
+
+const std::vector<unsigned int>& ProjectileSystem::getImpacted() const
+{
+	return impacted;
+}
@@ -0,0 +1,80 @@
+/*---A fixed size pool of projectiles flying in straight lines inside the tube. The projectiles are stored as a structure
+of arrays, so the integration of a tick is one SSE loop over positions, velocities and ages. Slots are taken from and
+returned to a free list. The impact with the static tube is found by one ray cast per projectile, done for all projectiles
+fired since the last update in one batch, and a projectile dies when its age reaches the flight time to the impact.---*/
+
+#ifndef _PROJECTILE_SYSTEM_H
+#define _PROJECTILE_SYSTEM_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class Tube;
+
+class ProjectileSystem
+{
+private:
+
+	enum State
+	{
+		DEAD,
+		FIRED,			// waiting for the ray cast of the next update
+		FLYING
+	};
+
+	const Tube* tube;
+	float now;							// current time of the system
+	int capacity;
+	int slotCount;						// one past the highest slot in use, the integration stops there
+	int activeCount;
+
+	// one entry per slot, padded to a multiple of 4 for the SSE loop
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> velocityX, velocityY, velocityZ;
+	std::vector<float> age;
+	std::vector<float> lifetime;		// age at which the projectile reaches the tube
+	std::vector<unsigned char> state;
+
+	std::vector<int> freeSlots;			// stack of dead slots, the last one freed on top
+	std::vector<int> fired;				// slots fired since the last update
+	std::vector<unsigned int> impacted;	// projectiles that hit the tube during the last update
+
+	void castFired();
+	void integrate(float deltaTime);
+	void retire(int id);
+
+public:
+
+	ProjectileSystem(int poolCapacity = 16384);
+
+	void setTube(const Tube* tubeToHit);
+
+	// takes a slot from the pool and returns its id, or -1 when the pool is full. The ray against the tube is cast in the
+	// next update.
+	int fire(const glm::vec3& origin, const glm::vec3& direction, float speed);
+
+	// removes a projectile before it hits the tube
+	void remove(int id);
+
+	// removes every projectile
+	void clear();
+
+	// casts the rays of the fired projectiles, moves every projectile and removes those that reached the tube
+	void update(float deltaTime);
+
+	glm::vec3 position(int id) const;
+	bool isAlive(int id) const;
+	int getActiveCount() const;
+	int getCapacity() const;
+	int getSlotCount() const;
+	float getTime() const;
+
+	// positions of the live projectiles moved by their velocity times offsetTime, negative to draw them between ticks
+	void gatherPositions(std::vector<glm::vec3>& positions, float offsetTime) const;
+
+	// projectiles that hit the tube during the last update
+	const std::vector<unsigned int>& getImpacted() const;
+};
+
+#endif
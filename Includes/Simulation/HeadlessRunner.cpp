@@ -0,0 +1,268 @@
+/*---Runs the simulation without a window and prints how long each part of a tick took. The input is read from a script
+where every line is a tick and the keys held from that tick on, for example "120 WA". F fires on its tick only. Without a
+script the player flies forward, fires every two seconds and turns left and right for three seconds each. A recording from
+the game or from -record is replayed with -replay, which takes the settings, the seed and the ticks from the file.
+-missiles N keeps N missiles flying to time the projectile pool, they are fired outside the recorded input. -transforms 1
+also culls the obstacles and builds their model matrices every tick, as the game does before drawing them. -bench 1 runs
+the benchmarks that do not need the models on the tube of the settings instead of the ticks.
+
+usage: headless [-ticks N] [-dimension D] [-seed S] [-script file] [-record file] [-replay file] [-trace file]
+	[-missiles N] [-transforms 1] [-bench 1]---*/
+
+#include "Simulation.h"
+#include "InputRecording.h"
+#include "../Obstacles/ObstacleTransforms.h"
+#include "../Time/Stopwatch.h"
+#include "../Benchmarks/Benchmarks.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+
+using namespace std;
+
+static SimulationInput inputFromKeys(const string& keys)
+{
+	SimulationInput input;
+
+	input.forward = keys.find_first_of("WS") != string::npos;
+	input.turnLeft = keys.find('A') != string::npos;
+	input.turnRight = keys.find('D') != string::npos;
+	input.fire = keys.find('F') != string::npos;
+	input.stopFire = keys.find('R') != string::npos;
+
+	return input;
+}
+
+static SimulationInput defaultInput(int tick, double tickSeconds)
+{
+	int ticksPerSecond = (int)(1.0 / tickSeconds + 0.5);
+
+	SimulationInput input;
+	input.forward = true;
+	input.fire = tick % (2 * ticksPerSecond) == 0;
+	input.turnLeft = (tick / (3 * ticksPerSecond)) % 2 == 0;
+	input.turnRight = !input.turnLeft;
+
+	return input;
+}
+
+static bool loadScript(const char* path, map<int, string>& script)
+{
+	ifstream file(path);
+	if (!file)
+		return false;
+
+	string line;
+	while (getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		int tick = atoi(line.c_str());
+		size_t space = line.find(' ');
+		script[tick] = space == string::npos ? "" : line.substr(space + 1);
+	}
+
+	return true;
+}
+
+// fires missiles from the nose of the player in a cone round its direction until count are flying, returns how many
+// were fired
+static int keepMissilesFlying(Simulation& game, int count, std::mt19937& rng)
+{
+	int fired = 0;
+	std::uniform_real_distribution<float> spread(-0.05f, 0.05f);
+	glm::vec3 direction = game.getFireDirection();
+
+	while (game.projectiles.getActiveCount() < count)
+	{
+		glm::vec3 jitter(spread(rng), spread(rng), spread(rng));
+		if (game.projectiles.fire(game.nosePosition, glm::normalize(direction + jitter), Simulation::MISSILE_SPEED) < 0)
+			break;
+		fired++;
+	}
+
+	return fired;
+}
+
+// the view and projection of the camera behind the player, as display() sets them up
+static glm::mat4 chaseCamera(const Simulation& game)
+{
+	glm::vec4 offset = game.playerDirectionMat * glm::vec4(0.0f, 0.0f, game.settings.radiusOfSegment * 1.5f, 1.0f);
+	glm::vec3 eye = game.cameraTarget + glm::vec3(offset.x, offset.y, offset.z);
+	glm::vec3 up(game.playerDirectionMat[1][0], game.playerDirectionMat[1][1], game.playerDirectionMat[1][2]);
+
+	return glm::perspective(60.0f, 1.0f, 1.0f, game.settings.edgeLength / 10.0f) * glm::lookAt(eye, game.cameraTarget, up);
+}
+
+static void printPhase(const char* name, double milliseconds, int ticks)
+{
+	cout << "  " << name << " : " << milliseconds << " ms, " << milliseconds * 1000.0 / ticks << " us per tick" << endl;
+}
+
+int main(int argc, char** argv)
+{
+	int ticks = 12000;
+	SimulationSettings settings;
+	const char* scriptPath = NULL;
+	const char* recordPath = NULL;
+	const char* replayPath = NULL;
+	const char* tracePath = NULL;
+	int missiles = 0;
+	bool transforms = false;
+	bool bench = false;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "-ticks") == 0)
+			ticks = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-dimension") == 0)
+			settings.dimension = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-seed") == 0)
+			settings.seed = strtoul(argv[i + 1], NULL, 10);
+		else if (strcmp(argv[i], "-script") == 0)
+			scriptPath = argv[i + 1];
+		else if (strcmp(argv[i], "-record") == 0)
+			recordPath = argv[i + 1];
+		else if (strcmp(argv[i], "-replay") == 0)
+			replayPath = argv[i + 1];
+		else if (strcmp(argv[i], "-trace") == 0)
+			tracePath = argv[i + 1];
+		else if (strcmp(argv[i], "-missiles") == 0)
+			missiles = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-transforms") == 0)
+			transforms = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "-bench") == 0)
+			bench = atoi(argv[i + 1]) != 0;
+	}
+
+	InputRecording recording;
+
+	if (replayPath != NULL)
+	{
+		if (!recording.load(replayPath))
+		{
+			cout << "failed to load recording " << replayPath << endl;
+			return 1;
+		}
+
+		settings = recording.settings;
+		ticks = recording.getTickCount();
+	}
+
+	recording.settings = settings;
+
+	map<int, string> script;
+	if (scriptPath != NULL && !loadScript(scriptPath, script))
+	{
+		cout << "failed to load script " << scriptPath << endl;
+		return 1;
+	}
+
+	cout << " Headless run : " << ticks << " ticks of " << settings.tickSeconds * 1000.0 << " ms, dimension " << settings.dimension << ", seed " << settings.seed << endl;
+
+	Simulation game;
+	game.timings.keepTrace = tracePath != NULL;
+	game.init(settings);
+
+	if (bench)
+	{
+		Benchmarks::runHeadless(game.tube);
+		return 0;
+	}
+
+	cout << "  tube : " << game.tube.verts.size() << " verts, " << game.tube.norms.size() << " triangles, " << game.obstacles.getCount() << " obstacles" << endl;
+
+	string held;
+	std::mt19937 missileRng(settings.seed);
+	int peakMissiles = 0;
+	int missilesFired = 0;
+
+	// the model of the obstacles is not loaded here, its largest extent is twice the half width the game took from it
+	ObstacleTransforms obstacleTransforms;
+	std::vector<glm::vec3> obstaclePoints, obstacleDirections;
+	std::vector<float> obstacleSpeeds;
+	game.obstacles.copyTo(obstaclePoints, obstacleDirections, obstacleSpeeds);
+	obstacleTransforms.setObstacles(obstaclePoints, obstacleDirections, obstacleSpeeds, settings.radiusOfSegment * 0.7f, 2.0f * settings.obstacleHalfWidth);
+	double transformTime = 0.0;
+	long visibleObstacles = 0;
+
+	Stopwatch runTimer;
+
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		SimulationInput input;
+
+		if (replayPath != NULL)
+		{
+			input = recording.getInput(tick);
+		}
+		else if (scriptPath == NULL)
+		{
+			input = defaultInput(tick, settings.tickSeconds);
+		}
+		else
+		{
+			map<int, string>::const_iterator line = script.find(tick);
+			bool pressed = line != script.end();
+			if (pressed)
+				held = line->second;
+
+			input = inputFromKeys(held);
+			input.fire = pressed && held.find('F') != string::npos;
+		}
+
+		if (recordPath != NULL)
+			recording.record(input);
+
+		if (missiles > 0)
+			missilesFired += keepMissilesFlying(game, missiles, missileRng);
+
+		game.tick(input);
+
+		if (game.projectiles.getActiveCount() > peakMissiles)
+			peakMissiles = game.projectiles.getActiveCount();
+
+		if (transforms)
+		{
+			Stopwatch transformTimer;
+			visibleObstacles += obstacleTransforms.cull(chaseCamera(game));
+			obstacleTransforms.build(game.getTime());
+			transformTime += transformTimer.value();
+		}
+	}
+
+	double runTime = runTimer.value();
+
+	cout << " Timings : " << endl;
+	cout << "  build : " << game.timings.build << " ms" << endl;
+	printPhase("player", game.timings.player, ticks);
+	printPhase("projectiles", game.timings.projectiles, ticks);
+	printPhase("obstacles", game.timings.obstacles, ticks);
+	printPhase("collision", game.timings.collision, ticks);
+	if (transforms)
+		printPhase("obstacle transforms", transformTime, ticks);
+	printPhase("total", runTime, ticks);
+
+	cout << " Final state : " << endl;
+	cout << "  player at " << game.playerPosition.x << " " << game.playerPosition.y << " " << game.playerPosition.z << endl;
+	cout << "  missiles " << game.projectiles.getActiveCount() << ", at most " << peakMissiles << ", " << missilesFired << " fired by -missiles" << endl;
+	if (transforms)
+		cout << "  " << (double)visibleObstacles / ticks << " of " << obstacleTransforms.getCount() << " obstacles visible on average" << endl;
+	cout << "  obstacle " << game.obstacleNow << ", hits " << game.hitCount << ", missile hits " << game.missileHits << endl;
+	cout << "  state hash " << hex << game.stateHash() << dec << endl;
+
+	if (recordPath != NULL && !recording.save(recordPath))
+		cout << "failed to save recording " << recordPath << endl;
+	if (tracePath != NULL && !game.timings.saveTrace(tracePath))
+		cout << "failed to save trace " << tracePath << endl;
+
+	return 0;
+}
@@ -0,0 +1,185 @@
+#include "InputRecording.h"
+
+#include <cstring>
+#include <fstream>
+
+static const char MAGIC[4] = { 'F', 'F', 'I', 'R' };
+static const unsigned int VERSION = 2;		// 1 had no obstacle half width, its games used 30
+
+enum
+{
+	KEY_FORWARD = 1,
+	KEY_LEFT = 2,
+	KEY_RIGHT = 4,
+	KEY_FIRE = 8,
+	KEY_STOP_FIRE = 16
+};
+
+template <class T>
+static void writeValue(std::ofstream& file, const T& value)
+{
+	file.write((const char*)&value, sizeof(T));
+}
+
+template <class T>
+static bool readValue(std::ifstream& file, T& value)
+{
+	return (bool)file.read((char*)&value, sizeof(T));
+}
+
+InputRecording::InputRecording()
+{
+	clear();
+}
+
+void InputRecording::clear()
+{
+	runs.clear();
+	tickCount = 0;
+	cursorRun = 0;
+	cursorTick = 0;
+}
+
+unsigned char InputRecording::pack(const SimulationInput& input)
+{
+	unsigned char keys = 0;
+
+	if (input.forward) keys |= KEY_FORWARD;
+	if (input.turnLeft) keys |= KEY_LEFT;
+	if (input.turnRight) keys |= KEY_RIGHT;
+	if (input.fire) keys |= KEY_FIRE;
+	if (input.stopFire) keys |= KEY_STOP_FIRE;
+
+	return keys;
+}
+
+SimulationInput InputRecording::unpack(unsigned char keys)
+{
+	SimulationInput input;
+
+	input.forward = (keys & KEY_FORWARD) != 0;
+	input.turnLeft = (keys & KEY_LEFT) != 0;
+	input.turnRight = (keys & KEY_RIGHT) != 0;
+	input.fire = (keys & KEY_FIRE) != 0;
+	input.stopFire = (keys & KEY_STOP_FIRE) != 0;
+
+	return input;
+}
+
+void InputRecording::record(const SimulationInput& input)
+{
+	unsigned char keys = pack(input);
+
+	if (runs.empty() || runs.back().keys != keys || runs.back().length == 0xffff)
+	{
+		Run run;
+		run.keys = keys;
+		run.length = 0;
+		runs.push_back(run);
+	}
+
+	runs.back().length++;
+	tickCount++;
+}
+
+int InputRecording::getTickCount() const
+{
+	return tickCount;
+}
+
+SimulationInput InputRecording::getInput(int tick) const
+{
+	if (tick < 0 || tick >= tickCount)
+		return SimulationInput();
+
+	if (tick < cursorTick)
+	{
+		cursorRun = 0;
+		cursorTick = 0;
+	}
+
+	while (tick >= cursorTick + runs[cursorRun].length)
+	{
+		cursorTick += runs[cursorRun].length;
+		cursorRun++;
+	}
+
+	return unpack(runs[cursorRun].keys);
+}
+
+bool InputRecording::save(const char* path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	file.write(MAGIC, 4);
+	writeValue(file, VERSION);
+
+	writeValue(file, settings.radiusOfSegment);
+	writeValue(file, settings.edgeLength);
+	writeValue(file, settings.dimension);
+	writeValue(file, settings.vertInSegment);
+	writeValue(file, settings.edgePartition);
+	writeValue(file, settings.tickSeconds);
+	writeValue(file, settings.seed);
+	writeValue(file, settings.obstacleHalfWidth);
+
+	unsigned int runCount = runs.size();
+	writeValue(file, runCount);
+
+	for (int i = 0; i < runs.size(); i++)
+	{
+		writeValue(file, runs[i].keys);
+		writeValue(file, runs[i].length);
+	}
+
+	return (bool)file;
+}
+
+bool InputRecording::load(const char* path)
+{
+	clear();
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	char magic[4];
+	unsigned int version;
+
+	if (!file.read(magic, 4) || memcmp(magic, MAGIC, 4) != 0)
+		return false;
+	if (!readValue(file, version) || version < 1 || version > VERSION)
+		return false;
+
+	bool ok = readValue(file, settings.radiusOfSegment)
+		&& readValue(file, settings.edgeLength)
+		&& readValue(file, settings.dimension)
+		&& readValue(file, settings.vertInSegment)
+		&& readValue(file, settings.edgePartition)
+		&& readValue(file, settings.tickSeconds)
+		&& readValue(file, settings.seed);
+
+	settings.obstacleHalfWidth = SimulationSettings().obstacleHalfWidth;
+	ok = ok && (version < 2 || readValue(file, settings.obstacleHalfWidth));
+
+	unsigned int runCount;
+	if (!ok || !readValue(file, runCount))
+		return false;
+
+	runs.resize(runCount);
+
+	for (int i = 0; i < runCount; i++)
+	{
+		if (!readValue(file, runs[i].keys) || !readValue(file, runs[i].length))
+		{
+			clear();
+			return false;
+		}
+
+		tickCount += runs[i].length;
+	}
+
+	return true;
+}
@@ -0,0 +1,51 @@
+/*---The input of a game, recorded tick by tick together with the settings and the seed, so the game can be replayed and
+gives the same state on every tick. The keys of a tick are packed into one byte, and runs of equal ticks are stored as
+the byte and the length of the run.---*/
+
+#ifndef _INPUT_RECORDING_H
+#define _INPUT_RECORDING_H
+
+#include "Simulation.h"
+
+#include <vector>
+
+class InputRecording
+{
+private:
+
+	struct Run
+	{
+		unsigned char keys;
+		unsigned short length;
+	};
+
+	std::vector<Run> runs;
+	int tickCount;
+
+	// position of the last lookup, so a replay reading the ticks in order does not search the runs
+	mutable int cursorRun;
+	mutable int cursorTick;
+
+	static unsigned char pack(const SimulationInput& input);
+	static SimulationInput unpack(unsigned char keys);
+
+public:
+
+	SimulationSettings settings;	// the replay has to build the same tube with the same seed
+
+	InputRecording();
+
+	void clear();
+
+	// adds the input of the next tick
+	void record(const SimulationInput& input);
+
+	int getTickCount() const;
+	SimulationInput getInput(int tick) const;
+
+	// binary file, little endian as written by the x86 builds
+	bool save(const char* path) const;
+	bool load(const char* path);
+};
+
+#endif
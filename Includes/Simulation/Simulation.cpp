@@ -0,0 +1,277 @@
+#include "Simulation.h"
+#include "../Obstacles/ObstacleTransforms.h"
+#include "../Time/Stopwatch.h"
+#include "../Utilities/ParallelFor.h"
+
+#include <fstream>
+#include <random>
+
+const float Simulation::TIME_UNIT = 0.01f;
+const float Simulation::SPEED = 3.0f;
+const float Simulation::SPIN = 1.0f;
+const float Simulation::HIT_DISTANCE = 50.0f;
+const float Simulation::MISSILE_SPEED = 9.0f;
+
+SimulationInput::SimulationInput()
+{
+	forward = false;
+	turnLeft = false;
+	turnRight = false;
+	fire = false;
+	stopFire = false;
+}
+
+SimulationSettings::SimulationSettings()
+{
+	radiusOfSegment = 120.0f;
+	edgeLength = 30000;
+	dimension = 3;
+	vertInSegment = 16;
+	edgePartition = 30;
+	tickSeconds = 1.0 / 120.0;
+	seed = 1;
+	obstacleHalfWidth = 30.0f;
+}
+
+SimulationTimings::SimulationTimings()
+{
+	build = 0.0;
+	keepTrace = false;
+	reset();
+}
+
+void SimulationTimings::reset()
+{
+	player = 0.0;
+	projectiles = 0.0;
+	obstacles = 0.0;
+	collision = 0.0;
+	ticks = 0;
+	trace.clear();
+}
+
+bool SimulationTimings::saveTrace(const char* path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	for (int i = 0; i < trace.size(); i++)
+	{
+		file << i << " " << trace[i] << "\n";
+	}
+
+	return true;
+}
+
+Simulation::Simulation()
+{
+	playerDirectionMat = glm::mat4(1.0f);
+	playerTurn = glm::mat4(1.0f);
+	playerTransformations = glm::mat4(1.0f);
+
+	tickCount = 0;
+	obstacleCursor = 0;
+
+	obstacleNow = 0;
+	lastHitObstacle = -1;
+	hitCount = 0;
+	missileHits = 0;
+}
+
+void Simulation::init(const SimulationSettings& gameSettings)
+{
+	settings = gameSettings;
+
+	Stopwatch buildTimer;
+
+	tube.constructGeometry(settings.radiusOfSegment, settings.edgeLength, settings.dimension, settings.vertInSegment);
+
+	std::mt19937 rng(settings.seed);
+	float edgePart = settings.edgeLength / settings.edgePartition;
+	std::vector<glm::vec3> points, directions;
+	std::vector<float> rotationSpeeds, distances;
+	tube.obstaclePositions(edgePart, rng, points, directions, rotationSpeeds, distances);
+	obstacles.build(tube.path.getLength(), distances, points, directions, rotationSpeeds);
+	obstacleCollider.setProxy(glm::vec3(0.0f), glm::vec3(settings.obstacleHalfWidth));
+	obstacleCollider.setObstacles(points, directions, rotationSpeeds, settings.radiusOfSegment * 0.7f);
+	projectiles.setTube(&tube);
+
+	timings.build = buildTimer.value();
+
+	playerPosition = tube.flake.verts[0];
+	obstacleNow = obstacles.advance(obstacleCursor, tube.getTravelled());
+}
+
+float Simulation::getTimeStep() const
+{
+	return (float)(settings.tickSeconds / TIME_UNIT);
+}
+
+glm::vec3 Simulation::getFireDirection() const
+{
+	return -glm::normalize(glm::vec3(playerTransformations[2][0], playerTransformations[2][1], playerTransformations[2][2]));
+}
+
+double Simulation::getTime() const
+{
+	return tickCount * (double)getTimeStep();
+}
+
+void Simulation::tick(const SimulationInput& input)
+{
+	tickCount++;
+
+	Stopwatch tickTimer;
+	Stopwatch timer;
+	updatePlayer(input);
+	timings.player += timer.value();
+
+	timer.reset();
+	updateProjectiles(input);
+	timings.projectiles += timer.value();
+
+	timer.reset();
+	updateObstacles();
+	timings.obstacles += timer.value();
+
+	timer.reset();
+	updateCollisions();
+	timings.collision += timer.value();
+
+	if (timings.keepTrace)
+		timings.trace.push_back((float)tickTimer.value());
+
+	timings.ticks++;
+}
+
+// FNV-1a over the bytes of a value
+template <class T>
+static void hashBytes(unsigned int& hash, const T& value)
+{
+	const unsigned char* bytes = (const unsigned char*)&value;
+
+	for (int i = 0; i < sizeof(T); i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+}
+
+unsigned int Simulation::stateHash() const
+{
+	unsigned int hash = 2166136261u;
+
+	hashBytes(hash, playerPosition);
+	hashBytes(hash, playerDirectionMat);
+	hashBytes(hash, playerTurn);
+	hashBytes(hash, cameraTarget);
+	hashBytes(hash, obstacleNow);
+	hashBytes(hash, lastHitObstacle);
+	hashBytes(hash, hitCount);
+	hashBytes(hash, missileHits);
+
+	float projectileTime = projectiles.getTime();
+	int projectileCount = projectiles.getActiveCount();
+	hashBytes(hash, projectileTime);
+	hashBytes(hash, projectileCount);
+
+	for (int i = 0; i < projectiles.getSlotCount(); i++)
+	{
+		if (projectiles.isAlive(i))
+			hashBytes(hash, projectiles.position(i));
+	}
+
+	return hash;
+}
+
+void Simulation::updatePlayer(const SimulationInput& input)
+{
+	float speed = input.forward ? SPEED * getTimeStep() : 0.0f;
+	float turn = 0.0f;
+
+	if (input.turnRight)
+		turn = -SPIN * getTimeStep();
+	else if (input.turnLeft)
+		turn = SPIN * getTimeStep();
+
+	tube.playerPosition(playerPosition, cameraTarget, playerDirectionMat, playerTurn, speed, turn);
+
+	playerTransformations = glm::translate(glm::mat4(1.0), playerPosition);
+	playerTransformations = playerTransformations * playerDirectionMat;
+	playerTransformations = glm::translate(playerTransformations, glm::vec3(0.0f, -settings.radiusOfSegment * 0.7, 0.0f));
+
+	glm::vec4 front = playerTransformations * glm::vec4(0, 0, -50, 1);
+	nosePosition = glm::vec3(front.x, front.y, front.z);
+}
+
+void Simulation::updateProjectiles(const SimulationInput& input)
+{
+	// every press adds a missile, a full pool ignores it
+	if (input.fire)
+		projectiles.fire(nosePosition, getFireDirection(), MISSILE_SPEED);
+	if (input.stopFire)
+		projectiles.clear();
+
+	projectiles.update(getTimeStep());
+}
+
+void Simulation::updateObstacles()
+{
+	nearObstacles.clear();
+
+	if (obstacles.getCount() == 0)
+		return;
+
+	float s = tube.getTravelled();
+	obstacleNow = obstacles.advance(obstacleCursor, s);
+
+	// an obstacle centre and the nose are each within 0.7 radius (and the nose 50 more) of their points on the path. At
+	// the sharpest corner of the flake the distance along the path is at most twice the straight one.
+	float reach = 2.0f * (1.4f * settings.radiusOfSegment + 50.0f + HIT_DISTANCE);
+	obstacles.range(s - reach, s + reach, nearObstacles);
+
+	// the same angles the renderer gives every obstacle
+	obstacles.updateSpins(nearObstacles, getTime());
+}
+
+void Simulation::updateCollisions()
+{
+	for (int i = 0; i < nearObstacles.size(); i++)
+	{
+		int o = nearObstacles[i];
+
+		// the obstacles turn round the path at the height the player flies at
+		glm::mat4 obstacle = glm::translate(glm::mat4(1.0), obstacles.getPoint(o));
+		obstacle = glm::rotate(obstacle, obstacles.getSpin(o), obstacles.getDirection(o));
+		glm::vec4 centre = obstacle * glm::vec4(0.0f, -settings.radiusOfSegment * 0.7, 0.0f, 1.0f);
+
+		if (glm::length(glm::vec3(centre.x, centre.y, centre.z) - nosePosition) < HIT_DISTANCE)
+		{
+			if (lastHitObstacle != o)
+			{
+				hitCount++;
+				lastHitObstacle = o;
+			}
+		}
+	}
+
+	//---missiles against every obstacle, each only looks at the obstacles in its cell of the hash---
+	int slots = projectiles.getSlotCount();
+	double time = getTime();
+	projectileHits.resize(slots);
+
+	ParallelFor::run(0, slots, [&](int i)
+	{
+		projectileHits[i] = projectiles.isAlive(i) ? obstacleCollider.pointHit(projectiles.position(i), time) : -1;
+	}, 1024);
+
+	for (int i = 0; i < slots; i++)
+	{
+		if (projectileHits[i] >= 0)
+		{
+			projectiles.remove(i);
+			missileHits++;
+		}
+	}
+}
@@ -0,0 +1,128 @@
+/*---The game without the window: the player flying along the tube, the missiles, the obstacles and the collisions between
+them. It is advanced in fixed ticks with the keys held during the tick, and does not use GL, so it can also run headless.---*/
+
+#ifndef _SIMULATION_H
+#define _SIMULATION_H
+
+#include "../tube.h"
+#include "../Projectiles/ProjectileSystem.h"
+#include "../Obstacles/ObstacleIndex.h"
+#include "../Collision/ObstacleCollider.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// the keys that control the game during one tick
+struct SimulationInput
+{
+	bool forward;			// W or S
+	bool turnLeft;			// A
+	bool turnRight;			// D
+	bool fire;				// F, fires a missile
+	bool stopFire;			// R, removes every missile
+
+	SimulationInput();
+};
+
+struct SimulationSettings
+{
+	float radiusOfSegment;
+	int edgeLength;
+	int dimension;
+	int vertInSegment;
+	int edgePartition;		// number of obstacles along one edge of the dimension 0 triangle
+	double tickSeconds;
+	unsigned int seed;		// seed of the random numbers of the game
+	float obstacleHalfWidth;	// half the largest extent of the obstacle model, the box missiles hit. The game takes it
+							// from the bounds of the loaded model, the headless runner from the recording or the default.
+
+	// the settings of the game
+	SimulationSettings();
+};
+
+// milliseconds spent in each part of the simulation, summed over the ticks since the last reset
+struct SimulationTimings
+{
+	double build;
+	double player;
+	double projectiles;
+	double obstacles;
+	double collision;
+	int ticks;
+
+	bool keepTrace;				// store the time of every tick in trace
+	std::vector<float> trace;
+
+	SimulationTimings();
+	void reset();
+
+	// writes the trace as text, one "tick milliseconds" line per tick
+	bool saveTrace(const char* path) const;
+};
+
+class Simulation
+{
+private:
+
+	int tickCount;					// ticks since init, the time of the game
+	int obstacleCursor;				// follows the player through the obstacle index
+	std::vector<int> projectileHits;	// obstacle hit by each projectile slot in this tick, or -1
+
+	void updatePlayer(const SimulationInput& input);
+	void updateProjectiles(const SimulationInput& input);
+	void updateObstacles();
+	void updateCollisions();
+
+public:
+
+	static const float TIME_UNIT;			// speed, spin and projectile times are counted in 10 ms steps
+	static const float SPEED;				// distance flown per time unit
+	static const float SPIN;				// degrees turned per time unit
+	static const float HIT_DISTANCE;		// nose closer than this to the centre of an obstacle is a hit
+	static const float MISSILE_SPEED;		// distance a missile flies per time unit
+
+	SimulationSettings settings;
+	SimulationTimings timings;
+	Tube tube;
+	ProjectileSystem projectiles;
+
+	//---player---
+	glm::vec3 playerPosition;
+	glm::mat4 playerDirectionMat;
+	glm::mat4 playerTurn;
+	glm::mat4 playerTransformations;
+	glm::vec3 cameraTarget;
+	glm::vec3 nosePosition;			// front of the player, where the missiles are fired from
+
+	//---obstacles---
+	ObstacleIndex obstacles;		// sorted by distance along the path
+	int obstacleNow;				// the first obstacle in front of the player
+	std::vector<int> nearObstacles;	// obstacles close enough along the path for the player to hit, spun to this tick
+	int lastHitObstacle;			// an obstacle is only counted once while the player passes it
+	int hitCount;
+	ObstacleCollider obstacleCollider;	// missiles against the obstacles
+	int missileHits;				// missiles that hit an obstacle, they are removed when they do
+
+	Simulation();
+
+	// builds the tube and places the obstacles along it
+	void init(const SimulationSettings& gameSettings);
+
+	// advances the game by one tick of settings.tickSeconds
+	void tick(const SimulationInput& input);
+
+	// length of a tick in time units
+	float getTimeStep() const;
+
+	// time units since init
+	double getTime() const;
+
+	// the direction the player faces, missiles fly along it
+	glm::vec3 getFireDirection() const;
+
+	// hash of the state that the ticks change. Two runs with the same settings and input give the same hash.
+	unsigned int stateHash() const;
+};
+
+#endif
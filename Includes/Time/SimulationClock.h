@@ -0,0 +1,79 @@
+#ifndef _SIMULATION_CLOCK_H
+#define _SIMULATION_CLOCK_H
+
+#include <chrono>
+
+// fixed timestep clock. The time of every frame is added to an accumulator, which is spent in whole simulation ticks;
+// what is left over is the fraction of a tick the rendered frame lies past the last simulated state.
+class SimulationClock
+{
+private:
+	std::chrono::steady_clock::time_point previous_;
+	double tick_;			// seconds per simulation tick
+	double maxFrame_;		// longest frame that is simulated, so a stall does not build up ticks that can not be caught up
+	double accumulator_;
+	unsigned long long ticks_;
+
+public:
+	inline SimulationClock(double tickSeconds = 1.0 / 120.0, double maxFrameSeconds = 0.25)
+		: previous_(std::chrono::steady_clock::now()), tick_(tickSeconds), maxFrame_(maxFrameSeconds), accumulator_(0.0), ticks_(0)
+	{
+	}
+
+	// starts measuring from now, with nothing left to simulate
+	inline void reset()
+	{
+		previous_ = std::chrono::steady_clock::now();
+		accumulator_ = 0.0;
+	}
+
+	// adds the time since the last call and returns the number of ticks to simulate for this frame
+	inline int advance()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double frameSeconds = std::chrono::duration<double>(now - previous_).count();
+		previous_ = now;
+
+		return advance(frameSeconds);
+	}
+
+	// same as advance() with a given frame time, for replays and benchmarks that do not run in real time
+	inline int advance(double frameSeconds)
+	{
+		if (frameSeconds > maxFrame_)
+			frameSeconds = maxFrame_;
+		if (frameSeconds < 0.0)
+			frameSeconds = 0.0;
+
+		accumulator_ += frameSeconds;
+
+		int count = 0;
+		while (accumulator_ >= tick_)
+		{
+			accumulator_ -= tick_;
+			count++;
+		}
+
+		ticks_ += count;
+		return count;
+	}
+
+	// fraction (0..1) of a tick between the last two simulated states at which the frame should be drawn
+	inline float alpha() const
+	{
+		return (float)(accumulator_ / tick_);
+	}
+
+	inline double getTick() const
+	{
+		return tick_;
+	}
+
+	// ticks simulated since the clock was created
+	inline unsigned long long getTickCount() const
+	{
+		return ticks_;
+	}
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef _STOPWATCH_H
+#define _STOPWATCH_H
+
+#include <chrono>
+
+// high resolution timer for measuring pieces of code
+class Stopwatch
+{
+private:
+	std::chrono::steady_clock::time_point initial_;
+
+public:
+	inline Stopwatch() : initial_(std::chrono::steady_clock::now())
+	{
+	}
+
+	inline void reset()
+	{
+		initial_ = std::chrono::steady_clock::now();
+	}
+
+	// elapsed time in milliseconds
+	inline double value() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initial_).count();
+	}
+};
+
+#endif
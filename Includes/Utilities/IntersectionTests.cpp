@@ -302,4 +302,145 @@ int IntersectionTests::triBoxOverlap(float boxhalfsize[3],float v0[3], float v1[
    if(!planeBoxOverlap(normal,d,boxhalfsize)) return 0;
 
    return 1;   /* box and triangle overlaps */
-}
\ No newline at end of file
+}
+
+/********************************************************/
+/* Ray-triangle intersection test                       */
+/* by Tomas Moller and Ben Trumbore                     */
+/* "Fast, Minimum Storage Ray/Triangle Intersection"    */
+/* Returns t along dir (not normalised) and the         */
+/* barycentric coordinates u, v of the hit. Both sides  */
+/* of the triangle are tested.                          */
+/********************************************************/
+#define RAYTRI_EPSILON 0.000001
+
+bool IntersectionTests::rayTriangleIntersect(const float orig[3], const float dir[3], const float vert0[3], const float vert1[3], const float vert2[3], float& t, float& u, float& v)
+{
+   float edge1[3], edge2[3], tvec[3], pvec[3], qvec[3];
+   float det, inv_det;
+
+   /* find vectors for two edges sharing vert0 */
+   SUB(edge1, vert1, vert0);
+   SUB(edge2, vert2, vert0);
+
+   /* begin calculating determinant - also used to calculate U parameter */
+   CROSS(pvec, dir, edge2);
+
+   /* if determinant is near zero, ray lies in plane of triangle */
+   det = DOT(edge1, pvec);
+
+   if (det > -RAYTRI_EPSILON && det < RAYTRI_EPSILON)
+     return false;
+   inv_det = 1.0f / det;
+
+   /* calculate distance from vert0 to ray origin */
+   SUB(tvec, orig, vert0);
+
+   /* calculate U parameter and test bounds */
+   u = DOT(tvec, pvec) * inv_det;
+   if (u < 0.0f || u > 1.0f)
+     return false;
+
+   /* prepare to test V parameter */
+   CROSS(qvec, tvec, edge1);
+
+   /* calculate V parameter and test bounds */
+   v = DOT(dir, qvec) * inv_det;
+   if (v < 0.0f || u + v > 1.0f)
+     return false;
+
+   /* calculate t, ray intersects triangle */
+   t = DOT(edge2, qvec) * inv_det;
+
+   return true;
+}
+
+/********************************************************/
+/* Closest point on a triangle to a point               */
+/* from "Real-Time Collision Detection" by C. Ericson   */
+/* Finds the Voronoi region of the triangle the point   */
+/* projects into, so no square roots are needed.        */
+/********************************************************/
+void IntersectionTests::closestPointOnTriangle(const float p[3], const float a[3], const float b[3], const float c[3], float closest[3])
+{
+   float ab[3], ac[3], ap[3], bp[3], cp[3];
+   float d1, d2, d3, d4, d5, d6, va, vb, vc, v, w, denom;
+
+   SUB(ab, b, a);
+   SUB(ac, c, a);
+   SUB(ap, p, a);
+
+   /* vertex region outside a */
+   d1 = DOT(ab, ap);
+   d2 = DOT(ac, ap);
+   if (d1 <= 0.0f && d2 <= 0.0f)
+   {
+     closest[X] = a[X]; closest[Y] = a[Y]; closest[Z] = a[Z];
+     return;
+   }
+
+   /* vertex region outside b */
+   SUB(bp, p, b);
+   d3 = DOT(ab, bp);
+   d4 = DOT(ac, bp);
+   if (d3 >= 0.0f && d4 <= d3)
+   {
+     closest[X] = b[X]; closest[Y] = b[Y]; closest[Z] = b[Z];
+     return;
+   }
+
+   /* edge region of ab */
+   vc = d1 * d4 - d3 * d2;
+   if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+   {
+     v = d1 / (d1 - d3);
+     closest[X] = a[X] + v * ab[X]; closest[Y] = a[Y] + v * ab[Y]; closest[Z] = a[Z] + v * ab[Z];
+     return;
+   }
+
+   /* vertex region outside c */
+   SUB(cp, p, c);
+   d5 = DOT(ab, cp);
+   d6 = DOT(ac, cp);
+   if (d6 >= 0.0f && d5 <= d6)
+   {
+     closest[X] = c[X]; closest[Y] = c[Y]; closest[Z] = c[Z];
+     return;
+   }
+
+   /* edge region of ac */
+   vb = d5 * d2 - d1 * d6;
+   if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+   {
+     w = d2 / (d2 - d6);
+     closest[X] = a[X] + w * ac[X]; closest[Y] = a[Y] + w * ac[Y]; closest[Z] = a[Z] + w * ac[Z];
+     return;
+   }
+
+   /* edge region of bc */
+   va = d3 * d6 - d5 * d4;
+   if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+   {
+     w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+     closest[X] = b[X] + w * (c[X] - b[X]); closest[Y] = b[Y] + w * (c[Y] - b[Y]); closest[Z] = b[Z] + w * (c[Z] - b[Z]);
+     return;
+   }
+
+   /* inside the face */
+   denom = 1.0f / (va + vb + vc);
+   v = vb * denom;
+   w = vc * denom;
+   closest[X] = a[X] + ab[X] * v + ac[X] * w;
+   closest[Y] = a[Y] + ab[Y] * v + ac[Y] * w;
+   closest[Z] = a[Z] + ab[Z] * v + ac[Z] * w;
+}
+
+bool IntersectionTests::sphereTriangleIntersect(const float center[3], float radius, const float vert0[3], const float vert1[3], const float vert2[3])
+{
+   float closest[3], diff[3];
+
+   closestPointOnTriangle(center, vert0, vert1, vert2, closest);
+   SUB(diff, closest, center);
+
+   return DOT(diff, diff) <= radius * radius;
+}
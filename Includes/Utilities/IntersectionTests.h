@@ -12,6 +12,9 @@
 /* Thanks to David Hunt for finding a ">="-bug!         */
 /********************************************************/
 
+#ifndef _INTERSECTION_TESTS_H
+#define _INTERSECTION_TESTS_H
+
 class IntersectionTests
 {
 public:
@@ -20,4 +23,9 @@ public:
 	static int triBoxOverlap(float boxhalfsize[3],float v0[3], float v1[3],float v2[3]);
 	static int triBoxOverlap(double boxcenter[3],double boxhalfsize[3],double triverts[3][3]);
 	static bool OBB_RAY_Intersect(float fromRay[3], float toRay[3]);
-};
\ No newline at end of file
+	static bool rayTriangleIntersect(const float orig[3], const float dir[3], const float vert0[3], const float vert1[3], const float vert2[3], float& t, float& u, float& v);
+	static void closestPointOnTriangle(const float p[3], const float a[3], const float b[3], const float c[3], float closest[3]);
+	static bool sphereTriangleIntersect(const float center[3], float radius, const float vert0[3], const float vert1[3], const float vert2[3]);
+};
+
+#endif
@@ -0,0 +1,40 @@
+/*---A file mapped read only into memory, so its contents can be used in place without reading or copying them. The
+pages are loaded by the system on first touch and shared with the file cache.---*/
+
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+#include <cstddef>
+
+class MappedFile
+{
+private:
+
+	const char* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* file;			// handles of the file and of its mapping
+	void* mapping;
+#else
+	int descriptor;
+#endif
+
+	MappedFile(const MappedFile&);
+	void operator=(const MappedFile&);
+
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	// maps the whole file, false when it does not exist or is empty
+	bool open(const char* path);
+	void close();
+
+	bool isOpen() const;
+	const char* getData() const;
+	size_t getSize() const;
+};
+
+#endif
@@ -0,0 +1,457 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+//---vertex cache order---
+
+static const int MAX_SCORED_VALENCE = 32;
+
+// Forsyth's score of a vertex: high in the last few places of the cache, and for vertices with few triangles left so
+// they are not stranded
+static float vertexScore(const float* cacheScores, const float* valenceScores, int cachePosition, int valence)
+{
+	if (valence == 0)
+		return 0.0f;
+
+	float score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+	return score + valenceScores[valence < MAX_SCORED_VALENCE ? valence : MAX_SCORED_VALENCE];
+}
+
+void MeshOptimizer::optimizeVertexCache(unsigned int* indices, int indexCount, int vertexCount)
+{
+	int triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	float cacheScores[SCORE_CACHE_SIZE];
+	for (int i = 0; i < SCORE_CACHE_SIZE; i++)
+		cacheScores[i] = i < 3 ? 0.75f : pow(1.0f - (i - 3) / float(SCORE_CACHE_SIZE - 3), 1.5f);
+
+	float valenceScores[MAX_SCORED_VALENCE + 1];
+	valenceScores[0] = 0.0f;
+	for (int i = 1; i <= MAX_SCORED_VALENCE; i++)
+		valenceScores[i] = 2.0f / sqrt((float)i);
+
+	// the triangles of each vertex, the ones still to be drawn in the first live[v] places
+	std::vector<int> live(vertexCount, 0);
+	for (int i = 0; i < triangleCount * 3; i++)
+		live[indices[i]]++;
+
+	std::vector<int> triangleStart(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; v++)
+		triangleStart[v + 1] = triangleStart[v] + live[v];
+
+	std::vector<int> adjacency(triangleCount * 3);
+	std::vector<int> fill(triangleStart.begin(), triangleStart.end() - 1);
+	for (int i = 0; i < triangleCount * 3; i++)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (int v = 0; v < vertexCount; v++)
+		vertexScores[v] = vertexScore(cacheScores, valenceScores, -1, live[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	int best = 0;
+	for (int t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		best = triangleScores[t] > triangleScores[best] ? t : best;
+	}
+
+	std::vector<char> emitted(triangleCount, 0);
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+
+	unsigned int cache[SCORE_CACHE_SIZE + 3];
+	unsigned int newCache[SCORE_CACHE_SIZE + 3];
+	int cacheCount = 0;
+	int cursor = 0;		// the triangles before it are drawn, for the dead ends
+
+	while (best >= 0)
+	{
+		const unsigned int* triangle = &indices[best * 3];
+		result.insert(result.end(), triangle, triangle + 3);
+		emitted[best] = 1;
+
+		// the triangle leaves the live triangles of its vertices
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = triangle[k];
+			int* first = &adjacency[triangleStart[v]];
+			for (int i = 0; i < live[v]; i++)
+			{
+				if (first[i] == best)
+				{
+					std::swap(first[i], first[live[v] - 1]);
+					live[v]--;
+					break;
+				}
+			}
+		}
+
+		// the vertices of the triangle go to the front of the cache and push the others back
+		int newCount = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			if (std::find(newCache, newCache + newCount, triangle[k]) == newCache + newCount)
+				newCache[newCount++] = triangle[k];
+		}
+		for (int i = 0; i < cacheCount; i++)
+		{
+			if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+				newCache[newCount++] = cache[i];
+		}
+
+		// the score of every vertex in or just out of the cache changes, and with it the scores of its live triangles
+		best = -1;
+		for (int i = 0; i < newCount; i++)
+		{
+			unsigned int v = newCache[i];
+			cachePosition[v] = i < SCORE_CACHE_SIZE ? i : -1;
+
+			float score = vertexScore(cacheScores, valenceScores, cachePosition[v], live[v]);
+			float change = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			for (int j = 0; j < live[v]; j++)
+			{
+				int t = adjacency[triangleStart[v] + j];
+				triangleScores[t] += change;
+				if (best < 0 || triangleScores[t] > triangleScores[best])
+					best = t;
+			}
+		}
+
+		cacheCount = newCount < SCORE_CACHE_SIZE ? newCount : SCORE_CACHE_SIZE;
+		std::copy(newCache, newCache + cacheCount, cache);
+
+		// no triangle round the cache is left, start again at the first triangle not drawn
+		if (best < 0)
+		{
+			while (cursor < triangleCount && emitted[cursor])
+				cursor++;
+			best = cursor < triangleCount ? cursor : -1;
+		}
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+//---overdraw order---
+
+// true when vertex v misses a FIFO cache of cacheSize, which then holds it
+static bool cacheMiss(std::vector<int>& cacheTime, int& time, unsigned int v, int cacheSize)
+{
+	if (time - cacheTime[v] <= cacheSize)
+		return false;
+
+	cacheTime[v] = time++;
+	return true;
+}
+
+struct OverdrawCluster
+{
+	int start, end;		// triangles
+	float sortKey;
+};
+
+static bool outwardFirst(const OverdrawCluster& a, const OverdrawCluster& b)
+{
+	return a.sortKey > b.sortKey;
+}
+
+void MeshOptimizer::optimizeOverdraw(unsigned int* indices, int indexCount, const float* positions, int stride, int vertexCount, float threshold)
+{
+	const int cacheSize = 16;
+	int triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	//---hard boundaries, where all three vertices of a triangle miss, and the order of the triangles starts again---
+	std::vector<int> hardStarts;
+	std::vector<int> cacheTime(vertexCount, INT_MIN / 2);
+	int time = 0;
+	for (int t = 0; t < triangleCount; t++)
+	{
+		int misses = 0;
+		for (int k = 0; k < 3; k++)
+			misses += cacheMiss(cacheTime, time, indices[t * 3 + k], cacheSize);
+
+		if (misses == 3)
+			hardStarts.push_back(t);
+	}
+	if (hardStarts.empty() || hardStarts[0] != 0)
+		hardStarts.insert(hardStarts.begin(), 0);
+	hardStarts.push_back(triangleCount);
+
+	//---soft boundaries, inside a hard cluster wherever the misses so far are few enough to start a cluster there---
+	std::vector<OverdrawCluster> clusters;
+	for (int h = 0; h + 1 < hardStarts.size(); h++)
+	{
+		int start = hardStarts[h];
+		int end = hardStarts[h + 1];
+
+		time += cacheSize + 1;
+		int clusterMisses = 0;
+		for (int t = start; t < end; t++)
+		{
+			for (int k = 0; k < 3; k++)
+				clusterMisses += cacheMiss(cacheTime, time, indices[t * 3 + k], cacheSize);
+		}
+		float acmrLimit = threshold * clusterMisses / (end - start);
+
+		time += cacheSize + 1;
+		int softStart = start;
+		int misses = 0;
+		for (int t = start; t < end; t++)
+		{
+			for (int k = 0; k < 3; k++)
+				misses += cacheMiss(cacheTime, time, indices[t * 3 + k], cacheSize);
+
+			if (t + 1 < end && misses <= acmrLimit * (t + 1 - softStart))
+			{
+				OverdrawCluster cluster = { softStart, t + 1, 0.0f };
+				clusters.push_back(cluster);
+				softStart = t + 1;
+				misses = 0;
+				time += cacheSize + 1;
+			}
+		}
+
+		OverdrawCluster cluster = { softStart, end, 0.0f };
+		clusters.push_back(cluster);
+	}
+
+	//---the clusters facing away from the centre of the mesh first---
+	std::vector<float> centroids(clusters.size() * 3), normals(clusters.size() * 3);
+	double meshCentroid[3] = { 0.0, 0.0, 0.0 };
+	double meshArea = 0.0;
+	for (int c = 0; c < clusters.size(); c++)
+	{
+		double centroid[3] = { 0.0, 0.0, 0.0 }, normal[3] = { 0.0, 0.0, 0.0 };
+		double area = 0.0;
+		for (int t = clusters[c].start; t < clusters[c].end; t++)
+		{
+			const float* a = &positions[indices[t * 3] * stride];
+			const float* b = &positions[indices[t * 3 + 1] * stride];
+			const float* d = &positions[indices[t * 3 + 2] * stride];
+
+			double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			double ad[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+			double cross[3] = { ab[1] * ad[2] - ab[2] * ad[1], ab[2] * ad[0] - ab[0] * ad[2], ab[0] * ad[1] - ab[1] * ad[0] };
+			double triangleArea = sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+			for (int a3 = 0; a3 < 3; a3++)
+			{
+				centroid[a3] += (a[a3] + b[a3] + d[a3]) / 3.0 * triangleArea;
+				normal[a3] += cross[a3];
+			}
+			area += triangleArea;
+		}
+
+		double normalLength = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		for (int a3 = 0; a3 < 3; a3++)
+		{
+			meshCentroid[a3] += centroid[a3];
+			centroids[c * 3 + a3] = (float)(area > 0.0 ? centroid[a3] / area : 0.0);
+			normals[c * 3 + a3] = (float)(normalLength > 0.0 ? normal[a3] / normalLength : 0.0);
+		}
+		meshArea += area;
+	}
+
+	for (int c = 0; c < clusters.size(); c++)
+	{
+		float key = 0.0f;
+		for (int a3 = 0; a3 < 3; a3++)
+			key += (centroids[c * 3 + a3] - (float)(meshArea > 0.0 ? meshCentroid[a3] / meshArea : 0.0)) * normals[c * 3 + a3];
+		clusters[c].sortKey = key;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), outwardFirst);
+
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+	for (int c = 0; c < clusters.size(); c++)
+		result.insert(result.end(), indices + clusters[c].start * 3, indices + clusters[c].end * 3);
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+//---vertex fetch order---
+
+int MeshOptimizer::optimizeVertexFetch(unsigned int* indices, int indexCount, int vertexCount, std::vector<unsigned int>& remap)
+{
+	const unsigned int unused = ~0u;
+	remap.assign(vertexCount, unused);
+
+	unsigned int next = 0;
+	for (int i = 0; i < indexCount; i++)
+	{
+		if (remap[indices[i]] == unused)
+			remap[indices[i]] = next++;
+		indices[i] = remap[indices[i]];
+	}
+
+	int used = next;
+	for (int v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] == unused)
+			remap[v] = next++;
+	}
+
+	return used;
+}
+
+//---analysis---
+
+VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const unsigned int* indices, int indexCount, int vertexCount, int cacheSize, int triangleCount)
+{
+	std::vector<int> cacheTime(vertexCount, INT_MIN / 2);
+	std::vector<char> used(vertexCount, 0);
+	int time = 0;
+	int usedCount = 0;
+
+	VertexCacheStatistics statistics;
+	statistics.transformed = 0;
+	for (int i = 0; i < indexCount; i++)
+	{
+		statistics.transformed += cacheMiss(cacheTime, time, indices[i], cacheSize);
+		usedCount += !used[indices[i]];
+		used[indices[i]] = 1;
+	}
+
+	if (triangleCount < 0)
+		triangleCount = indexCount / 3;
+
+	statistics.acmr = triangleCount > 0 ? (float)statistics.transformed / triangleCount : 0.0f;
+	statistics.atvr = usedCount > 0 ? (float)statistics.transformed / usedCount : 0.0f;
+	return statistics;
+}
+
+float MeshOptimizer::analyzeVertexFetch(const unsigned int* indices, int indexCount, int vertexCount, int vertexSize)
+{
+	const int cacheSize = 16;
+	const int lineSize = 64;
+	const int lineCount = 16 * 1024 / lineSize;
+
+	std::vector<int> cacheTime(vertexCount, INT_MIN / 2);
+	std::vector<char> used(vertexCount, 0);
+	int time = 0;
+	int usedCount = 0;
+
+	// a direct mapped cache of the lines of the vertex buffer
+	std::vector<long long> lines(lineCount, -1);
+	long long fetched = 0;
+
+	for (int i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		usedCount += !used[v];
+		used[v] = 1;
+
+		if (!cacheMiss(cacheTime, time, v, cacheSize))
+			continue;
+
+		long long first = (long long)v * vertexSize / lineSize;
+		long long last = ((long long)v * vertexSize + vertexSize - 1) / lineSize;
+		for (long long line = first; line <= last; line++)
+		{
+			if (lines[line % lineCount] != line)
+			{
+				lines[line % lineCount] = line;
+				fetched += lineSize;
+			}
+		}
+	}
+
+	return usedCount > 0 ? (float)fetched / ((long long)usedCount * vertexSize) : 0.0f;
+}
+
+OverdrawStatistics MeshOptimizer::analyzeOverdraw(const unsigned int* indices, int indexCount, const float* positions, int stride, int vertexCount)
+{
+	const int size = 256;
+
+	OverdrawStatistics statistics;
+	statistics.covered = 0;
+	statistics.shaded = 0;
+	statistics.overdraw = 0.0f;
+	if (vertexCount == 0 || indexCount < 3)
+		return statistics;
+
+	float minimum[3], maximum[3];
+	for (int a = 0; a < 3; a++)
+		minimum[a] = maximum[a] = positions[a];
+	for (int v = 1; v < vertexCount; v++)
+	{
+		for (int a = 0; a < 3; a++)
+		{
+			minimum[a] = std::min(minimum[a], positions[v * stride + a]);
+			maximum[a] = std::max(maximum[a], positions[v * stride + a]);
+		}
+	}
+
+	float extent = std::max(std::max(maximum[0] - minimum[0], maximum[1] - minimum[1]), maximum[2] - minimum[2]);
+	float scale = extent > 0.0f ? (size - 1) / extent : 0.0f;
+
+	std::vector<float> depth(size * size);
+	for (int view = 0; view < 6; view++)
+	{
+		// the screen axes and the depth of the view, looking along +axis or -axis
+		int axis = view / 2;
+		int x = (axis + 1) % 3;
+		int y = (axis + 2) % 3;
+		float direction = view % 2 == 0 ? 1.0f : -1.0f;
+
+		std::fill(depth.begin(), depth.end(), 1e30f);
+		for (int t = 0; t < indexCount / 3; t++)
+		{
+			float screen[3][3];
+			for (int k = 0; k < 3; k++)
+			{
+				const float* p = &positions[indices[t * 3 + k] * stride];
+				screen[k][0] = (p[x] - minimum[x]) * scale;
+				screen[k][1] = (p[y] - minimum[y]) * scale;
+				screen[k][2] = (p[axis] - minimum[axis]) * direction;
+			}
+
+			float area = (screen[1][0] - screen[0][0]) * (screen[2][1] - screen[0][1]) - (screen[2][0] - screen[0][0]) * (screen[1][1] - screen[0][1]);
+			if (area == 0.0f)
+				continue;
+
+			int left = std::max(0, (int)ceil(std::min(std::min(screen[0][0], screen[1][0]), screen[2][0]) - 0.5f));
+			int right = std::min(size - 1, (int)floor(std::max(std::max(screen[0][0], screen[1][0]), screen[2][0]) - 0.5f));
+			int bottom = std::max(0, (int)ceil(std::min(std::min(screen[0][1], screen[1][1]), screen[2][1]) - 0.5f));
+			int top = std::min(size - 1, (int)floor(std::max(std::max(screen[0][1], screen[1][1]), screen[2][1]) - 0.5f));
+
+			// barycentric weights at the pixel centres, positive inside for either winding
+			for (int py = bottom; py <= top; py++)
+			{
+				for (int px = left; px <= right; px++)
+				{
+					float sx = px + 0.5f, sy = py + 0.5f;
+					float w0 = ((screen[1][0] - sx) * (screen[2][1] - sy) - (screen[2][0] - sx) * (screen[1][1] - sy)) / area;
+					float w1 = ((screen[2][0] - sx) * (screen[0][1] - sy) - (screen[0][0] - sx) * (screen[2][1] - sy)) / area;
+					float w2 = 1.0f - w0 - w1;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						continue;
+
+					float z = w0 * screen[0][2] + w1 * screen[1][2] + w2 * screen[2][2];
+					if (z < depth[py * size + px])
+					{
+						depth[py * size + px] = z;
+						statistics.shaded++;
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < size * size; i++)
+			statistics.covered += depth[i] < 1e30f;
+	}
+
+	statistics.overdraw = statistics.covered > 0 ? (float)statistics.shaded / statistics.covered : 0.0f;
+	return statistics;
+}
@@ -0,0 +1,60 @@
+/*---Orders the triangles and vertices of an indexed triangle list for the GPU. optimizeVertexCache follows Forsyth's
+linear speed vertex cache optimisation, so the triangles that share vertices are drawn close together and the vertex
+shader runs less often. optimizeOverdraw then splits that order into clusters where the cache starts again and draws the
+clusters facing out of the mesh first, so fewer hidden fragments are shaded, at the cost of a few more misses.
+optimizeVertexFetch renumbers the vertices in the order the triangles first use them, so the vertex fetch reads the
+buffer front to back. The analyze functions measure the results on the CPU: a FIFO vertex cache as the GPU has, the
+cache lines the fetch reads, and the fragments shaded when the mesh is rasterised along each axis.---*/
+
+#ifndef _MESH_OPTIMIZER_H
+#define _MESH_OPTIMIZER_H
+
+#include <vector>
+
+struct VertexCacheStatistics
+{
+	int transformed;	// vertices the cache missed, each runs the vertex shader
+	float acmr;			// average cache miss ratio, transformed vertices per triangle, 0.5 at best on a large mesh
+	float atvr;			// average transformed vertex ratio, transformed vertices per vertex the indices use, 1 at best
+};
+
+struct OverdrawStatistics
+{
+	long long covered;		// pixels the mesh covers, summed over the views
+	long long shaded;		// fragments that pass the depth test
+	float overdraw;			// shaded per covered, 1 at best
+};
+
+class MeshOptimizer
+{
+public:
+
+	// the cache Forsyth's scores are made for, a little larger than the caches of current GPUs
+	static const int SCORE_CACHE_SIZE = 32;
+
+	// reorders the triangles of indices, indexCount / 3 of them over vertexCount vertices, for the vertex cache
+	static void optimizeVertexCache(unsigned int* indices, int indexCount, int vertexCount);
+
+	// reorders the clusters of triangles in a vertex cache order so the ones facing out are drawn first. A cluster is
+	// only split where the miss ratio stays below threshold times the one of the whole run, 1.05 lets it grow by 5%.
+	// positions holds 3 floats every stride floats.
+	static void optimizeOverdraw(unsigned int* indices, int indexCount, const float* positions, int stride, int vertexCount, float threshold);
+
+	// renumbers the vertices in the order the indices first use them, the vertices the indices never use go last.
+	// remap[v] is the new number of vertex v, vertex data moves with it. Returns the number of vertices used.
+	static int optimizeVertexFetch(unsigned int* indices, int indexCount, int vertexCount, std::vector<unsigned int>& remap);
+
+	// the triangles of indices drawn through a FIFO cache of cacheSize vertices. The triangles are indexCount / 3 unless
+	// triangleCount is given, for a strip.
+	static VertexCacheStatistics analyzeVertexCache(const unsigned int* indices, int indexCount, int vertexCount, int cacheSize, int triangleCount = -1);
+
+	// the bytes the transformed vertices read through a cache of 16 KB in lines of 64 bytes, per byte of the vertices
+	// the indices use, 1 when every line is read once
+	static float analyzeVertexFetch(const unsigned int* indices, int indexCount, int vertexCount, int vertexSize);
+
+	// rasterises the triangles in order at 256 by 256 along both directions of each axis, with a depth test and no
+	// culling, like the models are drawn
+	static OverdrawStatistics analyzeOverdraw(const unsigned int* indices, int indexCount, const float* positions, int stride, int vertexCount);
+};
+
+#endif
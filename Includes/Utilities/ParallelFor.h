@@ -0,0 +1,53 @@
+#ifndef _PARALLEL_FOR_H
+#define _PARALLEL_FOR_H
+
+#include <thread>
+#include <vector>
+
+// splits the range [begin, end) into one contiguous block per hardware thread and calls body(i) for every index.
+// The body must only write to data owned by its own index.
+class ParallelFor
+{
+public:
+	template <class Body>
+	static void run(int begin, int end, Body body, int minimumPerThread = 64)
+	{
+		// asking the system for the thread count costs microseconds, more than a small loop
+		static const int hardwareThreads = std::thread::hardware_concurrency();
+
+		int count = end - begin;
+		int threadCount = hardwareThreads;
+
+		if (threadCount < 1)
+			threadCount = 1;
+		if (threadCount > count / minimumPerThread)
+			threadCount = count / minimumPerThread;
+
+		if (threadCount <= 1)
+		{
+			for (int i = begin; i < end; i++)
+				body(i);
+			return;
+		}
+
+		std::vector<std::thread> threads;
+		int blockSize = (count + threadCount - 1) / threadCount;
+
+		for (int t = 0; t < threadCount; t++)
+		{
+			int blockBegin = begin + t * blockSize;
+			int blockEnd = blockBegin + blockSize < end ? blockBegin + blockSize : end;
+
+			threads.push_back(std::thread([=]()
+			{
+				for (int i = blockBegin; i < blockEnd; i++)
+					body(i);
+			}));
+		}
+
+		for (int t = 0; t < threads.size(); t++)
+			threads[t].join();
+	}
+};
+
+#endif
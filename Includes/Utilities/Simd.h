@@ -0,0 +1,11 @@
+#ifndef _SIMD_H
+#define _SIMD_H
+
+// USE_SSE is defined when the compiler targets SSE, which every x64 build and the x86 builds with /arch:SSE or above do.
+// Code using it keeps a scalar loop for the other targets.
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#endif
@@ -0,0 +1,321 @@
+#include "VertexPacking.h"
+
+#include <cmath>
+#include <cstring>
+
+const float VertexPacking::MAX_HALF_TEXCOORD = 2.0f;
+
+PackedVertexLayout::PackedVertexLayout()
+{
+	quantizedPositions = false;
+	hasNormals = false;
+	hasTexCoords = false;
+	halfTexCoords = false;
+	stride = 3 * sizeof(float);
+	normalOffset = 0;
+	texCoordOffset = 0;
+
+	for (int a = 0; a < 3; a++)
+	{
+		positionScale[a] = 1.0f;
+		positionOffset[a] = 0.0f;
+	}
+}
+
+short VertexPacking::packSnorm16(float value)
+{
+	value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+	return (short)floor(value * 32767.0f + 0.5f);
+}
+
+float VertexPacking::unpackSnorm16(short value)
+{
+	float unpacked = value / 32767.0f;
+	return unpacked < -1.0f ? -1.0f : unpacked;
+}
+
+unsigned short VertexPacking::packHalf(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	unsigned int sign = (bits >> 16) & 0x8000;
+	int exponent = (int)((bits >> 23) & 0xff);
+	unsigned int mantissa = bits & 0x7fffff;
+
+	// infinity and nan
+	if (exponent == 0xff)
+		return (unsigned short)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+
+	int halfExponent = exponent - 127 + 15;
+	if (halfExponent >= 31)
+		return (unsigned short)(sign | 0x7c00);
+
+	// below the smallest normal half, the implicit bit is shifted into the mantissa
+	if (halfExponent <= 0)
+	{
+		if (halfExponent < -10)
+			return (unsigned short)sign;
+
+		mantissa |= 0x800000;
+		int shift = 14 - halfExponent;
+		unsigned int half = mantissa >> shift;
+		unsigned int rest = mantissa & ((1u << shift) - 1);
+		unsigned int halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+			half++;
+
+		return (unsigned short)(sign | half);
+	}
+
+	// rounded to nearest even, a carry out of the mantissa moves up the exponent and can reach infinity
+	unsigned int half = ((unsigned int)halfExponent << 10) | (mantissa >> 13);
+	unsigned int rest = mantissa & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+		half++;
+
+	return (unsigned short)(sign | half);
+}
+
+float VertexPacking::unpackHalf(unsigned short value)
+{
+	unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+	unsigned int exponent = (value >> 10) & 0x1f;
+	unsigned int mantissa = value & 0x3ff;
+
+	if (exponent == 0)
+	{
+		float denormal = ldexp((float)mantissa, -24);
+		return sign != 0 ? -denormal : denormal;
+	}
+
+	unsigned int bits;
+	if (exponent == 31)
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+
+	float unpacked;
+	memcpy(&unpacked, &bits, sizeof(unpacked));
+	return unpacked;
+}
+
+void VertexPacking::packOctahedral(const float normal[3], short packed[2])
+{
+	float sum = fabs(normal[0]) + fabs(normal[1]) + fabs(normal[2]);
+	if (sum == 0.0f)
+	{
+		packed[0] = packed[1] = 0;
+		return;
+	}
+
+	float u = normal[0] / sum;
+	float v = normal[1] / sum;
+	float length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+	// the lower half of the octahedron is folded over the diagonals
+	if (normal[2] < 0.0f)
+	{
+		float foldedU = (1.0f - fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		float foldedV = (1.0f - fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+		u = foldedU;
+		v = foldedV;
+	}
+
+	// compared by the distance to the normal, the dot product is 1 in float for all four
+	float bestDistance = 8.0f;
+	float lowU = floor(u * 32767.0f);
+	float lowV = floor(v * 32767.0f);
+	for (int i = 0; i < 4; i++)
+	{
+		float candidateU = lowU + (i & 1);
+		float candidateV = lowV + (i >> 1);
+		if (candidateU > 32767.0f || candidateV > 32767.0f)
+			continue;
+
+		short candidate[2] = { (short)candidateU, (short)candidateV };
+		float decoded[3];
+		unpackOctahedral(candidate, decoded);
+
+		float distance = 0.0f;
+		for (int a = 0; a < 3; a++)
+			distance += (decoded[a] - normal[a] / length) * (decoded[a] - normal[a] / length);
+
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			packed[0] = candidate[0];
+			packed[1] = candidate[1];
+		}
+	}
+}
+
+void VertexPacking::unpackOctahedral(const short packed[2], float normal[3])
+{
+	float u = unpackSnorm16(packed[0]);
+	float v = unpackSnorm16(packed[1]);
+	float z = 1.0f - fabs(u) - fabs(v);
+
+	if (z < 0.0f)
+	{
+		float foldedU = (1.0f - fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		float foldedV = (1.0f - fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+		u = foldedU;
+		v = foldedV;
+	}
+
+	float length = sqrt(u * u + v * v + z * z);
+	normal[0] = u / length;
+	normal[1] = v / length;
+	normal[2] = z / length;
+}
+
+PackedVertexLayout VertexPacking::chooseLayout(const float* positions, const float* texCoords, int count, bool hasNormals, float maxPositionError)
+{
+	PackedVertexLayout layout;
+	layout.hasNormals = hasNormals;
+	layout.hasTexCoords = texCoords != NULL;
+
+	if (count > 0)
+	{
+		float minimum[3], maximum[3];
+		for (int a = 0; a < 3; a++)
+			minimum[a] = maximum[a] = positions[a];
+
+		for (int v = 1; v < count; v++)
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				minimum[a] = positions[v * 3 + a] < minimum[a] ? positions[v * 3 + a] : minimum[a];
+				maximum[a] = positions[v * 3 + a] > maximum[a] ? positions[v * 3 + a] : maximum[a];
+			}
+		}
+
+		PackedVertexLayout quantized = layout;
+		quantized.quantizedPositions = true;
+		for (int a = 0; a < 3; a++)
+		{
+			quantized.positionScale[a] = (maximum[a] - minimum[a]) / 2.0f / 32767.0f;
+			quantized.positionOffset[a] = (maximum[a] + minimum[a]) / 2.0f;
+		}
+
+		if (positionError(quantized) <= maxPositionError)
+			layout = quantized;
+	}
+
+	layout.halfTexCoords = layout.hasTexCoords;
+	for (int i = 0; layout.hasTexCoords && i < count * 2; i++)
+	{
+		if (fabs(texCoords[i]) > MAX_HALF_TEXCOORD)
+			layout.halfTexCoords = false;
+	}
+
+	layout.stride = layout.quantizedPositions ? 4 * sizeof(short) : 3 * sizeof(float);
+	if (layout.hasNormals)
+	{
+		layout.normalOffset = layout.stride;
+		layout.stride += 2 * sizeof(short);
+	}
+	if (layout.hasTexCoords)
+	{
+		layout.texCoordOffset = layout.stride;
+		layout.stride += layout.halfTexCoords ? 2 * sizeof(unsigned short) : 2 * sizeof(float);
+	}
+
+	return layout;
+}
+
+float VertexPacking::positionError(const PackedVertexLayout& layout)
+{
+	if (!layout.quantizedPositions)
+		return 0.0f;
+
+	// half a step, and the rounding of the scale and offset in the decoding
+	float error = 0.0f;
+	for (int a = 0; a < 3; a++)
+	{
+		float axisError = layout.positionScale[a] / 2.0f + (fabs(layout.positionOffset[a]) + layout.positionScale[a] * 32767.0f) * 2.0f * 1.2e-7f;
+		error = axisError > error ? axisError : error;
+	}
+
+	return error;
+}
+
+void VertexPacking::pack(const PackedVertexLayout& layout, const float* positions, const float* normals, const float* texCoords, int count, std::vector<unsigned char>& vertices)
+{
+	vertices.assign((size_t)count * layout.stride, 0);
+
+	for (int v = 0; v < count; v++)
+	{
+		unsigned char* vertex = &vertices[(size_t)v * layout.stride];
+
+		if (layout.quantizedPositions)
+		{
+			short position[4] = { 0, 0, 0, 0 };
+			for (int a = 0; a < 3; a++)
+			{
+				float scaled = layout.positionScale[a] > 0.0f ? (positions[v * 3 + a] - layout.positionOffset[a]) / layout.positionScale[a] : 0.0f;
+				scaled = scaled < -32767.0f ? -32767.0f : (scaled > 32767.0f ? 32767.0f : scaled);
+				position[a] = (short)floor(scaled + 0.5f);
+			}
+			memcpy(vertex, position, sizeof(position));
+		}
+		else
+		{
+			memcpy(vertex, &positions[v * 3], 3 * sizeof(float));
+		}
+
+		if (layout.hasNormals)
+		{
+			short normal[2];
+			packOctahedral(&normals[v * 3], normal);
+			memcpy(vertex + layout.normalOffset, normal, sizeof(normal));
+		}
+
+		if (layout.hasTexCoords && layout.halfTexCoords)
+		{
+			unsigned short texCoord[2] = { packHalf(texCoords[v * 2]), packHalf(texCoords[v * 2 + 1]) };
+			memcpy(vertex + layout.texCoordOffset, texCoord, sizeof(texCoord));
+		}
+		else if (layout.hasTexCoords)
+		{
+			memcpy(vertex + layout.texCoordOffset, &texCoords[v * 2], 2 * sizeof(float));
+		}
+	}
+}
+
+void VertexPacking::unpack(const PackedVertexLayout& layout, const unsigned char* vertices, int v, float position[3], float normal[3], float texCoord[2])
+{
+	const unsigned char* vertex = vertices + (size_t)v * layout.stride;
+
+	if (layout.quantizedPositions)
+	{
+		short packed[4];
+		memcpy(packed, vertex, sizeof(packed));
+		for (int a = 0; a < 3; a++)
+			position[a] = packed[a] * layout.positionScale[a] + layout.positionOffset[a];
+	}
+	else
+	{
+		memcpy(position, vertex, 3 * sizeof(float));
+	}
+
+	if (layout.hasNormals)
+	{
+		short packed[2];
+		memcpy(packed, vertex + layout.normalOffset, sizeof(packed));
+		unpackOctahedral(packed, normal);
+	}
+
+	if (layout.hasTexCoords && layout.halfTexCoords)
+	{
+		unsigned short packed[2];
+		memcpy(packed, vertex + layout.texCoordOffset, sizeof(packed));
+		texCoord[0] = unpackHalf(packed[0]);
+		texCoord[1] = unpackHalf(packed[1]);
+	}
+	else if (layout.hasTexCoords)
+	{
+		memcpy(texCoord, vertex + layout.texCoordOffset, 2 * sizeof(float));
+	}
+}
@@ -0,0 +1,60 @@
+/*---Packs the vertex lists of a mesh into one interleaved buffer with smaller attributes. Positions are 16 bit signed
+integers in the bounds of the mesh when that keeps them within the error the caller allows, otherwise floats. Normals are
+two 16 bit integers of the octahedral map of the unit sphere and texture coordinates are half floats while they stay
+small. The integers are read by the shaders unnormalised and scaled there, so the decoding does not depend on how the
+driver converts normalised shorts. The unpack functions decode on the CPU exactly as the GLSL files do.---*/
+
+#ifndef _VERTEX_PACKING_H
+#define _VERTEX_PACKING_H
+
+#include <vector>
+
+// where the attributes of an interleaved vertex are
+struct PackedVertexLayout
+{
+	bool quantizedPositions;	// 4 shorts, the 4th 0 for the alignment, or 3 floats
+	bool hasNormals;			// 2 shorts
+	bool hasTexCoords;
+	bool halfTexCoords;			// 2 halves, or 2 floats
+	int stride;
+	int normalOffset, texCoordOffset;
+
+	// the position in the mesh is the stored one times the scale plus the offset, the PositionScale and PositionOffset
+	// uniforms of the shaders
+	float positionScale[3];
+	float positionOffset[3];
+
+	PackedVertexLayout();
+};
+
+class VertexPacking
+{
+public:
+
+	// texture coordinates further than this from 0 are kept as floats, a half has steps of 1/2048 below 2
+	static const float MAX_HALF_TEXCOORD;
+
+	static short packSnorm16(float value);
+	static float unpackSnorm16(short value);
+	static unsigned short packHalf(float value);
+	static float unpackHalf(unsigned short value);
+
+	// the point of the octahedral map nearest to the unit normal, of the four the rounding can give
+	static void packOctahedral(const float normal[3], short packed[2]);
+	static void unpackOctahedral(const short packed[2], float normal[3]);
+
+	// the layout of count vertices of 3 floats per position and 2 per texture coordinate, texCoords may be NULL. The
+	// positions are quantized when no position moves more than maxPositionError.
+	static PackedVertexLayout chooseLayout(const float* positions, const float* texCoords, int count, bool hasNormals, float maxPositionError);
+
+	// the largest distance a position moves along an axis when quantized in the bounds of layout
+	static float positionError(const PackedVertexLayout& layout);
+
+	// normals and texCoords may be NULL when the layout has none
+	static void pack(const PackedVertexLayout& layout, const float* positions, const float* normals, const float* texCoords, int count, std::vector<unsigned char>& vertices);
+
+	// vertex v of the packed vertices, normal and texCoord are left alone when the layout has none
+	static void unpack(const PackedVertexLayout& layout, const unsigned char* vertices, int v, float position[3], float normal[3], float texCoord[2]);
+};
+
+#endif
@@ -1,5 +1,4 @@
 #include "kochSnowflake.h"
-#include <Shaders\Shader.h>
 #include <iostream>
 #include <sstream>
 
@@ -69,7 +68,7 @@ void KochSnowflake::constructGeometryRounded(unsigned int edgeLength, unsigned i
 	for (int i = 0; i < 5; i++) 
 	{
 
-		angle = (FLOAT)(60 - i*30);
+		angle = (float)(60 - i*30);
 		rotMat = glm::mat4(1.0);
 
 		rotMat = glm::rotate(rotMat, angle , glm::vec3(0.0f, 1.0f, 0.0f)); // creating a rotation matrix
@@ -94,13 +93,14 @@ void KochSnowflake::constructGeometryRounded(unsigned int edgeLength, unsigned i
 	
 	for (int i = 0; i < vertexQuantity; i++)
 		{
+			cornerOffsets.push_back(roundCornerGeometry.size());
 		
 			if (i == 0) { angleAndCornerType = getAngleAndCornerType(verts[verts.size() - 1], verts[i], verts[i + 1]); }
 			else if (i == vertexQuantity - 1) { angleAndCornerType = getAngleAndCornerType(verts[i - 1], verts[i], verts[0]); }
 			else angleAndCornerType = getAngleAndCornerType(verts[i - 1], verts[i], verts[i+1]);
 
 
-			switch ((INT)angleAndCornerType.y) {
+			switch ((int)angleAndCornerType.y) {
 			case 60: // corner of 60 degrees angle			
 				rotMat = glm::mat4(1.0);
 				rotMat = glm::rotate(rotMat, angleAndCornerType.x, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -125,6 +125,8 @@ void KochSnowflake::constructGeometryRounded(unsigned int edgeLength, unsigned i
 			break;
 		}
 	}
+	cornerOffsets.push_back(roundCornerGeometry.size());
+	cornerVerts = verts;
 	verts = roundCornerGeometry;
  //----------------------------------------------------------------------------------------------------------------------------------------
 }
@@ -171,7 +173,7 @@ glm::vec2 KochSnowflake::getAngleAndCornerType(const glm::vec3& a, const glm::ve
 	bd = glm::normalize(-bd);
 
 	float angle;
-	int cornerType = (INT) glm::angle(ba, bc); // 60 or 120 degree angle corner
+	int cornerType = (int) glm::angle(ba, bc); // 60 or 120 degree angle corner
 	
 	// corner types approximation to 60 or 120 degrees
 	if (30 < cornerType && cornerType < 90) { cornerType = 60; }
@@ -182,51 +184,3 @@ glm::vec2 KochSnowflake::getAngleAndCornerType(const glm::vec3& a, const glm::ve
 
 	return glm::vec2(angle, cornerType);
 }
-
-void KochSnowflake::createBuffers(Shader* myShader)
-{
-	// VAO allocation
-	glGenVertexArrays(1, &m_vaoID);
-
-	// First VAO setup
-	glBindVertexArray(m_vaoID);
-	glGenBuffers(2, m_vboID);
-
-	float* v = new float[verts.size() * 3];
-	for (int i = 0; i < verts.size(); i++)
-	{
-		v[i * 3] = verts[i].x;
-		v[i * 3 + 1] = verts[i].y;
-		v[i * 3 + 2] = verts[i].z;
-	}
-	//initialises data storage of vertex buffer object
-	glBindBuffer(GL_ARRAY_BUFFER, m_vboID[0]);
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * 3 * sizeof(GLfloat), v, GL_STATIC_DRAW);
-	GLint vertexLocation = glGetAttribLocation(myShader->handle(), "in_Position");
-	glVertexAttribPointer(vertexLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(vertexLocation);
-
-	float* c = new float[verts.size() * 3];
-	for (int i = 0; i < verts.size(); i++)
-	{
-		c[i * 3] = 0.0;
-		c[i * 3 + 1] = 0.0;
-		c[i * 3 + 2] = 0.0;
-	}
-	glBindBuffer(GL_ARRAY_BUFFER, m_vboID[1]);
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * 3 * sizeof(GLfloat), c, GL_STATIC_DRAW);
-	GLint colsLocation = glGetAttribLocation(myShader->handle(), "in_Color");
-	glVertexAttribPointer(colsLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(colsLocation);
-	delete[] v;
-	delete[] c;
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
-
-void KochSnowflake::render()
-{
-	//draw objects
-	glPointSize(3.0f);
-	glBindVertexArray(m_vaoID);		// select VAO
-	glDrawArrays(GL_LINE_LOOP, 0, verts.size());
-}
\ No newline at end of file
@@ -4,12 +4,11 @@
 #ifndef _FLAKE_H
 #define _FLAKE_H
 
-#include <gl\glew.h>
-#include <glm\glm.hpp>
-#include <glm\gtc\matrix_transform.hpp>
-#include <glm\gtc\type_ptr.hpp>
-#include <glm\gtc\matrix_inverse.hpp>
-#include <glm\gtx\vector_angle.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtx/vector_angle.hpp>
 
 #include <vector>
 #include <iostream>
@@ -31,6 +30,8 @@ public:
 	std::vector<glm::vec3> verts; // vertex of the fractal
 	std::vector<glm::vec3> pentadaOfPoints; // holds 5 points for rounding the corners of a fractal
 	std::vector<glm::vec3> triadaOfPoints; // holds 3 points for rounding the corners of a fractal
+	std::vector<glm::vec3> cornerVerts; // corners of the fractal before rounding, in the order of the curve
+	std::vector<unsigned int> cornerOffsets; // index in verts of the first rounding point of each corner, plus verts.size() at the end
 	
 	// Constructs the geometry of a fractal of given dimension. EdgeLength is the length of the edge of the triangle of a 0 dimension fractal.
 	void constructGeometry(unsigned int edgeLength, unsigned int dimension);
@@ -52,4 +53,4 @@ public:
 	void createBuffers(Shader* myShader);
 };
 
-#endif _FLAKE_H
+#endif
@@ -0,0 +1,51 @@
+#include <gl\glew.h>
+#include "kochSnowflake.h"
+#include <Shaders\Shader.h>
+
+void KochSnowflake::createBuffers(Shader* myShader)
+{
+	// VAO allocation
+	glGenVertexArrays(1, &m_vaoID);
+
+	// First VAO setup
+	glBindVertexArray(m_vaoID);
+	glGenBuffers(2, m_vboID);
+
+	float* v = new float[verts.size() * 3];
+	for (int i = 0; i < verts.size(); i++)
+	{
+		v[i * 3] = verts[i].x;
+		v[i * 3 + 1] = verts[i].y;
+		v[i * 3 + 2] = verts[i].z;
+	}
+	//initialises data storage of vertex buffer object
+	glBindBuffer(GL_ARRAY_BUFFER, m_vboID[0]);
+	glBufferData(GL_ARRAY_BUFFER, verts.size() * 3 * sizeof(GLfloat), v, GL_STATIC_DRAW);
+	GLint vertexLocation = glGetAttribLocation(myShader->handle(), "in_Position");
+	glVertexAttribPointer(vertexLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glEnableVertexAttribArray(vertexLocation);
+
+	float* c = new float[verts.size() * 3];
+	for (int i = 0; i < verts.size(); i++)
+	{
+		c[i * 3] = 0.0;
+		c[i * 3 + 1] = 0.0;
+		c[i * 3 + 2] = 0.0;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_vboID[1]);
+	glBufferData(GL_ARRAY_BUFFER, verts.size() * 3 * sizeof(GLfloat), c, GL_STATIC_DRAW);
+	GLint colsLocation = glGetAttribLocation(myShader->handle(), "in_Color");
+	glVertexAttribPointer(colsLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glEnableVertexAttribArray(colsLocation);
+	delete[] v;
+	delete[] c;
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void KochSnowflake::render()
+{
+	//draw objects
+	glPointSize(3.0f);
+	glBindVertexArray(m_vaoID);		// select VAO
+	glDrawArrays(GL_LINE_LOOP, 0, verts.size());
+}
@@ -2,6 +2,8 @@
 
 #include <windows.h>			// Header File For Windows
 #include <vector>
+#include <string>
+#include <random>
 #include <gl\glew.h>
 #include <gl\wglew.h>
 
@@ -10,6 +12,8 @@
 
 Shader* ObjectShader;			//shader object
 Shader* TubeShader;
+Shader* ProjectileShader;		//draws all the missiles in one instanced call
+Shader* ObstacleShader;			//draws the visible obstacles in one instanced call
 
 #include <glm\glm.hpp>
 #include <glm\gtc\matrix_transform.hpp>
@@ -21,9 +25,17 @@ Shader* TubeShader;
 
 #include <tube.h>
 #include <kochSnowflake.h>
+#include <Simulation/Simulation.h>
+#include <Simulation/InputRecording.h>
+#include <Projectiles/ProjectileRenderer.h>
+#include <Obstacles/ObstacleTransforms.h>
+#include <Obstacles/ObstacleRenderer.h>
+#include <Benchmarks/Benchmarks.h>
 
 #include <Time/FPS.h>			// FPS class
+#include <Time/SimulationClock.h>
 Fps fps;
+SimulationClock simulationClock(1.0 / 120.0);	// the game is simulated 120 times a second
 
 #include <Text/FreeType.h>
 #include <Utilities/MatrixRoutines.h>
@@ -37,7 +49,7 @@ float rad2deg = 180.0f / Pi;	//convertion from radians to degrees
 //-----------------
 
 //---Tube creation---
-Tube testTube;
+Simulation game;				// the tube, the player, the missile and the obstacles
 KochSnowflake flake;
 
 float radiusOfSegment = 120.0f;
@@ -51,7 +63,7 @@ int edgePartition = 30;
 #include <3DStruct\threeDModel.h>
 #include <Obj\OBJLoader.h>
 
-ThreeDModel serfer, ball, obstacle, obstacle_n;
+ThreeDModel serfer, ball, obstacle;
 OBJLoader objLoader;
 //------------------
 
@@ -62,8 +74,6 @@ glm::mat4 viewingMatrix;		// camera matrix
 
 glm::mat3 normalMatrix;
 
-glm::vec4 View1OFFe;
-glm::vec4 View1OFFt;
 glm::vec3 View2e;
 glm::vec3 View2t;
 glm::vec3 View2n;
@@ -92,40 +102,45 @@ int screenWidth = 900, screenHeight = 900;
 bool keys[256];
 
 glm::quat q;
-glm::vec3 playerPosition;
-glm::mat4 playerDirectionMat = glm::mat4(1.0f);
-glm::mat4 playerTurn;
-glm::mat4 playerTransformations;
 glm::mat4 cameraRotation;		// rotation about the local axis
-glm::vec3 cameraDir;			// direction of camera
-glm::vec3 cameraNorm;			// camera normal
-glm::vec3 cameraTarget;
-glm::mat4 fireDirectonMat;
-glm::vec4 firePoint;
 
-vector<glm::vec3> obstaclePoints;
-vector<glm::vec3> obstacleDirections;
-vector<float> obstacleRotationSpeed;
-glm::vec4 ObstaclePositionNow;
+SimulationInput input;			// keys held since the last tick
 
-bool fire;
-int hit_count;
-
-float speed_delta;
-float speed = 3.0f;
-float spin_delta;
-float spin = 1.0f;
+//---Recording and replay---
+InputRecording recording;		// the keys of every tick, with the settings and the seed of the game
+std::string recordPath;			// -record file, the game is saved to it on exit
+std::string replayPath;			// -replay file, the game plays the ticks of the file instead of the keys
+std::string tracePath;			// -trace file, the time of every tick is saved to it on exit
 
 float Xpos = 0.0f;
 float Ypos = 0.0f;
 float Zpos = 0.0f;
-float speedZ = 0.0f;
 
 glm::vec3 PPos;				// movment on XYZ
 glm::vec3 PDir;				// direction of plane
 glm::vec3 PNorm;			// plane normal
 //---------------------
 
+//--- Drawn state -----
+// the simulation state of one tick, a frame is drawn between the last two ticks
+struct TickState
+{
+	glm::vec3 playerPosition;
+	glm::quat playerOrientation;
+	glm::vec3 cameraTarget;
+};
+TickState previousState, currentState;
+
+glm::vec3 drawPlayerPosition;
+glm::mat4 drawPlayerDirectionMat;
+glm::vec3 drawCameraTarget;
+float drawAlpha = 1.0f;			// how far the frame is from the previous tick to the current one
+
+ProjectileRenderer projectileRenderer;
+ObstacleTransforms obstacleTransforms;	// model matrices of the obstacles in view
+ObstacleRenderer obstacleRenderer;
+//---------------------
+
 ////----- Anim -----
 //Md5Model *model;
 //Md5Model *model2;
@@ -139,9 +154,13 @@ glm::vec3 PNorm;			// plane normal
 //OPENGL FUNCTION PROTOTYPES
 void init();					//called in winmain when the program starts.
 void display();					//called in winmain to draw everything to the screen
+void setLighting(Shader* shader, float* lightPos);	//sets the view, light and material uniforms of a shader
 void reshape();					//called when the window is resized
 void processKeys();				//called in winmain to process keyboard input
 void update();					//called in winmain to update variables
+std::string commandLineValue(const char* cmdLine, const char* flag);	//the word after flag on the command line
+TickState captureState();		//the state drawn by display after update
+void interpolateState(float alpha);	//sets the drawn state between the previous and current tick
 void updateTransform(float xinc, float yinc, float zinc);
 void objectLoading(char *path, ThreeDModel& model, Shader *shader);
 //void initialiseModel();
@@ -163,39 +182,78 @@ void init()
 		cout << "failed to load shader" << endl;
 	}
 
+	ProjectileShader = new Shader;
+	if (!ProjectileShader->load("Projectile Shader", "GLSL_Files/instancedTransformations.vert", "GLSL_Files/basicTransformations.frag"))
+	{
+		cout << "failed to load shader" << endl;
+	}
+
+	ObstacleShader = new Shader;
+	if (!ObstacleShader->load("Obstacle Shader", "GLSL_Files/instancedModelTransformations.vert", "GLSL_Files/basicTransformations.frag"))
+	{
+		cout << "failed to load shader" << endl;
+	}
+
 	TubeShader = new Shader;
 	if (!TubeShader->load("Tube Shader", "GLSL_Files/basic.vert", "GLSL_Files/basic.frag"))
 	{
 		cout << "failed to load shader" << endl;
 	}
 
+	// the models first, the missiles hit a box of the size of the obstacle model
+	glUseProgram(ObjectShader->handle());  // use the shader
+
+	glEnable(GL_TEXTURE_2D);
+
+	cout << " Loading models : " << endl;
+
+	objectLoading("Models/ss6.obj", serfer, ObjectShader);
+	objectLoading("Models/ball.obj", ball, ProjectileShader);
+	projectileRenderer.createBuffers(ball, ProjectileShader, game.projectiles.getCapacity());
+	objectLoading("Models/ball2.obj", obstacle, ObstacleShader);
+
 	cout << " Loading tube : " << endl;
 	cout << "  Radius Of Segment = " << radiusOfSegment << endl;
 	cout << "  Edge Length = " << edgeLength << endl;
 	cout << "  Dimention = " << dimention << endl;
 	cout << "  Vert In Segment = " << vertInSegment << endl;
 
-	testTube.constructGeometry(radiusOfSegment, edgeLength, dimention, vertInSegment);
-	testTube.createBuffers(TubeShader);
+	SimulationSettings settings;
+	settings.radiusOfSegment = radiusOfSegment;
+	settings.edgeLength = edgeLength;
+	settings.dimension = dimention;
+	settings.vertInSegment = vertInSegment;
+	settings.edgePartition = edgePartition;
+	settings.tickSeconds = simulationClock.getTick();
+	if (obstacle.theBBox.getLargestExtent() > 0.0f)
+		settings.obstacleHalfWidth = obstacle.theBBox.getLargestExtent() / 2.0f;
+
+	if (!replayPath.empty())
+	{
+		settings = recording.settings;	// the same tube and obstacles as the recorded game
+	}
+	else if (!recordPath.empty())
+	{
+		std::random_device device;
+		settings.seed = device();
+	}
+	recording.settings = settings;
+
+	game.timings.keepTrace = !tracePath.empty();
+	game.init(settings);
+	game.tube.createBuffers(TubeShader);
 
 	//flake.constructGeometryRounded(edgeLength, dimention, radiusOfSegment);
 	//flake.createBuffers(mySimpleShader);
 
-	float edgePart = edgeLength / edgePartition;
-	testTube.obstaclePositions(edgePart, obstaclePoints, obstacleDirections, obstacleRotationSpeed);
-
 	cout << " Tube loaded : " << endl;
 
 	glUseProgram(ObjectShader->handle());  // use the shader
-
-	glEnable(GL_TEXTURE_2D);
-
-	cout << " Loading models : " << endl;
-
-	objectLoading("Models/ss6.obj", serfer, ObjectShader);
-	objectLoading("Models/ball.obj", ball, ObjectShader);
-	objectLoading("Models/ball2.obj", obstacle_n, ObjectShader);
-	objectLoading("Models/ball2.obj", obstacle, ObjectShader);
+	std::vector<glm::vec3> obstaclePoints, obstacleDirections;
+	std::vector<float> obstacleSpeeds;
+	game.obstacles.copyTo(obstaclePoints, obstacleDirections, obstacleSpeeds);
+	obstacleTransforms.setObstacles(obstaclePoints, obstacleDirections, obstacleSpeeds, radiusOfSegment * 0.7f, obstacle.theBBox.getLargestExtent());
+	obstacleRenderer.createBuffers(obstacle, ObstacleShader, game.obstacles.getCount());
 
 	glUseProgram(0); //turn off the current shader
 
@@ -205,8 +263,6 @@ void init()
 
 	//initialiseModel();
 
-	playerPosition = testTube.flake.verts[0];
-
 	float Xc = edgeLength / 2;
 	float Yc = 0.0f;
 	float Zc = -(glm::sqrt(3.0f) / 6) * edgeLength;
@@ -217,7 +273,6 @@ void init()
 
 	View1 = true;
 	View2 = false;
-	fire = false;
 }
 
 void objectLoading(char *path, ThreeDModel& model, Shader *shader)
@@ -230,10 +285,20 @@ void objectLoading(char *path, ThreeDModel& model, Shader *shader)
 		//back so that the centre is on the origin.
 		model.calcCentrePoint();
 		model.centreOnZero();
-		model.calcVertNormalsUsingOctree();	//the method will construct the octree if it hasn't already been created.
-												//turn on VBO by setting useVBO to true in threeDmodel.cpp default constructor - only permitted on 8 series cards and higher
+
+		//the octree and the vertex normals are baked next to the model on the first run and mapped back on the next ones
+		string bakePath = string(path) + ".octree";
+		if (!model.loadBakedOctree(bakePath.c_str()))
+		{
+			model.calcVertNormalsUsingOctree();	//the method will construct the octree if it hasn't already been created.
+			if (!model.bakeOctree(bakePath.c_str()))
+				cout << " could not bake the octree to " << bakePath << endl;
+		}
+		//turn on VBO by setting useVBO to true in threeDmodel.cpp default constructor - only permitted on 8 series cards and higher
 		model.initDrawElements();
+		model.optimizeDrawElements();
 		model.initVBO(shader);
+		//the octree keeps its own copy of the triangles, so collisionBetweenPoint still works after the delete
 		model.deleteVertexFaceData();
 	}
 	else
@@ -315,6 +380,22 @@ std::vector<glm::vec3> getPointsForSegmentPositioning(const glm::vec3& startPoin
 	return points;
 }
 
+// the view matrix, light and material uniforms shared by the object shaders, the shader must be in use
+void setLighting(Shader* shader, float* lightPos)
+{
+	glUniformMatrix4fv(glGetUniformLocation(shader->handle(), "ViewMatrix"), 1, GL_FALSE, &viewingMatrix[0][0]);
+
+	glUniform4fv(glGetUniformLocation(shader->handle(), "LightPos"), 1, lightPos);
+	glUniform4fv(glGetUniformLocation(shader->handle(), "light_ambient"), 1, Light_Ambient_And_Diffuse);
+	glUniform4fv(glGetUniformLocation(shader->handle(), "light_diffuse"), 1, Light_Ambient_And_Diffuse);
+	glUniform4fv(glGetUniformLocation(shader->handle(), "light_specular"), 1, Light_Specular);
+
+	glUniform4fv(glGetUniformLocation(shader->handle(), "material_ambient"), 1, Material_Ambient);
+	glUniform4fv(glGetUniformLocation(shader->handle(), "material_diffuse"), 1, Material_Diffuse);
+	glUniform4fv(glGetUniformLocation(shader->handle(), "material_specular"), 1, Material_Specular);
+	glUniform1f(glGetUniformLocation(shader->handle(), "material_shininess"), Material_Shininess);
+}
+
 void display()									
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -326,9 +407,10 @@ void display()
 	GLuint matLocation = glGetUniformLocation(ObjectShader->handle(), "ProjectionMatrix");
 	glUniformMatrix4fv(matLocation, 1, GL_FALSE, &ProjectionMatrixMain[0][0]);
 
-	glm::vec3 View1eye = glm::vec3(cameraTarget.x + View1OFFe.x, cameraTarget.y + View1OFFe.y, cameraTarget.z + View1OFFe.z);
-	glm::vec3 View1target = cameraTarget;
-	glm::vec3 View1normal = cameraNorm;
+	glm::vec4 View1offset = drawPlayerDirectionMat * glm::vec4(0, 0, radiusOfSegment*1.5, 1);
+	glm::vec3 View1eye = glm::vec3(drawCameraTarget.x + View1offset.x, drawCameraTarget.y + View1offset.y, drawCameraTarget.z + View1offset.z);
+	glm::vec3 View1target = drawCameraTarget;
+	glm::vec3 View1normal = glm::vec3(drawPlayerDirectionMat[1][0], drawPlayerDirectionMat[1][1], drawPlayerDirectionMat[1][2]);
 
 	if (View1)
 	{
@@ -341,19 +423,9 @@ void display()
 		ProjectionMatrixMain = glm::perspective(60.0f, (GLfloat)screenWidth / (GLfloat)screenHeight, 1.0f, -(glm::sqrt(3.0f) / 6) * edgeLength - radiusOfSegment);
 	}
 
-	glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ViewMatrix"), 1, GL_FALSE, &viewingMatrix[0][0]);
-
-	float LightPos [4] = {playerPosition.x, playerPosition.y + 50, playerPosition.z, 0.0};
+	float LightPos [4] = {drawPlayerPosition.x, drawPlayerPosition.y + 50, drawPlayerPosition.z, 0.0};
 
-	glUniform4fv(glGetUniformLocation(ObjectShader->handle(), "LightPos"), 1, LightPos);
-	glUniform4fv(glGetUniformLocation(ObjectShader->handle(), "light_ambient"), 1, Light_Ambient_And_Diffuse);
-	glUniform4fv(glGetUniformLocation(ObjectShader->handle(), "light_diffuse"), 1, Light_Ambient_And_Diffuse);
-	glUniform4fv(glGetUniformLocation(ObjectShader->handle(), "light_specular"), 1, Light_Specular);
-
-	glUniform4fv(glGetUniformLocation(ObjectShader->handle(), "material_ambient"), 1, Material_Ambient);
-	glUniform4fv(glGetUniformLocation(ObjectShader->handle(), "material_diffuse"), 1, Material_Diffuse);
-	glUniform4fv(glGetUniformLocation(ObjectShader->handle(), "material_specular"), 1, Material_Specular);
-	glUniform1f(glGetUniformLocation(ObjectShader->handle(), "material_shininess"), Material_Shininess);
+	setLighting(ObjectShader, LightPos);
 	glUseProgram(0); //turn off the current shader
 
 	//DRAW THE MODEL
@@ -361,15 +433,15 @@ void display()
 	glm::mat4 TubeMat = viewingMatrix;
 	glUniformMatrix4fv(glGetUniformLocation(TubeShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &TubeMat[0][0]);
 	glUniformMatrix4fv(glGetUniformLocation(TubeShader->handle(), "ProjectionMatrix"), 1, GL_FALSE, &ProjectionMatrixMain[0][0]);
-	testTube.render();
+	game.tube.render();
 	//flake.render();
 	glUseProgram(0); //turn off the current shader
 	//--------------
 
 	// PLAYER
 	glUseProgram(ObjectShader->handle());  // use the shader
-	glm::mat4 Player = glm::translate(viewingMatrix, glm::vec3(playerPosition.x, playerPosition.y, playerPosition.z));		// movement on XYZ
-	Player = Player * playerDirectionMat;
+	glm::mat4 Player = glm::translate(viewingMatrix, drawPlayerPosition);		// movement on XYZ
+	Player = Player * drawPlayerDirectionMat;
 	Player = glm::translate(Player, glm::vec3(0.0f, -radiusOfSegment*0.7, 0.0f));
 	normalMatrix = glm::inverseTranspose(glm::mat3(Player));
 	glUniformMatrix3fv(glGetUniformLocation(ObjectShader->handle(), "NormalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
@@ -381,63 +453,34 @@ void display()
 	//---------
 
 	// PROJ
-	if (fire)
+	if (game.projectiles.getActiveCount() > 0)
 	{
-		glUseProgram(ObjectShader->handle());  // use the shader
-		glm::mat4 Ball = glm::translate(viewingMatrix, glm::vec3(firePoint.x, firePoint.y, firePoint.z));		// movement on XYZ
-		normalMatrix = glm::inverseTranspose(glm::mat3(Ball));
-		glUniformMatrix3fv(glGetUniformLocation(ObjectShader->handle(), "NormalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &Ball[0][0]);
-		ball.drawElementsUsingVBO(ObjectShader);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ProjectionMatrix"), 1, GL_FALSE, &ProjectionMatrixMain[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &Ball[0][0]);
+		// every missile in one instanced draw, the model view matrix is the viewing matrix and each instance is moved by its position
+		glUseProgram(ProjectileShader->handle());  // use the shader
+		setLighting(ProjectileShader, LightPos);
+		normalMatrix = glm::inverseTranspose(glm::mat3(viewingMatrix));
+		glUniformMatrix3fv(glGetUniformLocation(ProjectileShader->handle(), "NormalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(ProjectileShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &viewingMatrix[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(ProjectileShader->handle(), "ProjectionMatrix"), 1, GL_FALSE, &ProjectionMatrixMain[0][0]);
+		projectileRenderer.render(game.projectiles, ball, ProjectileShader, -(1.0f - drawAlpha) * game.getTimeStep());
 		glUseProgram(0); //turn off the current shader
 	}
 	//---------
 
 	// Obstacle object
-	if (!obstaclePoints.empty())
+	if (game.obstacles.getCount() > 0)
 	{
-		static int num, num_n;
-		static float spinO, spinO_n;
-
-		if (glm::length(obstaclePoints[num] - playerPosition) - speedZ < 10.0f)
-		{
-			num++;
-			if (num == obstaclePoints.size()) num = 0;
-			num_n = num + 1;
-			if (num_n == obstaclePoints.size()) num_n = 0;
-			spinO = spinO_n;
-		}
-
-		spinO += obstacleRotationSpeed[num];
-		spinO_n += obstacleRotationSpeed[num_n];
-		if (spinO > 360) spinO = 0;
-		if (spinO_n > 360) spinO_n = 0;
-
-
-		glUseProgram(ObjectShader->handle());  // use the shader
-		glm::mat4 Obstacle = glm::translate(viewingMatrix, obstaclePoints[num]);		// movement on XYZ
-		Obstacle = glm::rotate(Obstacle, spinO, obstacleDirections[num]);
-		Obstacle = glm::translate(Obstacle, glm::vec3(0.0f, -radiusOfSegment*0.7, 0.0f));
-		normalMatrix = glm::inverseTranspose(glm::mat3(Obstacle));
-		glUniformMatrix3fv(glGetUniformLocation(ObjectShader->handle(), "NormalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &Obstacle[0][0]);
-		obstacle.drawElementsUsingVBO(ObjectShader);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ProjectionMatrix"), 1, GL_FALSE, &ProjectionMatrixMain[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &Obstacle[0][0]);
-		glUseProgram(0); //turn off the current shader
-
-		glUseProgram(ObjectShader->handle());  // use the shader
-		glm::mat4 Obstacle_n = glm::translate(viewingMatrix, obstaclePoints[num_n]);		// movement on XYZ
-		Obstacle_n = glm::rotate(Obstacle_n, spinO_n, obstacleDirections[num_n]);
-		Obstacle_n = glm::translate(Obstacle_n, glm::vec3(0.0f, -radiusOfSegment*0.7, 0.0f));
-		normalMatrix = glm::inverseTranspose(glm::mat3(Obstacle));
-		glUniformMatrix3fv(glGetUniformLocation(ObjectShader->handle(), "NormalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &Obstacle_n[0][0]);
-		obstacle_n.drawElementsUsingVBO(ObjectShader);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ProjectionMatrix"), 1, GL_FALSE, &ProjectionMatrixMain[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(ObjectShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &Obstacle_n[0][0]);
+		// the obstacles in the frustum, spinning at the time between the last two ticks, in one instanced draw
+		obstacleTransforms.cull(ProjectionMatrixMain * viewingMatrix);
+		obstacleTransforms.build(game.getTime() - (1.0f - drawAlpha) * game.getTimeStep());
+
+		glUseProgram(ObstacleShader->handle());  // use the shader
+		setLighting(ObstacleShader, LightPos);
+		normalMatrix = glm::inverseTranspose(glm::mat3(viewingMatrix));
+		glUniformMatrix3fv(glGetUniformLocation(ObstacleShader->handle(), "NormalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(ObstacleShader->handle(), "ModelViewMatrix"), 1, GL_FALSE, &viewingMatrix[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(ObstacleShader->handle(), "ProjectionMatrix"), 1, GL_FALSE, &ProjectionMatrixMain[0][0]);
+		obstacleRenderer.render(obstacleTransforms, obstacle, ObstacleShader);
 		glUseProgram(0); //turn off the current shader
 	}
 	//-----------------
@@ -465,7 +508,8 @@ void display()
 	//font, x position, y position, string of text and a float
 	int FPS_NOW = fps.get_fps();
 	print(myfont, 20, screenHeight - 50, "FPS: %d", FPS_NOW);
-	print(myfont, screenWidth - 150, screenHeight - 50, "Hits: %d", hit_count);
+	print(myfont, screenWidth - 150, screenHeight - 50, "Hits: %d", game.hitCount);
+	print(myfont, screenWidth - 150, screenHeight - 80, "Missile hits: %d", game.missileHits);
 	glBindVertexArray(0); //unbind the vertex array object
 	glUseProgram(0); //turn off the current shader
 	// ----------------
@@ -486,31 +530,10 @@ void reshape(int width, int height)		// Resize the OpenGL window
 
 void processKeys()
 {
-	if (keys['D'])
-	{
-		Zpos = -spin_delta;
-	}
-	else if (keys['A'])
-	{
-		Zpos = spin_delta;
-	}
-	else
-	{
-		Zpos = 0;
-	}
+	input.turnRight = keys['D'];
+	input.turnLeft = keys['A'];
 	//-----
-	if (keys['W'])
-	{
-		speedZ = speed_delta;
-	}
-	else if (keys['S'])
-	{
-		speedZ = speed_delta;
-	}
-	else
-	{
-		speedZ = 0;
-	}
+	input.forward = keys['W'] || keys['S'];
 	////-----
 	//if (mouse_x < screenWidth / 3)
 	//{
@@ -620,13 +643,10 @@ void processKeys()
 
 	if (keys['F'])
 	{
-		fire = true;
+		input.fire = true;
 		keys['F'] = false;
 	}
-	if (keys['R'])
-	{
-		fire = false;
-	}
+	input.stopFire = keys['R'];
 
 	//updateTransform(Xpos, Ypos, Zpos);
 }
@@ -653,44 +673,55 @@ void updateTransform(float xinc, float yinc, float zinc)
 
 void update()
 {
-	fps.update();
-	float fps_now = fps.get_fps();
-	float frames_now = fps.get_frames();
-	speed_delta = speed * (1 / frames_now);
-	spin_delta = spin * (1 / frames_now);
+	if (!replayPath.empty())
+		input = recording.getInput(game.timings.ticks);
+	else if (!recordPath.empty())
+		recording.record(input);
 
-	testTube.playerPosition(playerPosition, cameraTarget, playerDirectionMat, playerTurn, speedZ, Zpos);
+	game.tick(input);
+	input.fire = false;		// one press fires one missile
+}
 
-	playerTransformations = glm::translate(glm::mat4(1.0), glm::vec3(playerPosition.x, playerPosition.y, playerPosition.z));
-	playerTransformations = playerTransformations * playerDirectionMat;
-	playerTransformations = glm::translate(playerTransformations, glm::vec3(0.0f, -radiusOfSegment*0.7, 0.0f));
+std::string commandLineValue(const char* cmdLine, const char* flag)
+{
+	const char* found = strstr(cmdLine, flag);
+	if (found == NULL)
+		return "";
 
-	cameraNorm = glm::vec3(playerDirectionMat[1][0], playerDirectionMat[1][1], playerDirectionMat[1][2]);
-	View1OFFe = playerDirectionMat * glm::vec4(0, 0, radiusOfSegment*1.5, 1);
-	View1OFFt = playerDirectionMat * glm::vec4(cameraTarget, 1);
+	const char* start = found + strlen(flag);
+	while (*start == ' ')
+		start++;
 
-	glm::vec4 front_coord(0, 0, -50, 1);
-	front_coord = playerTransformations * front_coord;
+	const char* end = start;
+	while (*end != ' ' && *end != '\0')
+		end++;
 
-	if (fire)
-	{
-		float speedR = speed_delta * 3;
-		firePoint += -speedR * glm::vec4(fireDirectonMat[2][0], fireDirectonMat[2][1], fireDirectonMat[2][2], fireDirectonMat[2][3]);
-	}
-	else
-	{
-		firePoint = front_coord;
-		fireDirectonMat = playerTransformations;
-	}
-	if (!testTube.collisionBetweenPoint(glm::vec3(firePoint.x, firePoint.y, firePoint.z), speed_delta * 3, 0, 3))
-	{
-		fire = false;
-	}
+	return std::string(start, end);
+}
 
-	//if (obstacle.collisionBetweenPoint(new Vector3d(front_coord.x, front_coord.y, front_coord.z), 50.0f))
-	//{
-	//	hit_count++;
-	//}
+TickState captureState()
+{
+	TickState state;
+	state.playerPosition = game.playerPosition;
+	state.playerOrientation = glm::quat_cast(game.playerDirectionMat);
+	state.cameraTarget = game.cameraTarget;
+
+	return state;
+}
+
+void interpolateState(float alpha)
+{
+	glm::quat from = previousState.playerOrientation;
+	glm::quat to = currentState.playerOrientation;
+
+	// q and -q are the same rotation, take the one that turns the short way
+	if (glm::dot(from, to) < 0.0f)
+		to = -to;
+
+	drawPlayerPosition = glm::mix(previousState.playerPosition, currentState.playerPosition, alpha);
+	drawPlayerDirectionMat = glm::toMat4(glm::slerp(from, to, alpha));
+	drawCameraTarget = glm::mix(previousState.cameraTarget, currentState.cameraTarget, alpha);
+	drawAlpha = alpha;
 }
 
 //void updateAnim(double deltaTime)
@@ -732,6 +763,16 @@ int WINAPI WinMain(	HINSTANCE	hInstance,			// Instance
 
 	RedirectIOToConsole();
 
+	recordPath = commandLineValue(lpCmdLine, "-record");
+	replayPath = commandLineValue(lpCmdLine, "-replay");
+	tracePath = commandLineValue(lpCmdLine, "-trace");
+
+	if (!replayPath.empty() && !recording.load(replayPath.c_str()))
+	{
+		cout << "failed to load recording " << replayPath << endl;
+		return 0;
+	}
+
 	//RECT desktop;
 	//// Get a handle to the desktop window
 	//const HWND hDesktop = GetDesktopWindow();
@@ -755,7 +796,20 @@ int WINAPI WinMain(	HINSTANCE	hInstance,			// Instance
 	//float elapsed_time = 0.0f;
 	//float elapsed_time_prev = 0.0f;
 
-	update();
+	if (strstr(lpCmdLine, "-bench") != NULL)
+	{
+		// print the CPU benchmarks to the console and quit. They run once the window is up as the OBJ loader makes the
+		// textures of the models, headless -bench 1 runs the ones without models on machines without a GPU.
+		Benchmarks::runAll(game.tube);
+		done = true;
+	}
+
+	if (replayPath.empty() || recording.getTickCount() > 0)
+		update();
+	currentState = captureState();
+	previousState = currentState;
+	interpolateState(0.0f);
+	simulationClock.reset();
 
 	while(!done)									// Loop That Runs While done=FALSE
 	{
@@ -780,8 +834,34 @@ int WINAPI WinMain(	HINSTANCE	hInstance,			// Instance
 				done = true;
 
 			processKeys();			//process keyboard
+
+			// the simulation runs in fixed ticks, the frame is drawn between the last two of them
+			int ticks = simulationClock.advance();
+			float alpha = simulationClock.alpha();
+
+			// a replay plays one tick a frame, so every tick of the recording is drawn however slow the frames are. It stops on
+			// the last tick of the recording like headless -replay, so the state hashes match.
+			if (!replayPath.empty())
+			{
+				ticks = 1;
+				alpha = 1.0f;
+				if (game.timings.ticks >= recording.getTickCount())
+				{
+					ticks = 0;
+					done = true;
+				}
+			}
+
+			for (int t = 0; t < ticks; t++)
+			{
+				previousState = currentState;
+				update();			// update variables
+				currentState = captureState();
+			}
+			interpolateState(alpha);
+
+			fps.update();
 			display();				// Draw The Scene
-			update();				// update variables
 			//updateAnim(delta_time);
 			SwapBuffers(hDC);		// Swap Buffers (Double Buffering)
 		}
@@ -789,6 +869,13 @@ int WINAPI WinMain(	HINSTANCE	hInstance,			// Instance
 		//elapsed_time_prev = elapsed_time;
 	}
 
+	cout << " Game ended after " << game.timings.ticks << " ticks, state hash " << hex << game.stateHash() << dec << endl;
+
+	if (!recordPath.empty() && !recording.save(recordPath.c_str()))
+		cout << "failed to save recording " << recordPath << endl;
+	if (!tracePath.empty() && !game.timings.saveTrace(tracePath.c_str()))
+		cout << "failed to save trace " << tracePath << endl;
+
 	// Shutdown
 	KillGLWindow();									// Kill The Window
 	return (int)(msg.wParam);						// Exit The Program
@@ -1,5 +1,7 @@
 #include "tube.h"
-#include <shaders\Shader.h>
+#include "Utilities/IntersectionTests.h"
+
+#include <cmath>
 
 Tube::Tube() {}
 
@@ -42,6 +44,10 @@ void Tube::constructGeometry(float radiusOfSegments, unsigned int edgeLength, un
 	getTriangleVerts(numberOfVertexesOfOneSegment);
 	getTriangleNormals(numberOfVertexesOfOneSegment);
 	calcBoundingBoxs(numberOfVertexesOfOneSegment);
+	path.build(flake.verts);
+
+	hierarchy.build(*this, radiusOfSegments);
+	multiResolution.build(*this);
 }
 
 // adds a segment for the tube
@@ -96,16 +102,6 @@ void Tube::addSegment(float r, const glm::vec3& center, float angle,  const glm:
 	}
 }
 
-void checkGLErrors()
-{
-	auto errorCode = GL_NO_ERROR;
-	while ((errorCode = glGetError()) != GL_NO_ERROR)
-	{
-		auto error = gluErrorString(errorCode);
-		std::cout << error << std::endl;
-	}
-}
-
 // returns an oriented angle between two vectors, when 3 points are given as parameters
 float Tube::getAngle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
 {
@@ -135,77 +131,6 @@ float Tube::getAngleForSegmentPositioning(const glm::vec3& a, const glm::vec3& b
 }
 
 
-void Tube::createBuffers(Shader* myShader)
-{
-	checkGLErrors();
-
-	// VAO allocation
-	glGenVertexArrays(1, &m_vaoID);
-
-	// First VAO setup
-	glBindVertexArray(m_vaoID);
-
-	glGenBuffers(2, m_vboID);
-
-	float* v = new float[verts.size() * 3];
-	for (int i = 0; i < verts.size(); i++)
-	{
-		v[i * 3] = verts[i].x;
-		v[i * 3+1] = verts[i].y;
-		v[i * 3+2] = verts[i].z;
-	}
-	glBindBuffer(GL_ARRAY_BUFFER, m_vboID[0]);
-	//initialises data storage of vertex buffer object
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * 3 * sizeof(GLfloat), v, GL_STATIC_DRAW);
-	GLint vertexLocation = glGetAttribLocation(myShader->handle(), "in_Position");
-	glVertexAttribPointer(vertexLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(vertexLocation);
-
-
-	float* c = new float[cols.size() * 3];
-	for (int i = 0; i < cols.size(); i++)
-	{
-		c[i * 3] = cols[i].x;
-		c[i * 3 + 1] = cols[i].y;
-		c[i * 3 + 2] = cols[i].z;
-	}
-	glBindBuffer(GL_ARRAY_BUFFER, m_vboID[1]);
-	glBufferData(GL_ARRAY_BUFFER, cols.size() * 3 * sizeof(GLfloat), c, GL_STATIC_DRAW);
-	GLint colsLocation = glGetAttribLocation(myShader->handle(), "in_Color");
-	glVertexAttribPointer(colsLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(colsLocation);
-	
-	delete[] v;
-	delete[] c;
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	glGenBuffers(1, &ibo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, tris.size() * sizeof(unsigned int), &tris[0], GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-	glEnableVertexAttribArray(0);
-
-	glBindVertexArray(0);
-	glUseProgram(0); //turn off the current shader
-
-	checkGLErrors();
-}
-
-void Tube::render()
-{
-	//draw objects
-	glBindVertexArray(m_vaoID);		// select VAO
-
-	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glDrawElements(GL_TRIANGLE_STRIP, tris.size(), GL_UNSIGNED_INT, 0);
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-	glBindVertexArray(0); //unbind the vertex array object
-	glUseProgram(0); //turn off the current shader
-}
-
 void Tube::getTriangleVerts(unsigned int numberOfVertexesOfOneSegment)
 {
 	int numberOfVertexesInTrisInSegment = numberOfVertexesOfOneSegment * 2 + 2;
@@ -355,7 +280,7 @@ std::vector<unsigned int> Tube::triaglesToCheck(glm::vec3& point, int BBlimitF,
 }
 
 
-bool Tube::BarycentricCalculation(glm::vec3& point, float dist, int i)
+bool Tube::BarycentricCalculation(const glm::vec3& point, float dist, int i) const
 {
 	glm::vec3 P = point - norms[i] * dist;
 
@@ -383,6 +308,60 @@ bool Tube::BarycentricCalculation(glm::vec3& point, float dist, int i)
 		return false;
 }
 
+bool Tube::pointCollision(const glm::vec3& point, float threshold) const
+{
+	return multiResolution.pointCollision(point, threshold);
+}
+
+bool Tube::sphereCollision(const glm::vec3& center, float radius) const
+{
+	return hierarchy.sphereCollision(center, radius);
+}
+
+bool Tube::sweptCollision(const glm::vec3& start, const glm::vec3& end, float& timeOfImpact) const
+{
+	return hierarchy.segmentCollision(start, end, timeOfImpact);
+}
+
+bool Tube::rayCast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+	float timeOfImpact;
+
+	// most rays hit the wall within a few radii, and a short segment keeps the hierarchy search near the origin
+	float shortLength = Radius * 8.0f;
+	if (shortLength < maxRayLength && sweptCollision(origin, origin + direction * shortLength, timeOfImpact))
+	{
+		distance = timeOfImpact * shortLength;
+		return true;
+	}
+
+	if (sweptCollision(origin, origin + direction * maxRayLength, timeOfImpact))
+	{
+		distance = timeOfImpact * maxRayLength;
+		return true;
+	}
+
+	distance = maxRayLength;
+	return false;
+}
+
+bool Tube::RayTriangleCalculation(const glm::vec3& origin, const glm::vec3& direction, int i, float& t) const
+{
+	float u, v;
+
+	return IntersectionTests::rayTriangleIntersect(&origin[0], &direction[0], &verts[triangles[i].x][0], &verts[triangles[i].y][0], &verts[triangles[i].z][0], t, u, v);
+}
+
+float Tube::getRadius() const
+{
+	return Radius;
+}
+
+float Tube::getMaxPositionError() const
+{
+	return Radius * 0.001f;
+}
+
 void Tube::calcBoundingBoxs(unsigned int numberOfVertexesOfOneSegment)
 {
 	getTriangleSets(numberOfVertexesOfOneSegment);
@@ -460,6 +439,17 @@ void Tube::calcBoundingBoxs(unsigned int numberOfVertexesOfOneSegment)
 
 		boundingBoxes.push_back(boundingBox);
 	}
+
+	glm::vec3 tubeMin = boundingBoxes[0][0];
+	glm::vec3 tubeMax = boundingBoxes[0][1];
+
+	for (int i = 1; i < boundingBoxes.size(); i++)
+	{
+		tubeMin = glm::min(tubeMin, boundingBoxes[i][0]);
+		tubeMax = glm::max(tubeMax, boundingBoxes[i][1]);
+	}
+
+	maxRayLength = glm::length(tubeMax - tubeMin);
 }
 
 void Tube::getTriangleSets(unsigned int numberOfVertexesOfOneSegment)
@@ -481,136 +471,75 @@ void Tube::getTriangleSets(unsigned int numberOfVertexesOfOneSegment)
 
 void Tube::playerPosition(glm::vec3& point, glm::vec3& camTagret, glm::mat4& directionMat, glm::mat4& turnMat, float speed, float Zturn)
 {	
-	glm::vec3 A = flake.verts[first];
-	glm::vec3 B, C, Z;
-	glm::vec3 P = point;
-	glm::quat q_S;
-
-	if (first == 0)
-	{
-		Z = flake.verts[flake.verts.size() - 1];
-	}
-	else
-	{
-		Z = flake.verts[first - 1];
-	}
-
-	if (first + 1 >= flake.verts.size())
-	{
-		B = flake.verts[0];
-		C = flake.verts[1];
-	}
-	else if (first + 2 >= flake.verts.size())
-	{
-		B = flake.verts[first + 1];
-		C = flake.verts[0];
-	}
-	else
-	{
-		B = flake.verts[first + 1];
-		C = flake.verts[first + 2];
-	}
+	int n = path.getSegmentCount();
+	glm::vec3 tangent;
 
-	glm::vec3 ZA = A - Z;
-	glm::vec3 AB = B - A;
-	glm::vec3 AP = P - A;
-	glm::vec3 PB = B - P;
-	glm::vec3 BC = C - B;
+	// the camera looks at the point the player is leaving
+	path.evaluate(travelled, first, camTagret, tangent);
 
-	glm::vec3 P_proj = A + glm::dot(AP, AB) / glm::dot(AB, AB) * AB;
+	const glm::quat& now = path.segmentOrientation(first);
+	const glm::quat& previous = path.segmentOrientation((first + n - 1) % n);
+	const glm::quat& next = path.segmentOrientation((first + 1) % n);
 
-	glm::vec3 nowDirection = glm::normalize(AB);
-	glm::vec3 nextDirection = glm::normalize(BC);
-	glm::vec3 previousDirection = glm::normalize(ZA);
+	float AP = travelled - path.segmentStart(first);
+	float PB = path.segmentLength(first) - AP;
+	float halfBase = 0.5f * base;
 
 	glm::quat q_turn = glm::angleAxis(Zturn, glm::vec3(0.0, 0.0, -1.0));
 	turnMat = turnMat * glm::toMat4(q_turn);
 
-	if (glm::length(AP) > glm::length(AB))
+	if (AP < halfBase)
 	{
-		first++;
-		if (first == flake.verts.size())
-		{
-			first = 0;
-		}
+		// inside half a base of a corner the orientation is blended with the neighbouring segment
+		directionMat = glm::toMat4(glm::slerp(previous, now, AP / base + 0.5f)) * turnMat;
 	}
-	else 
+	else if (PB < halfBase)
 	{
-		float angle_now = -glm::degrees(glm::acos(glm::dot(nowDirection, glm::vec3(0.0, 0.0, -1.0))));
-		glm::vec3 q_now_axis = glm::normalize(glm::cross(nowDirection, glm::vec3(0.0, 0.0, -1.0)));
-		glm::quat q_now = glm::angleAxis(angle_now, q_now_axis);
-
-		float angle_previous = -glm::degrees(glm::acos(glm::dot(previousDirection, glm::vec3(0.0, 0.0, -1.0))));
-		glm::vec3 q_previous_axis = glm::normalize(glm::cross(previousDirection, glm::vec3(0.0, 0.0, -1.0)));
-		glm::quat q_previous = glm::angleAxis(angle_previous, q_previous_axis);
-
-		float angle_next = -glm::degrees(glm::acos(glm::dot(nextDirection, glm::vec3(0.0, 0.0, -1.0))));
-		glm::vec3 q_next_axis = glm::normalize(glm::cross(nextDirection, glm::vec3(0.0, 0.0, -1.0)));
-		glm::quat q_next = glm::angleAxis(angle_next, q_next_axis);
-
-		float alpha1 = glm::length(AP) / base + 0.5;
-		float alpha2 = glm::length(PB) / base + 0.5;
-
-		if (alpha1 < 1.0f)
-		{
-			q_S = glm::slerp(q_previous, q_now, alpha1);
-
-			directionMat = glm::toMat4(q_S) * turnMat;
-		}
-		else if (alpha2 < 1.0f)
-		{
-			q_S = glm::slerp(q_next, q_now, alpha2);
-
-			directionMat = glm::toMat4(q_S) * turnMat;
-		}
-		else
-		{
-			directionMat = glm::toMat4(q_now) * turnMat;
-		}
+		directionMat = glm::toMat4(glm::slerp(next, now, PB / base + 0.5f)) * turnMat;
+	}
+	else
+	{
+		directionMat = glm::toMat4(now) * turnMat;
 	}
 
-	camTagret = P_proj;
+	travelled = path.wrap(travelled + speed);
 
-	point += speed * nowDirection;
+	int segment = first;
+	path.evaluate(travelled, segment, point, tangent);
 }
 
-void Tube::obstaclePositions(float partLength, std::vector<glm::vec3>& obstaclePoints, std::vector<glm::vec3>& obstacleDirections, std::vector<float>& obstacleRotationS)
+void Tube::obstaclePositions(float partLength, std::mt19937& rng, std::vector<glm::vec3>& obstaclePoints, std::vector<glm::vec3>& obstacleDirections, std::vector<float>& obstacleRotationS, std::vector<float>& obstacleDistances)
 {
-	for (int i = 0; i < flake.verts.size(); i++)
+	std::vector<float> distances;
+
+	for (int i = 0; i < path.getSegmentCount(); i++)
 	{
-		glm::vec3 A = flake.verts[i];
-		glm::vec3 B;
-		if (i + 1 == flake.verts.size())
-		{
-			B = flake.verts[0];
-		}
-		else
-		{
-			B = flake.verts[i + 1];
-		}
-		glm::vec3 AB = B - A;
+		float length = path.segmentLength(i);
 
-		if (glm::length(AB) > base + 0.5f)
+		if (length > base + 0.5f)
 		{
-			glm::vec3 Direction = glm::normalize(AB);
-
-			for (float AM = partLength; AM < glm::length(AB); AM = AM + partLength)
+			for (float AM = partLength; AM < length; AM = AM + partLength)
 			{
-				float MB = glm::length(AB) - AM;
-				float deltaAB = AM / MB;
-				float xM = (A.x + deltaAB * B.x) / (1 + deltaAB);
-				float yM = (A.y + deltaAB * B.y) / (1 + deltaAB);
-				float zM = (A.z + deltaAB * B.z) / (1 + deltaAB);
-				glm::vec3 M (xM, yM, zM);
-				float rot_speed = rand() % 10 + 4;
+				float rot_speed = rng() % 10 + 4;
 				rot_speed = rot_speed / 10;
-				int sign = rand() % 2;
+				int sign = rng() % 2;
 				if (sign == 1) rot_speed = -rot_speed;
-				obstaclePoints.push_back(M);
-				obstacleDirections.push_back(Direction);
+				distances.push_back(path.segmentStart(i) + AM);
 				obstacleRotationS.push_back(rot_speed);
-
 			}
 		}
 	}
+
+	// the distances are ascending, so the whole set is placed in one walk along the path
+	std::vector<glm::vec3> points, directions;
+	path.evaluate(distances, points, directions);
+
+	obstaclePoints.insert(obstaclePoints.end(), points.begin(), points.end());
+	obstacleDirections.insert(obstacleDirections.end(), directions.begin(), directions.end());
+	obstacleDistances.insert(obstacleDistances.end(), distances.begin(), distances.end());
+}
+
+float Tube::getTravelled() const
+{
+	return travelled;
 }
\ No newline at end of file
@@ -3,14 +3,16 @@
 #ifndef _TUBE_H
 #define _TUBE_H
 
-#include <gl\glew.h>
 #include "kochSnowflake.h"
+#include "Collision/KochHierarchy.h"
+#include "Collision/MultiResolutionCollision.h"
+#include "Path/ArcLengthPath.h"
 
-#include <glm\glm.hpp>
-#include <glm\gtc\matrix_transform.hpp>
-#include <glm\gtc\type_ptr.hpp>
-#include <glm\gtc\matrix_inverse.hpp>
-#include <glm\gtx\vector_angle.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtx/vector_angle.hpp>
 
 #include <vector>
 #include <random>
@@ -22,18 +24,25 @@ class Tube
 private:
 
 	unsigned int m_vaoID;		     // vertex array object
-	unsigned int m_vboID[2];		 // two VBOs - used for colours and vertex data
-	GLuint ibo;                      //identifier for the triangle indices
+	unsigned int m_vboID[2];		 // two VBOs - used for colours and vertex data, the colours only when they differ
+	unsigned int ibo;                //identifier for the triangle indices
 
 	std::vector<glm::vec3> cols;	 // color values 
+	int constantColourLocation = -1;	// in_Color when all cols are the same, set before each draw instead of a buffer
+	glm::vec3 constantColour;
 	std::vector<glm::vec3> normal;   //vertex normals
-	int first = 0;
+	int first = 0;					// segment of the player, the hint for the path lookups
+	float travelled = 0.0f;			// distance of the player along the path
 	int Radius;
 	float base;
+	float maxRayLength = 0.0f;			// diagonal of the box around the whole tube
 
 public:
 
 	KochSnowflake flake;			 // koch snowflake 
+	KochHierarchy hierarchy;		 // bounding hierarchy following the recursion of the flake
+	MultiResolutionCollision multiResolution; // coarse-to-fine point tests on top of the hierarchy
+	ArcLengthPath path;				 // the flake verts parameterised by distance, with the orientation of every segment
 
 	float const Pi = 3.14159265359f;
 	//convertion from degree to radians
@@ -65,18 +74,42 @@ public:
 	// positioned on the point B.
 	float getAngleForSegmentPositioning(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
 
-	void Tube::getTriangleVerts(unsigned int numberOfVertexesOfOneSegment);
-	void Tube::getTriangleNormals(unsigned int numberOfVertexesOfOneSegment);
-	bool Tube::collisionBetweenPoint(glm::vec3& v, float threshold, int BBlimitF, int BBlimitL);
-	std::vector<unsigned int> Tube::triaglesToCheck(glm::vec3& point, int BBlimitF, int BBlimitL);
-	bool Tube::BarycentricCalculation(glm::vec3& point, float dist, int i);
-
-	void Tube::calcBoundingBoxs(unsigned int numberOfVertexesOfOneSegment);
-	void Tube::getTriangleSets(unsigned int numberOfVertexesOfOneSegment);
-
-	void Tube::playerPosition(glm::vec3& position, glm::vec3& direction, glm::mat4& directionMat, glm::mat4& turnMat, float speed, float Zturn);
-
-	void Tube::obstaclePositions(float partLength, std::vector<glm::vec3>& obstaclePoints, std::vector<glm::vec3>& obstacleDirections, std::vector<float>& obstacleRotationS);
+	void getTriangleVerts(unsigned int numberOfVertexesOfOneSegment);
+	void getTriangleNormals(unsigned int numberOfVertexesOfOneSegment);
+	bool collisionBetweenPoint(glm::vec3& v, float threshold, int BBlimitF, int BBlimitL);
+	std::vector<unsigned int> triaglesToCheck(glm::vec3& point, int BBlimitF, int BBlimitL);
+	bool BarycentricCalculation(const glm::vec3& point, float dist, int i) const;
+
+	// true when the point is closer than threshold to any triangle of the tube, unlike collisionBetweenPoint it is not
+	// limited to the boxes around the point and returns true on a collision
+	bool pointCollision(const glm::vec3& point, float threshold) const;
+	// true when the sphere touches any triangle of the tube
+	bool sphereCollision(const glm::vec3& center, float radius) const;
+
+	// sweeps a point from start to end against the tube triangles. Returns true on a hit, timeOfImpact is the
+	// fraction (0..1) of the way from start to end where the first triangle is crossed.
+	bool sweptCollision(const glm::vec3& start, const glm::vec3& end, float& timeOfImpact) const;
+	bool RayTriangleCalculation(const glm::vec3& origin, const glm::vec3& direction, int i, float& t) const;
+	// casts a ray (direction must be normalised) against the whole tube, distance is measured from the origin
+	bool rayCast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+	float getRadius() const;
+	// the most createBuffers lets a drawn position move when it packs the vertices
+	float getMaxPositionError() const;
+
+	void calcBoundingBoxs(unsigned int numberOfVertexesOfOneSegment);
+	void getTriangleSets(unsigned int numberOfVertexesOfOneSegment);
+
+	// moves the player speed units along the path, the point is placed on the path so the speed is not limited by the
+	// length of the segments
+	void playerPosition(glm::vec3& position, glm::vec3& direction, glm::mat4& directionMat, glm::mat4& turnMat, float speed, float Zturn);
+
+	// places obstacles every partLength along the long segments, their spin speeds come from rng so a seed gives the same game.
+	// obstacleDistances gets the distance of each along the path.
+	void obstaclePositions(float partLength, std::mt19937& rng, std::vector<glm::vec3>& obstaclePoints, std::vector<glm::vec3>& obstacleDirections, std::vector<float>& obstacleRotationS, std::vector<float>& obstacleDistances);
+
+	// distance of the player along the path
+	float getTravelled() const;
 };
 
-#endif _TUBE_H
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <gl\glew.h>
+#include "tube.h"
+#include <shaders\Shader.h>
+#include "Utilities/VertexPacking.h"
+
+#include <iostream>
+
+void checkGLErrors()
+{
+	auto errorCode = GL_NO_ERROR;
+	while ((errorCode = glGetError()) != GL_NO_ERROR)
+	{
+		auto error = gluErrorString(errorCode);
+		std::cout << error << std::endl;
+	}
+}
+
+void Tube::createBuffers(Shader* myShader)
+{
+	checkGLErrors();
+
+	// VAO allocation
+	glGenVertexArrays(1, &m_vaoID);
+
+	// First VAO setup
+	glBindVertexArray(m_vaoID);
+
+	glGenBuffers(2, m_vboID);
+
+	// the positions packed in the bounds of the tube when that moves them less than getMaxPositionError
+	PackedVertexLayout layout = VertexPacking::chooseLayout(&verts[0][0], NULL, verts.size(), false, getMaxPositionError());
+	std::vector<unsigned char> v;
+	VertexPacking::pack(layout, &verts[0][0], NULL, NULL, verts.size(), v);
+	std::cout << " tube vertices, " << layout.stride << " bytes per vertex" << std::endl;
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vboID[0]);
+	//initialises data storage of vertex buffer object
+	glBufferData(GL_ARRAY_BUFFER, v.size(), &v[0], GL_STATIC_DRAW);
+	GLint vertexLocation = glGetAttribLocation(myShader->handle(), "in_Position");
+	glVertexAttribPointer(vertexLocation, 3, layout.quantizedPositions ? GL_SHORT : GL_FLOAT, GL_FALSE, layout.stride, 0);
+	glEnableVertexAttribArray(vertexLocation);
+
+	glUseProgram(myShader->handle());
+	glUniform3fv(glGetUniformLocation(myShader->handle(), "PositionScale"), 1, layout.positionScale);
+	glUniform3fv(glGetUniformLocation(myShader->handle(), "PositionOffset"), 1, layout.positionOffset);
+
+
+	// one colour for the whole tube is a constant attribute instead of a buffer
+	bool oneColour = true;
+	for (int i = 1; i < cols.size(); i++)
+		oneColour = oneColour && cols[i] == cols[0];
+
+	GLint colsLocation = glGetAttribLocation(myShader->handle(), "in_Color");
+	if (oneColour)
+	{
+		constantColourLocation = colsLocation;
+		constantColour = cols.empty() ? glm::vec3(0.0f) : cols[0];
+		glDisableVertexAttribArray(colsLocation);
+	}
+	else
+	{
+		float* c = new float[cols.size() * 3];
+		for (int i = 0; i < cols.size(); i++)
+		{
+			c[i * 3] = cols[i].x;
+			c[i * 3 + 1] = cols[i].y;
+			c[i * 3 + 2] = cols[i].z;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, m_vboID[1]);
+		glBufferData(GL_ARRAY_BUFFER, cols.size() * 3 * sizeof(GLfloat), c, GL_STATIC_DRAW);
+		glVertexAttribPointer(colsLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
+		glEnableVertexAttribArray(colsLocation);
+		delete[] c;
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, tris.size() * sizeof(unsigned int), &tris[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(0);
+	glUseProgram(0); //turn off the current shader
+
+	checkGLErrors();
+}
+
+void Tube::render()
+{
+	//draw objects
+	glBindVertexArray(m_vaoID);		// select VAO
+	if (constantColourLocation >= 0)
+		glVertexAttrib3f(constantColourLocation, constantColour.x, constantColour.y, constantColour.z);
+
+	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	glDrawElements(GL_TRIANGLE_STRIP, tris.size(), GL_UNSIGNED_INT, 0);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	glBindVertexArray(0); //unbind the vertex array object
+	glUseProgram(0); //turn off the current shader
+}